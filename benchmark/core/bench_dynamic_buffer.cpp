@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <benchmark/benchmark.h>
+
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/dynamic_buffer.hpp>
+
+#include <cstring>
+#include <vector>
+
+using namespace fitoria;
+
+namespace {
+
+// `std::vector<std::byte>` zero-fills on `resize()`, `bytes` does not.
+using zero_fill_bytes = std::vector<std::byte>;
+
+constexpr std::size_t read_size = 65536;
+
+// Simulates `async_message_parser_stream`: every read prepares 64 KiB in a
+// fresh buffer, but the socket only delivers `range(0)` bytes of it.
+template <typename Container>
+void parser_read(benchmark::State& state)
+{
+  const auto received = static_cast<std::size_t>(state.range(0));
+  const auto payload = std::vector<std::byte>(received, std::byte(0x5a));
+
+  for (auto _ : state) {
+    auto buffer = dynamic_buffer<Container>();
+    auto writable = buffer.prepare(read_size);
+    std::memcpy(writable.data(), payload.data(), received);
+    buffer.commit(received);
+    auto chunk = buffer.release();
+    benchmark::DoNotOptimize(chunk.data());
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations())
+                          * static_cast<std::int64_t>(received));
+}
+
+// Simulates `async_read_until_eof` accumulating a large upload 64 KiB at a
+// time.
+template <typename Container>
+void large_upload(benchmark::State& state)
+{
+  const auto total = static_cast<std::size_t>(state.range(0));
+  const auto payload = std::vector<std::byte>(read_size, std::byte(0x5a));
+
+  for (auto _ : state) {
+    auto buffer = dynamic_buffer<Container>();
+    for (std::size_t offset = 0; offset < total; offset += read_size) {
+      auto writable = buffer.prepare(read_size);
+      std::memcpy(writable.data(), payload.data(), read_size);
+      buffer.commit(read_size);
+    }
+    auto body = buffer.release();
+    benchmark::DoNotOptimize(body.data());
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations())
+                          * static_cast<std::int64_t>(total));
+}
+
+}
+
+BENCHMARK(parser_read<zero_fill_bytes>)->Arg(1460)->Arg(16384)->Arg(65536);
+BENCHMARK(parser_read<bytes>)->Arg(1460)->Arg(16384)->Arg(65536);
+
+BENCHMARK(large_upload<zero_fill_bytes>)->Arg(1 << 20)->Arg(16 << 20);
+BENCHMARK(large_upload<bytes>)->Arg(1 << 20)->Arg(16 << 20);
@@ -11,12 +11,14 @@
 
 #include <fitoria/core/config.hpp>
 
+#include <fitoria/core/default_init_allocator.hpp>
+
 #include <cstddef>
 #include <vector>
 
 FITORIA_NAMESPACE_BEGIN
 
-using bytes = std::vector<std::byte>;
+using bytes = std::vector<std::byte, default_init_allocator<std::byte>>;
 
 FITORIA_NAMESPACE_END
 
@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_CORE_DEFAULT_INIT_ALLOCATOR_HPP
+#define FITORIA_CORE_DEFAULT_INIT_ALLOCATOR_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <memory>
+#include <new>
+#include <type_traits>
+
+FITORIA_NAMESPACE_BEGIN
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// An allocator adapter that default-initializes elements instead of
+/// value-initializing them.
+///
+/// DESCRIPTION
+///   An allocator adapter that default-initializes elements instead of
+///   value-initializing them. Containers using this allocator (e.g.
+///   ``std::vector<std::byte, default_init_allocator<std::byte>>``) leave the
+///   newly grown elements uninitialized on ``resize(n)``, which avoids zero
+///   filling buffers that are going to be overwritten anyway.
+///
+/// @endverbatim
+template <typename T, typename Allocator = std::allocator<T>>
+class default_init_allocator : public Allocator {
+  using traits = std::allocator_traits<Allocator>;
+
+public:
+  template <typename U>
+  struct rebind {
+    using other
+        = default_init_allocator<U, typename traits::template rebind_alloc<U>>;
+  };
+
+  default_init_allocator() = default;
+
+  template <typename U>
+  default_init_allocator(
+      const default_init_allocator<U,
+                                   typename traits::template rebind_alloc<U>>&
+          other) noexcept
+      : Allocator(other)
+  {
+  }
+
+  template <typename U>
+  void construct(U* ptr) noexcept(std::is_nothrow_default_constructible_v<U>)
+  {
+    ::new (static_cast<void*>(ptr)) U;
+  }
+
+  template <typename U, typename... Args>
+  void construct(U* ptr, Args&&... args)
+  {
+    traits::construct(
+        static_cast<Allocator&>(*this), ptr, std::forward<Args>(args)...);
+  }
+};
+
+FITORIA_NAMESPACE_END
+
+#endif
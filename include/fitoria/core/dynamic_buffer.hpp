@@ -11,8 +11,12 @@
 
 #include <fitoria/core/config.hpp>
 
+#include <fitoria/core/default_init_allocator.hpp>
 #include <fitoria/core/net.hpp>
+#include <fitoria/core/type_traits.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <iterator>
 
 FITORIA_NAMESPACE_BEGIN
@@ -27,6 +31,11 @@ FITORIA_NAMESPACE_BEGIN
 ///   ``net::DynamicBuffer`` concept. Note that ``Container`` must use
 ///   contiguous storage.
 ///
+///   Growing the writable bytes does not zero-fill them if ``Container`` is
+///   able to grow without value-initialization, e.g. ``bytes`` (which uses
+///   ``default_init_allocator``) or ``std::basic_string`` with
+///   ``resize_and_overwrite`` support.
+///
 ///   .. code-block::
 ///
 ///                    readable    writable
@@ -129,7 +138,7 @@ public:
   auto prepare(std::size_t n) -> mutable_buffers_type
   {
     if (n <= (limit_ - woffset_)) {
-      container_.resize(woffset_ + n);
+      grow(woffset_ + n);
     } else if (n <= (limit_ - size())) {
       compress();
     } else {
@@ -140,6 +149,24 @@ public:
     return { container_.data() + woffset_, n };
   }
 
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Request the capacity to be at least ``n`` bytes.
+  ///
+  /// DESCRIPTION
+  ///   Request the capacity to be at least ``n`` bytes, so that subsequent
+  ///   ``prepare()`` calls do not reallocate until the capacity is exhausted.
+  ///   The request is bounded by ``max_size()``.
+  ///
+  /// @endverbatim
+  void reserve(std::size_t n)
+  {
+    if (const auto capacity = std::min(n, limit_);
+        capacity > container_.capacity()) {
+      reallocate(capacity);
+    }
+  }
+
   /// @verbatim embed:rst:leading-slashes
   ///
   /// Convert writable bytes into readable bytes.
@@ -197,6 +224,48 @@ public:
   }
 
 private:
+  static constexpr bool is_default_init
+      = is_specialization_of_v<typename Container::allocator_type,
+                               default_init_allocator>;
+
+  void grow(std::size_t size)
+  {
+    if constexpr (is_default_init) {
+      if (size > container_.capacity()) {
+        reallocate(std::max(size, std::min(container_.capacity() * 2, limit_)));
+      }
+    }
+
+#if defined(__cpp_lib_string_resize_and_overwrite)
+    if constexpr (requires {
+                    container_.resize_and_overwrite(
+                        size, [](auto*, std::size_t n) { return n; });
+                  }) {
+      // writable bytes are going to be overwritten, skip the zero-filling
+      container_.resize_and_overwrite(size,
+                                      [](auto*, std::size_t n) { return n; });
+      return;
+    }
+#endif
+
+    container_.resize(size);
+  }
+
+  void reallocate(std::size_t capacity)
+  {
+    if constexpr (is_default_init) {
+      // ``std::vector`` relocates element by element for non-``std``
+      // allocators, relocate by ``std::memcpy`` instead
+      auto container = Container();
+      container.reserve(capacity);
+      container.resize(woffset_);
+      std::memcpy(container.data(), container_.data(), woffset_);
+      container_ = std::move(container);
+    } else {
+      container_.reserve(capacity);
+    }
+  }
+
   void compress()
   {
     if (roffset_ > 0) {
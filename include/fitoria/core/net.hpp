@@ -327,6 +327,7 @@ using websocket_stream = boost::beast::websocket::stream<NextLayer>;
 
 #if defined(BOOST_ASIO_HAS_FILE)
 using stream_file = boost::asio::basic_stream_file<executor_type>;
+using random_access_file = boost::asio::basic_random_access_file<executor_type>;
 #endif
 
 using boost::beast::flat_buffer;
@@ -11,6 +11,7 @@
 
 #include <fitoria/core/config.hpp>
 
+#include <fitoria/http/header/accept_encoding.hpp>
 #include <fitoria/http/header/date.hpp>
 #include <fitoria/http/header/entity_tag.hpp>
 #include <fitoria/http/header/if_none_match.hpp>
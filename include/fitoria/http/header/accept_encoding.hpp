@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_HTTP_HEADER_ACCEPT_ENCODING_HPP
+#define FITORIA_HTTP_HEADER_ACCEPT_ENCODING_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/optional.hpp>
+#include <fitoria/core/strings.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace http::header {
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// Provides parsing for dealing with HTTP header ``Accept-Encoding``.
+///
+/// DESCRIPTION
+///   Provides parsing for dealing with HTTP header ``Accept-Encoding``.
+///   Qualities are represented as integers in thousandths, i.e. ``q=0.5`` is
+///   ``500``.
+///
+/// @endverbatim
+class accept_encoding {
+public:
+  struct coding_t {
+    std::string coding;
+    std::uint16_t quality;
+
+    friend bool operator==(const coding_t&, const coding_t&) = default;
+  };
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Constructor.
+  ///
+  /// @endverbatim
+  explicit accept_encoding(std::vector<coding_t> codings)
+      : codings_(std::move(codings))
+  {
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the content codings.
+  ///
+  /// @endverbatim
+  auto codings() const noexcept -> const std::vector<coding_t>&
+  {
+    return codings_;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the quality of the content coding.
+  ///
+  /// DESCRIPTION
+  ///   Get the quality of the content coding, ``0`` means not acceptable. A
+  ///   coding which is not listed gets the quality of ``*`` if there is one.
+  ///   Otherwise ``identity`` is acceptable and any other coding is not.
+  ///
+  /// @endverbatim
+  auto quality(std::string_view coding) const noexcept -> std::uint16_t
+  {
+    const coding_t* any = nullptr;
+    for (auto& c : codings_) {
+      if (cmp_eq_ci(c.coding, coding)) {
+        return c.quality;
+      }
+      if (c.coding == "*") {
+        any = &c;
+      }
+    }
+
+    if (any != nullptr) {
+      return any->quality;
+    }
+
+    return cmp_eq_ci(coding, "identity") ? 1000 : 0;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Parse the string to an ``accept_encoding`` instance.
+  ///
+  /// @endverbatim
+  static auto parse(std::string_view input) -> optional<accept_encoding>
+  {
+    // https://datatracker.ietf.org/doc/html/rfc9110#section-12.5.3
+
+    auto codings = std::vector<coding_t>();
+    auto tokens = split_of(input, ",");
+    for (auto& token : tokens) {
+      if (token.empty()) {
+        continue;
+      }
+
+      auto params = split_of(token, ";");
+      if (params[0].empty()) {
+        return nullopt;
+      }
+
+      std::uint16_t quality = 1000;
+      for (std::size_t i = 1; i < params.size(); ++i) {
+        auto kv = split_of(params[i], "=");
+        if (kv.size() != 2) {
+          return nullopt;
+        }
+        if (cmp_eq_ci(kv[0], "q")) {
+          if (auto q = parse_qvalue(kv[1]); q) {
+            quality = *q;
+          } else {
+            return nullopt;
+          }
+        }
+      }
+
+      codings.push_back(coding_t { std::string(params[0]), quality });
+    }
+
+    return accept_encoding(std::move(codings));
+  }
+
+private:
+  static auto parse_qvalue(std::string_view input) -> optional<std::uint16_t>
+  {
+    // qvalue = ( "0" [ "." 0*3DIGIT ] ) / ( "1" [ "." 0*3("0") ] )
+
+    if (input.empty() || (input[0] != '0' && input[0] != '1')) {
+      return nullopt;
+    }
+
+    std::uint16_t value = input[0] == '1' ? 1000 : 0;
+    if (input.size() == 1) {
+      return value;
+    }
+    if (input[1] != '.' || input.size() > 5) {
+      return nullopt;
+    }
+
+    std::uint16_t scale = 100;
+    for (auto c : input.substr(2)) {
+      if (c < '0' || c > '9') {
+        return nullopt;
+      }
+      value += static_cast<std::uint16_t>((c - '0') * scale);
+      scale /= 10;
+    }
+
+    if (value > 1000) {
+      return nullopt;
+    }
+
+    return value;
+  }
+
+  std::vector<coding_t> codings_;
+};
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
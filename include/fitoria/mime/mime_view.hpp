@@ -552,6 +552,19 @@ inline auto image_tiff() noexcept -> mime_view
   return { source, source, source.substr(0, 5), source.substr(6), nullopt, {} };
 }
 
+/// @verbatim embed:rst:leading-slashes
+///
+/// ``"multipart/byteranges"``
+///
+/// @endverbatim
+inline auto multipart_byteranges() noexcept -> mime_view
+{
+  const auto source = std::string_view("multipart/byteranges");
+  return {
+    source, source, source.substr(0, 9), source.substr(10), nullopt, {}
+  };
+}
+
 /// @verbatim embed:rst:leading-slashes
 ///
 /// ``"multipart/form-data"``
@@ -587,6 +600,17 @@ inline auto text_csv() noexcept -> mime_view
   return { source, source, source.substr(0, 4), source.substr(5), nullopt, {} };
 }
 
+/// @verbatim embed:rst:leading-slashes
+///
+/// ``"text/event-stream"``
+///
+/// @endverbatim
+inline auto text_event_stream() noexcept -> mime_view
+{
+  const auto source = std::string_view("text/event-stream");
+  return { source, source, source.substr(0, 4), source.substr(5), nullopt, {} };
+}
+
 /// @verbatim embed:rst:leading-slashes
 ///
 /// ``"text/html"``
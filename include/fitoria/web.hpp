@@ -13,10 +13,14 @@
 
 #include <fitoria/web/any_async_readable_stream.hpp>
 #include <fitoria/web/any_routable.hpp>
+#include <fitoria/web/async_channel_stream.hpp>
 #include <fitoria/web/async_message_parser_stream.hpp>
 #include <fitoria/web/async_read_into_stream_file.hpp>
 #include <fitoria/web/async_read_until_eof.hpp>
 #include <fitoria/web/async_readable_file_stream.hpp>
+#include <fitoria/web/async_readable_mmap_stream.hpp>
+#include <fitoria/web/async_readable_random_access_file_stream.hpp>
+#include <fitoria/web/async_readable_shared_buffer_stream.hpp>
 #include <fitoria/web/async_readable_stream_concept.hpp>
 #include <fitoria/web/async_readable_vector_stream.hpp>
 #include <fitoria/web/async_write_chunks.hpp>
@@ -25,9 +29,15 @@
 #include <fitoria/web/form_of.hpp>
 #include <fitoria/web/http_server.hpp>
 #include <fitoria/web/json_of.hpp>
+#include <fitoria/web/memory_budget.hpp>
+#include <fitoria/web/middleware/compress.hpp>
+#include <fitoria/web/middleware/compress_cache.hpp>
+#include <fitoria/web/middleware/compress_dictionary.hpp>
 #include <fitoria/web/middleware/decompress.hpp>
 #include <fitoria/web/middleware/exception_handler.hpp>
 #include <fitoria/web/middleware/logger.hpp>
+#include <fitoria/web/multipart_of.hpp>
+#include <fitoria/web/open_file_cache.hpp>
 #include <fitoria/web/path_info.hpp>
 #include <fitoria/web/path_of.hpp>
 #include <fitoria/web/query_map.hpp>
@@ -37,9 +47,12 @@
 #include <fitoria/web/route.hpp>
 #include <fitoria/web/router.hpp>
 #include <fitoria/web/scope.hpp>
+#include <fitoria/web/sse.hpp>
 #include <fitoria/web/state_of.hpp>
 #include <fitoria/web/state_storage.hpp>
 #include <fitoria/web/static_file.hpp>
+#include <fitoria/web/static_file_cache.hpp>
+#include <fitoria/web/static_files.hpp>
 #include <fitoria/web/test_request.hpp>
 #include <fitoria/web/test_response.hpp>
 #include <fitoria/web/to_middleware.hpp>
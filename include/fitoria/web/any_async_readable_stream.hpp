@@ -26,6 +26,7 @@ class any_async_readable_stream {
     virtual auto
     async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
         = 0;
+    virtual auto size_hint() const -> optional<std::uint64_t> = 0;
   };
 
   template <typename AsyncReadableStream>
@@ -42,6 +43,16 @@ class any_async_readable_stream {
       return stream_.async_read_some();
     }
 
+    auto size_hint() const -> optional<std::uint64_t> override
+    {
+      return get_size_hint(stream_);
+    }
+
+    auto get() noexcept -> AsyncReadableStream&
+    {
+      return stream_;
+    }
+
   private:
     AsyncReadableStream stream_;
   };
@@ -72,6 +83,31 @@ public:
     return stream_->async_read_some();
   }
 
+  auto size_hint() const -> optional<std::uint64_t>
+  {
+    return stream_->size_hint();
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get a pointer to the underlying stream.
+  ///
+  /// DESCRIPTION
+  ///   Get a pointer to the underlying stream if its type is
+  ///   ``AsyncReadableStream``, otherwise ``nullptr`` is returned.
+  ///
+  /// @endverbatim
+  template <typename AsyncReadableStream>
+  auto target() noexcept -> AsyncReadableStream*
+  {
+    if (auto* d = dynamic_cast<derived<AsyncReadableStream>*>(stream_.get());
+        d) {
+      return &d->get();
+    }
+
+    return nullptr;
+  }
+
 private:
   std::unique_ptr<base> stream_;
 };
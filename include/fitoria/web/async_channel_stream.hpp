@@ -0,0 +1,191 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_ASYNC_CHANNEL_STREAM_HPP
+#define FITORIA_WEB_ASYNC_CHANNEL_STREAM_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/net.hpp>
+#include <fitoria/core/optional.hpp>
+
+#include <fitoria/web/async_readable_stream_concept.hpp>
+
+#include <memory>
+#include <span>
+#include <string_view>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web {
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// An async readable stream fed by one or more writers.
+///
+/// DESCRIPTION
+///   An async readable stream fed by one or more writers. Data sent through
+///   any ``writer`` obtained from ``get_writer()`` is yielded by
+///   ``async_read_some()`` in order. At most ``max_buffer_size`` chunks are
+///   buffered, ``writer::async_send`` suspends until the reader catches up,
+///   which keeps a fast producer from outrunning a slow client. Writers may
+///   run on any executor or thread.
+///
+///   The stream ends after ``writer::close()`` is called or the last writer is
+///   destroyed. Once the stream is destroyed, e.g. the client disconnected,
+///   ``writer::async_send`` fails.
+///
+/// @endverbatim
+class async_channel_stream {
+  using channel_t = net::experimental::concurrent_channel<
+      executor_type,
+      void(boost::system::error_code, bytes)>;
+
+  // closes the channel once the last writer is gone
+  class writer_guard {
+  public:
+    explicit writer_guard(std::shared_ptr<channel_t> channel)
+        : channel_(std::move(channel))
+    {
+    }
+
+    writer_guard(const writer_guard&) = delete;
+
+    writer_guard& operator=(const writer_guard&) = delete;
+
+    ~writer_guard()
+    {
+      channel_->close();
+    }
+
+  private:
+    std::shared_ptr<channel_t> channel_;
+  };
+
+public:
+  using is_async_readable_stream = void;
+
+  class writer {
+    friend class async_channel_stream;
+
+    writer(std::shared_ptr<channel_t> channel,
+           std::shared_ptr<writer_guard> guard)
+        : channel_(std::move(channel))
+        , guard_(std::move(guard))
+    {
+    }
+
+  public:
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Send a chunk of data to the reader.
+    ///
+    /// DESCRIPTION
+    ///   Send a chunk of data to the reader. Suspends while the buffer is full.
+    ///   An error is returned if the stream has been closed or destroyed.
+    ///
+    /// @endverbatim
+    auto async_send(bytes data) -> awaitable<expected<void, std::error_code>>
+    {
+      co_return co_await channel_->async_send(
+          boost::system::error_code(), std::move(data), use_awaitable);
+    }
+
+    auto async_send(std::string_view sv)
+        -> awaitable<expected<void, std::error_code>>
+    {
+      auto data = std::as_bytes(std::span(sv.data(), sv.size()));
+      co_return co_await async_send(bytes(data.begin(), data.end()));
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Close the stream.
+    ///
+    /// DESCRIPTION
+    ///   Close the stream. Chunks already sent are still delivered to the
+    ///   reader before the end of the stream.
+    ///
+    /// @endverbatim
+    void close()
+    {
+      channel_->close();
+    }
+
+  private:
+    std::shared_ptr<channel_t> channel_;
+    std::shared_ptr<writer_guard> guard_;
+  };
+
+  async_channel_stream(const executor_type& ex, std::size_t max_buffer_size)
+      : channel_(std::make_shared<channel_t>(ex, max_buffer_size))
+  {
+  }
+
+  async_channel_stream(const async_channel_stream&) = delete;
+
+  async_channel_stream& operator=(const async_channel_stream&) = delete;
+
+  async_channel_stream(async_channel_stream&&) = default;
+
+  async_channel_stream& operator=(async_channel_stream&&) = default;
+
+  ~async_channel_stream()
+  {
+    if (channel_) {
+      channel_->close();
+    }
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get a writer of the stream.
+  ///
+  /// DESCRIPTION
+  ///   Get a writer of the stream. All writers share the same channel, copies
+  ///   can be handed to multiple producers.
+  ///
+  /// @endverbatim
+  auto get_writer() -> writer
+  {
+    auto guard = guard_.lock();
+    if (!guard) {
+      guard = std::make_shared<writer_guard>(channel_);
+      guard_ = guard;
+    }
+
+    return writer(channel_, std::move(guard));
+  }
+
+  auto
+  async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
+  {
+    auto data = co_await channel_->async_receive(use_awaitable);
+    if (!data) {
+      if (data.error()
+          == make_error_code(net::experimental::error::channel_closed)) {
+        co_return nullopt;
+      }
+      co_return unexpected { data.error() };
+    }
+
+    co_return std::move(*data);
+  }
+
+private:
+  std::shared_ptr<channel_t> channel_;
+  std::weak_ptr<writer_guard> guard_;
+};
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
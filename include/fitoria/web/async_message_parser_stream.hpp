@@ -11,13 +11,14 @@
 
 #include <fitoria/core/config.hpp>
 
-#include <fitoria/core/dynamic_buffer.hpp>
+#include <fitoria/core/bytes.hpp>
 #include <fitoria/core/expected.hpp>
 #include <fitoria/core/net.hpp>
 
 #include <fitoria/http/verb.hpp>
 
 #include <fitoria/web/async_readable_stream_concept.hpp>
+#include <fitoria/web/memory_budget.hpp>
 
 FITORIA_NAMESPACE_BEGIN
 
@@ -32,10 +33,13 @@ public:
 
   async_message_parser_stream(std::shared_ptr<flat_buffer> buffer,
                               Stream stream,
-                              std::shared_ptr<Parser> parser)
+                              std::shared_ptr<Parser> parser,
+                              std::shared_ptr<memory_budget::account> account
+                              = nullptr)
       : buffer_(std::move(buffer))
       , stream_(std::move(stream))
       , parser_(std::move(parser))
+      , account_(std::move(account))
   {
   }
 
@@ -58,37 +62,48 @@ public:
       co_return nullopt;
     }
 
-    dynamic_buffer<bytes> buffer;
-    boost::system::error_code ec;
-    for (auto writable = buffer.prepare(65536);;
-         writable = buffer.prepare(65536)) {
-      parser_->get().body().data = writable.data();
-      parser_->get().body().size = writable.size();
-
-      auto size
-          = co_await async_read(stream_, *buffer_, *parser_, use_awaitable);
-      if (!size && size.error() != boost::beast::http::error::need_buffer) {
-        ec = size.error();
-        break;
-      }
-
-      const auto remaining = parser_->get().body().size;
-      buffer.commit(writable.size() - remaining);
-      if (remaining > 0) {
-        break;
-      }
+    // read a single buffer of the body at a time, so that the consumer sees
+    // the body as it arrives instead of after the whole message is read
+    auto buffer = bytes(static_cast<std::size_t>(
+        std::min<std::uint64_t>(size_hint().value_or(chunk_size), chunk_size)));
+    parser_->get().body().data = buffer.data();
+    parser_->get().body().size = buffer.size();
+
+    // the buffer is only held by the session while it is being filled, the
+    // consumer may spill or drop it once it is handed off
+    if (account_) {
+      account_->charge(buffer.size());
     }
+    auto size = co_await async_read(stream_, *buffer_, *parser_, use_awaitable);
+    if (account_) {
+      account_->credit(buffer.size());
+    }
+    if (!size && size.error() != boost::beast::http::error::need_buffer) {
+      co_return unexpected { size.error() };
+    }
+
+    buffer.resize(buffer.size() - parser_->get().body().size);
+    co_return buffer;
+  }
 
-    if (ec) {
-      co_return unexpected { ec };
+  // the parser rejects a `Content-Length` exceeding the body limit, thus the
+  // hint never exceeds the limit either
+  auto size_hint() const -> optional<std::uint64_t>
+  {
+    if (auto remaining = parser_->content_length_remaining(); remaining) {
+      return *remaining;
     }
-    co_return buffer.release();
+
+    return nullopt;
   }
 
 private:
+  static constexpr std::uint64_t chunk_size = 65536;
+
   std::shared_ptr<flat_buffer> buffer_;
   Stream stream_;
   std::shared_ptr<Parser> parser_;
+  std::shared_ptr<memory_budget::account> account_;
 };
 
 }
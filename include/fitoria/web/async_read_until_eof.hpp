@@ -15,6 +15,9 @@
 
 #include <fitoria/web/async_readable_stream_concept.hpp>
 
+#include <algorithm>
+#include <concepts>
+
 FITORIA_NAMESPACE_BEGIN
 
 namespace web {
@@ -24,11 +27,23 @@ auto async_read_until_eof(AsyncReadableStream&& stream)
     -> awaitable<expected<Container, std::error_code>>
 {
   dynamic_buffer<Container> buffer;
+  const auto hint = get_size_hint(stream).value_or(0);
 
   for (auto data = co_await stream.async_read_some(); data;
        data = co_await stream.async_read_some()) {
     auto& d = *data;
     if (d) {
+      if (buffer.size() == 0) {
+        if constexpr (std::same_as<Container, bytes>) {
+          if (d->size() >= hint) {
+            // the chunk is the whole body, take it over instead of copying
+            buffer = dynamic_buffer<Container>(std::move(*d));
+            continue;
+          }
+        }
+        buffer.reserve(static_cast<std::size_t>(
+            std::min(hint, detail::max_size_hint_reserve)));
+      }
       auto writable = buffer.prepare(d->size());
       std::memcpy(writable.data(), d->data(), d->size());
       buffer.commit(d->size());
@@ -86,6 +86,26 @@ public:
     }
   }
 
+  auto size_hint() const -> optional<std::uint64_t>
+  {
+    return remaining_;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the underlying file.
+  ///
+  /// DESCRIPTION
+  ///   Get the underlying file, e.g. to process its content through the native
+  ///   handle without copying it into memory. Note that reading the file
+  ///   directly also moves the position used by ``async_read_some()``.
+  ///
+  /// @endverbatim
+  auto file() noexcept -> stream_file&
+  {
+    return file_;
+  }
+
 private:
   stream_file file_;
   std::uint64_t offset_;
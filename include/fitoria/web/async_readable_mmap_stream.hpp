@@ -0,0 +1,333 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_ASYNC_READABLE_MMAP_STREAM_HPP
+#define FITORIA_WEB_ASYNC_READABLE_MMAP_STREAM_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/net.hpp>
+#include <fitoria/core/optional.hpp>
+
+#include <fitoria/web/async_readable_stream_concept.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+#if defined(FITORIA_TARGET_WINDOWS)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web {
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// A read-only memory mapping of a file.
+///
+/// DESCRIPTION
+///   A read-only memory mapping of a file, shared by reference counting. The
+///   mapping is advised for sequential access and to be read ahead. Files
+///   must not be truncated while they are mapped, use this for files which
+///   are replaced rather than modified in place.
+///
+/// @endverbatim
+class mapped_file {
+public:
+  mapped_file(const mapped_file&) = delete;
+
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  ~mapped_file()
+  {
+#if defined(FITORIA_TARGET_WINDOWS)
+    if (data_ != nullptr) {
+      ::UnmapViewOfFile(data_);
+    }
+#else
+    if (data_ != nullptr) {
+      ::munmap(data_, size_);
+    }
+#endif
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the mapped content.
+  ///
+  /// @endverbatim
+  auto data() const noexcept -> std::span<const std::byte>
+  {
+    return { static_cast<const std::byte*>(data_), size_ };
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the size of the file.
+  ///
+  /// @endverbatim
+  auto size() const noexcept -> std::uint64_t
+  {
+    return size_;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the last write time of the file when it was mapped.
+  ///
+  /// @endverbatim
+  auto last_write_time() const noexcept -> std::filesystem::file_time_type
+  {
+    return last_write_time_;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Map the file.
+  ///
+  /// DESCRIPTION
+  ///   Map the file. A mapping of the same path which is still referenced is
+  ///   reused if the size and the last write time of the file are unchanged,
+  ///   thus concurrent requests for a file share a single mapping, which is
+  ///   unmapped once the last of them is done.
+  ///
+  /// @endverbatim
+  static auto open(const std::string& path)
+      -> expected<std::shared_ptr<const mapped_file>, std::error_code>
+  {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec) {
+      return unexpected { ec };
+    }
+    const auto lwt = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+      return unexpected { ec };
+    }
+
+    auto& r = registry();
+    {
+      auto lock = std::scoped_lock(r.mutex);
+      if (auto it = r.files.find(path); it != r.files.end()) {
+        if (auto file = it->second.lock();
+            file && file->size_ == size && file->last_write_time_ == lwt) {
+          return file;
+        }
+      }
+    }
+
+    auto file = map(path, lwt);
+    if (!file) {
+      return unexpected { file.error() };
+    }
+
+    auto lock = std::scoped_lock(r.mutex);
+    if (r.files.size() >= r.sweep_at) {
+      std::erase_if(r.files, [](auto& p) { return p.second.expired(); });
+      r.sweep_at = std::max<std::size_t>(r.files.size() * 2, 64);
+    }
+    r.files.insert_or_assign(path, *file);
+
+    return std::shared_ptr<const mapped_file>(std::move(*file));
+  }
+
+private:
+  struct registry_t {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::weak_ptr<const mapped_file>> files;
+    std::size_t sweep_at = 64;
+  };
+
+  mapped_file() = default;
+
+  static auto registry() -> registry_t&
+  {
+    static auto r = registry_t();
+    return r;
+  }
+
+  static auto map(const std::string& path,
+                  std::filesystem::file_time_type lwt)
+      -> expected<std::shared_ptr<mapped_file>, std::error_code>
+  {
+    auto file = std::shared_ptr<mapped_file>(new mapped_file());
+    file->last_write_time_ = lwt;
+
+#if defined(FITORIA_TARGET_WINDOWS)
+    auto handle = ::CreateFileW(std::filesystem::path(path).c_str(),
+                                GENERIC_READ,
+                                FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                nullptr,
+                                OPEN_EXISTING,
+                                FILE_FLAG_SEQUENTIAL_SCAN,
+                                nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+      return unexpected { std::error_code(static_cast<int>(::GetLastError()),
+                                          std::system_category()) };
+    }
+
+    auto size = LARGE_INTEGER();
+    if (!::GetFileSizeEx(handle, &size)) {
+      const auto ec = std::error_code(static_cast<int>(::GetLastError()),
+                                      std::system_category());
+      ::CloseHandle(handle);
+      return unexpected { ec };
+    }
+
+    file->size_ = static_cast<std::uint64_t>(size.QuadPart);
+    if (file->size_ > 0) {
+      auto mapping = ::CreateFileMappingW(
+          handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (mapping != nullptr) {
+        file->data_ = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      }
+      const auto ec = std::error_code(static_cast<int>(::GetLastError()),
+                                      std::system_category());
+      if (mapping != nullptr) {
+        ::CloseHandle(mapping);
+      }
+      if (file->data_ == nullptr) {
+        ::CloseHandle(handle);
+        return unexpected { ec };
+      }
+    }
+    ::CloseHandle(handle);
+#else
+    auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return unexpected { std::error_code(errno, std::system_category()) };
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      const auto ec = std::error_code(errno, std::system_category());
+      ::close(fd);
+      return unexpected { ec };
+    }
+
+    file->size_ = static_cast<std::uint64_t>(st.st_size);
+    if (file->size_ > 0) {
+      auto* data
+          = ::mmap(nullptr, file->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        const auto ec = std::error_code(errno, std::system_category());
+        ::close(fd);
+        return unexpected { ec };
+      }
+      file->data_ = data;
+      // hints only, failures are harmless
+      ::madvise(data, file->size_, MADV_SEQUENTIAL);
+      ::madvise(data, file->size_, MADV_WILLNEED);
+    }
+    ::close(fd);
+#endif
+
+    return file;
+  }
+
+  void* data_ = nullptr;
+  std::uint64_t size_ = 0;
+  std::filesystem::file_time_type last_write_time_;
+};
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// An async readable stream of a range of a ``mapped_file``.
+///
+/// DESCRIPTION
+///   An async readable stream of a range of a ``mapped_file``. Any number of
+///   streams are able to read the same mapping at the same time. When it is
+///   set as a response body of known size, ``http_server`` writes
+///   ``remaining()`` straight from the mapping along with the headers without
+///   copying. Otherwise chunks are copied from the mapping without issuing any
+///   read to the file system.
+///
+/// @endverbatim
+class async_readable_mmap_stream {
+public:
+  using is_async_readable_stream = void;
+
+  async_readable_mmap_stream(std::shared_ptr<const mapped_file> file)
+      : async_readable_mmap_stream(file, 0, file->size())
+  {
+  }
+
+  async_readable_mmap_stream(std::shared_ptr<const mapped_file> file,
+                             std::uint64_t offset,
+                             std::uint64_t size)
+      : file_(std::move(file))
+      , offset_(std::min(offset, file_->size()))
+      , remaining_(std::min(size, file_->size() - offset_))
+  {
+  }
+
+  async_readable_mmap_stream(const async_readable_mmap_stream&) = delete;
+
+  async_readable_mmap_stream&
+  operator=(const async_readable_mmap_stream&) = delete;
+
+  async_readable_mmap_stream(async_readable_mmap_stream&&) = default;
+
+  async_readable_mmap_stream& operator=(async_readable_mmap_stream&&)
+      = default;
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get a view of the part of the range which is not read yet.
+  ///
+  /// @endverbatim
+  auto remaining() const noexcept -> std::span<const std::byte>
+  {
+    return file_->data().subspan(offset_, remaining_);
+  }
+
+  auto
+  async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
+  {
+    if (remaining_ == 0) {
+      co_return nullopt;
+    }
+
+    auto chunk = remaining().first(
+        static_cast<std::size_t>(std::min<std::uint64_t>(remaining_, 65536)));
+    offset_ += chunk.size();
+    remaining_ -= chunk.size();
+    co_return bytes(chunk.begin(), chunk.end());
+  }
+
+  auto size_hint() const -> optional<std::uint64_t>
+  {
+    return remaining_;
+  }
+
+private:
+  std::shared_ptr<const mapped_file> file_;
+  std::uint64_t offset_;
+  std::uint64_t remaining_;
+};
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
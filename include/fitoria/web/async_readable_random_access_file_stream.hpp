@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_ASYNC_READABLE_RANDOM_ACCESS_FILE_STREAM_HPP
+#define FITORIA_WEB_ASYNC_READABLE_RANDOM_ACCESS_FILE_STREAM_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/net.hpp>
+#include <fitoria/core/utility.hpp>
+
+#include <fitoria/web/async_readable_stream_concept.hpp>
+
+#include <algorithm>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web {
+
+#if defined(BOOST_ASIO_HAS_FILE)
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// An async readable stream of a range of a ``random_access_file``.
+///
+/// DESCRIPTION
+///   An async readable stream of a range of a ``random_access_file``. The file
+///   is read with positional reads at the stream's own offset, thus streams
+///   owning duplicates of the same descriptor are able to read the file at the
+///   same time without moving the position of each other.
+///
+/// @endverbatim
+class async_readable_random_access_file_stream {
+public:
+  using is_async_readable_stream = void;
+
+  async_readable_random_access_file_stream(
+      random_access_file file,
+      std::uint64_t offset,
+      std::uint64_t size)
+      : file_(std::move(file))
+      , offset_(offset)
+      , remaining_(size)
+  {
+  }
+
+  async_readable_random_access_file_stream(
+      const async_readable_random_access_file_stream&)
+      = delete;
+
+  async_readable_random_access_file_stream&
+  operator=(const async_readable_random_access_file_stream&) = delete;
+
+  async_readable_random_access_file_stream(
+      async_readable_random_access_file_stream&&)
+      = default;
+
+  async_readable_random_access_file_stream&
+  operator=(async_readable_random_access_file_stream&&) = default;
+
+  auto
+  async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
+  {
+    if (remaining_ == 0) {
+      co_return nullopt;
+    }
+
+    auto buffer = bytes(std::min<std::uint64_t>(remaining_, 65536));
+    if (auto result = co_await file_.async_read_some_at(
+            offset_, net::buffer(buffer), use_awaitable);
+        result) {
+      buffer.resize(*result);
+      offset_ += *result;
+      remaining_ -= *result;
+      co_return buffer;
+    } else if (result.error() == net::error::eof) {
+      co_return nullopt;
+    } else {
+      co_return unexpected { result.error() };
+    }
+  }
+
+  auto size_hint() const -> optional<std::uint64_t>
+  {
+    return remaining_;
+  }
+
+private:
+  random_access_file file_;
+  std::uint64_t offset_;
+  std::uint64_t remaining_;
+};
+
+#endif
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
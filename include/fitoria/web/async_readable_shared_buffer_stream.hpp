@@ -0,0 +1,126 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_ASYNC_READABLE_SHARED_BUFFER_STREAM_HPP
+#define FITORIA_WEB_ASYNC_READABLE_SHARED_BUFFER_STREAM_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/net.hpp>
+#include <fitoria/core/optional.hpp>
+
+#include <fitoria/web/async_readable_stream_concept.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web {
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// An async readable stream of a range of an immutable buffer shared by
+/// reference counting.
+///
+/// DESCRIPTION
+///   An async readable stream of a range of an immutable buffer shared by
+///   reference counting, e.g. a cached body which is sent by many responses at
+///   the same time. Any number of streams are able to read the same buffer at
+///   the same time. When it is set as a response body of known size,
+///   ``http_server`` writes ``remaining()`` straight from the buffer along
+///   with the headers without copying. Otherwise chunks of at most 64 KiB are
+///   copied from the buffer.
+///
+/// @endverbatim
+class async_readable_shared_buffer_stream {
+public:
+  using is_async_readable_stream = void;
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Construct a stream of the whole buffer.
+  ///
+  /// @endverbatim
+  async_readable_shared_buffer_stream(std::shared_ptr<const bytes> data)
+      : async_readable_shared_buffer_stream(data, 0, data->size())
+  {
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Construct a stream of ``size`` bytes of the buffer starting at
+  /// ``offset``. The range is clamped to the end of the buffer.
+  ///
+  /// @endverbatim
+  async_readable_shared_buffer_stream(std::shared_ptr<const bytes> data,
+                                      std::uint64_t offset,
+                                      std::uint64_t size)
+      : data_(std::move(data))
+      , offset_(std::min<std::uint64_t>(offset, data_->size()))
+      , remaining_(std::min<std::uint64_t>(size, data_->size() - offset_))
+  {
+  }
+
+  async_readable_shared_buffer_stream(
+      const async_readable_shared_buffer_stream&)
+      = delete;
+
+  async_readable_shared_buffer_stream&
+  operator=(const async_readable_shared_buffer_stream&) = delete;
+
+  async_readable_shared_buffer_stream(async_readable_shared_buffer_stream&&)
+      = default;
+
+  async_readable_shared_buffer_stream&
+  operator=(async_readable_shared_buffer_stream&&) = default;
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get a view of the part of the range which is not read yet.
+  ///
+  /// @endverbatim
+  auto remaining() const noexcept -> std::span<const std::byte>
+  {
+    return std::span<const std::byte>(*data_).subspan(offset_, remaining_);
+  }
+
+  auto
+  async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
+  {
+    if (remaining_ == 0) {
+      co_return nullopt;
+    }
+
+    auto chunk = remaining().first(
+        static_cast<std::size_t>(std::min<std::uint64_t>(remaining_, 65536)));
+    offset_ += chunk.size();
+    remaining_ -= chunk.size();
+    co_return bytes(chunk.begin(), chunk.end());
+  }
+
+  auto size_hint() const -> optional<std::uint64_t>
+  {
+    return remaining_;
+  }
+
+private:
+  std::shared_ptr<const bytes> data_;
+  std::uint64_t offset_;
+  std::uint64_t remaining_;
+};
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
@@ -16,6 +16,8 @@
 #include <fitoria/core/net.hpp>
 #include <fitoria/core/optional.hpp>
 
+#include <cstdint>
+
 FITORIA_NAMESPACE_BEGIN
 
 namespace web {
@@ -33,6 +35,40 @@ concept async_readable_stream = requires(T t) {
   } -> std::same_as<awaitable<optional<expected<bytes, std::error_code>>>>;
 };
 
+namespace detail {
+
+// The most bytes reserved up front from a size hint. The hint of a request
+// body is the `Content-Length` sent by the client, which is only bounded by
+// the request body limit, thus larger bodies grow as they arrive instead.
+inline constexpr std::uint64_t max_size_hint_reserve = 1024 * 1024;
+
+}
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// Get the number of bytes remaining to be read from the stream, if known.
+///
+/// DESCRIPTION
+///   Get the number of bytes remaining to be read from the stream, if known.
+///   An ``async_readable_stream`` may optionally provide a member function
+///   ``size_hint() const -> optional<std::uint64_t>``, otherwise ``nullopt``
+///   is returned. Readers can use the hint to allocate storage once.
+///
+/// @endverbatim
+template <async_readable_stream AsyncReadableStream>
+auto get_size_hint(const AsyncReadableStream& stream) -> optional<std::uint64_t>
+{
+  if constexpr (requires {
+                  {
+                    stream.size_hint()
+                  } -> std::convertible_to<optional<std::uint64_t>>;
+                }) {
+    return stream.size_hint();
+  } else {
+    return nullopt;
+  }
+}
+
 }
 
 FITORIA_NAMESPACE_END
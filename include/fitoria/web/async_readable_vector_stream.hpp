@@ -65,6 +65,11 @@ public:
     co_return nullopt;
   }
 
+  auto size_hint() const -> optional<std::uint64_t>
+  {
+    return data_ ? data_->size() : 0;
+  }
+
 private:
   optional<bytes> data_;
 };
@@ -11,40 +11,162 @@
 
 #include <fitoria/core/config.hpp>
 
+#include <fitoria/core/bytes.hpp>
 #include <fitoria/core/optional.hpp>
 
 #include <fitoria/web/async_readable_stream_concept.hpp>
 
-#include <array>
+#include <charconv>
+#include <cstring>
+#include <span>
+#include <string_view>
 
 FITORIA_NAMESPACE_BEGIN
 
 namespace web {
 
+/// @verbatim embed:rst:leading-slashes
+///
+/// Options for coalescing small chunks of a chunked response.
+///
+/// DESCRIPTION
+///   Options for coalescing small chunks of a chunked response. Chunks read
+///   from the body are accumulated until ``threshold`` bytes are pending, then
+///   written as a single chunk. Coalescing is driven by size only, there is no
+///   timer flushing the pending chunks, thus a stream which is about to wait
+///   for its next chunk, e.g. for an event, should yield an empty chunk to
+///   request an explicit flush of the pending chunks first.
+///
+/// @endverbatim
+struct chunk_coalescing {
+  std::size_t threshold = 16 * 1024;
+};
+
+namespace detail {
+
+// Accumulates chunk data right behind a reserved gap, so that the chunk
+// header, the data, the trailing CRLF and optionally the last chunk are sent
+// as one contiguous buffer.
+class chunk_batch {
+  // "<hex size>\r\n"
+  static constexpr std::size_t header_capacity = 2 * sizeof(std::size_t) + 2;
+
+public:
+  auto size() const noexcept -> std::size_t
+  {
+    return buffer_.empty() ? 0 : buffer_.size() - header_capacity;
+  }
+
+  void append(std::span<const std::byte> data)
+  {
+    if (buffer_.empty()) {
+      buffer_.resize(header_capacity);
+    }
+    put(data);
+  }
+
+  auto finish(bool last) -> net::const_buffer
+  {
+    using namespace std::string_view_literals;
+
+    std::size_t offset = header_capacity;
+    if (const auto n = size(); n > 0) {
+      char header[header_capacity];
+      auto [ptr, ec] = std::to_chars(
+          std::begin(header), std::end(header) - 2, n, 16);
+      *ptr++ = '\r';
+      *ptr++ = '\n';
+      const auto len = static_cast<std::size_t>(ptr - header);
+      offset -= len;
+      std::memcpy(buffer_.data() + offset, header, len);
+      put(std::as_bytes(std::span("\r\n"sv)));
+    } else {
+      buffer_.resize(header_capacity);
+    }
+    if (last) {
+      put(std::as_bytes(std::span("0\r\n\r\n"sv)));
+    }
+
+    return net::buffer(buffer_.data() + offset, buffer_.size() - offset);
+  }
+
+  void clear() noexcept
+  {
+    buffer_.clear();
+  }
+
+private:
+  void put(std::span<const std::byte> data)
+  {
+    const auto size = buffer_.size();
+    buffer_.resize(size + data.size());
+    std::memcpy(buffer_.data() + size, data.data(), data.size());
+  }
+
+  bytes buffer_;
+};
+
+}
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// Write the stream as chunks of a ``Transfer-Encoding: chunked`` body.
+///
+/// DESCRIPTION
+///   Write the stream as chunks of a ``Transfer-Encoding: chunked`` body. If
+///   ``coalescing`` is ``nullopt``, every chunk read from the stream is written
+///   immediately. Otherwise small chunks are batched according to
+///   ``coalescing``, while chunks larger than ``threshold`` are written
+///   without being copied.
+///
+/// @endverbatim
 template <typename AsyncWritableStream,
           async_readable_stream AsyncReadableStream>
-auto async_write_chunks(AsyncWritableStream&& to, AsyncReadableStream&& from)
+auto async_write_chunks(AsyncWritableStream&& to,
+                        AsyncReadableStream&& from,
+                        optional<chunk_coalescing> coalescing = nullopt)
     -> awaitable<expected<void, std::error_code>>
 {
   using boost::beast::async_write;
   using boost::beast::http::make_chunk;
-  using boost::beast::http::make_chunk_last;
+
+  const auto threshold = coalescing ? coalescing->threshold : 0;
+
+  auto batch = detail::chunk_batch();
 
   for (auto data = co_await from.async_read_some(); data;
        data = co_await from.async_read_some()) {
     auto& d = *data;
-    if (d) {
+    if (!d) {
+      co_return unexpected { d.error() };
+    }
+
+    // an empty chunk would terminate the body, treat it as a flush request
+    const bool flush = d->empty();
+    if (!flush && batch.size() == 0 && d->size() >= threshold) {
       if (auto result = co_await async_write(
               to, make_chunk(net::buffer(*d)), use_awaitable);
           !result) {
         co_return unexpected { result.error() };
       }
-    } else {
-      co_return unexpected { d.error() };
+      continue;
+    }
+
+    if (!flush) {
+      batch.append(*d);
+    }
+
+    if (batch.size() > 0 && (flush || batch.size() >= threshold)) {
+      if (auto result
+          = co_await async_write(to, batch.finish(false), use_awaitable);
+          !result) {
+        co_return unexpected { result.error() };
+      }
+      batch.clear();
     }
   }
 
-  co_return co_await async_write(to, make_chunk_last(), use_awaitable);
+  co_return co_await async_write(to, batch.finish(true), use_awaitable);
 }
 
 }
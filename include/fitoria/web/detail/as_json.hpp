@@ -13,29 +13,140 @@
 
 #include <fitoria/core/expected.hpp>
 #include <fitoria/core/json.hpp>
+#include <fitoria/core/net.hpp>
+
+#include <fitoria/web/async_readable_stream_concept.hpp>
+#include <fitoria/web/detail/json_codec.hpp>
+
+#include <system_error>
 
 FITORIA_NAMESPACE_BEGIN
 
 namespace web::detail {
 
+template <typename T>
+class json_reader {
+public:
+  json_reader()
+  {
+    parser_.reset(&resource_);
+  }
+
+  json_reader(const json_reader&) = delete;
+
+  json_reader& operator=(const json_reader&) = delete;
+
+  void write(const char* data, std::size_t size, boost::system::error_code& ec)
+  {
+    parser_.write(data, size, ec);
+  }
+
+  void finish(boost::system::error_code& ec)
+  {
+    parser_.finish(ec);
+  }
+
+  auto release() -> expected<T, std::error_code>
+  {
+    auto jv = parser_.release();
+    if constexpr (std::is_same_v<T, boost::json::value>) {
+      // move out of the monotonic resource before it goes away
+      return boost::json::value(std::move(jv), boost::json::storage_ptr());
+    } else {
+      if (auto res = boost::json::try_value_to<T>(jv); res) {
+        return std::move(*res);
+      } else {
+        return unexpected { res.error() };
+      }
+    }
+  }
+
+private:
+  // the DOM only lives until it is converted into ``T``, allocate it from a
+  // monotonic resource and release everything at once
+  unsigned char initial_[4096];
+  boost::json::monotonic_resource resource_ { initial_, sizeof(initial_) };
+  boost::json::stream_parser parser_;
+};
+
+template <json_direct_decodable T>
+class json_reader<T> {
+public:
+  void write(const char* data, std::size_t size, boost::system::error_code& ec)
+  {
+    if (parser_.write_some(true, data, size, ec) < size && !ec) {
+      ec = boost::json::error::extra_data;
+    }
+  }
+
+  void finish(boost::system::error_code& ec)
+  {
+    parser_.write_some(false, nullptr, 0, ec);
+  }
+
+  auto release() -> expected<T, std::error_code>
+  {
+    return parser_.handler().release();
+  }
+
+private:
+  boost::json::basic_parser<json_decode_handler<T>> parser_ {
+    boost::json::parse_options()
+  };
+};
+
 template <typename T = boost::json::value>
 expected<T, std::error_code> as_json(std::string_view text)
 {
+  json_reader<T> reader;
   boost::system::error_code ec;
-  auto jv = boost::json::parse(text, ec);
+  reader.write(text.data(), text.size(), ec);
+  if (!ec) {
+    reader.finish(ec);
+  }
   if (ec) {
     return unexpected { ec };
   }
 
-  if constexpr (std::is_same_v<T, boost::json::value>) {
-    return jv;
-  } else {
-    if (auto res = boost::json::try_value_to<T>(jv); res) {
-      return std::move(*res);
-    } else {
-      return unexpected { res.error() };
+  return reader.release();
+}
+
+template <typename T = boost::json::value,
+          async_readable_stream AsyncReadableStream>
+auto async_read_json(AsyncReadableStream&& stream, std::uint64_t limit)
+    -> awaitable<expected<T, std::error_code>>
+{
+  if (auto hint = get_size_hint(stream); hint && *hint > limit) {
+    co_return unexpected { std::make_error_code(std::errc::message_size) };
+  }
+
+  json_reader<T> reader;
+  std::uint64_t size = 0;
+  boost::system::error_code ec;
+  for (auto data = co_await stream.async_read_some(); data;
+       data = co_await stream.async_read_some()) {
+    auto& d = *data;
+    if (!d) {
+      co_return unexpected { d.error() };
+    }
+
+    size += d->size();
+    if (size > limit) {
+      co_return unexpected { std::make_error_code(std::errc::message_size) };
+    }
+
+    reader.write(reinterpret_cast<const char*>(d->data()), d->size(), ec);
+    if (ec) {
+      co_return unexpected { ec };
     }
   }
+
+  reader.finish(ec);
+  if (ec) {
+    co_return unexpected { ec };
+  }
+
+  co_return reader.release();
 }
 
 }
@@ -0,0 +1,200 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_DETAIL_ASYNC_READABLE_BYTERANGES_STREAM_HPP
+#define FITORIA_WEB_DETAIL_ASYNC_READABLE_BYTERANGES_STREAM_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/format.hpp>
+#include <fitoria/core/net.hpp>
+#include <fitoria/core/optional.hpp>
+
+#include <fitoria/http.hpp>
+
+#include <fitoria/web/async_readable_stream_concept.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::detail {
+
+// Sorts the ranges and merges the ones which overlap or are adjacent.
+inline auto coalesce_ranges(std::vector<http::header::range::subrange_t> ranges)
+    -> std::vector<http::header::range::subrange_t>
+{
+  std::ranges::sort(ranges, {}, &http::header::range::subrange_t::offset);
+
+  auto merged = std::vector<http::header::range::subrange_t>();
+  for (auto& r : ranges) {
+    if (!merged.empty()
+        && r.offset <= merged.back().offset + merged.back().length) {
+      auto& last = merged.back();
+      last.length = std::max(last.offset + last.length, r.offset + r.length)
+          - last.offset;
+    } else {
+      merged.push_back(r);
+    }
+  }
+
+  return merged;
+}
+
+inline auto make_multipart_boundary() -> std::string
+{
+  thread_local auto engine = std::mt19937_64(std::random_device()());
+  return fmt::format("{:016x}{:016x}", engine(), engine());
+}
+
+#if defined(BOOST_ASIO_HAS_FILE)
+
+// Stream of a `multipart/byteranges` body (RFC 9110 section 14.6). The headers
+// of the parts are rendered up front, so that the size of the whole body is
+// known before sending it.
+class async_readable_byteranges_stream {
+  struct part {
+    std::string header;
+    std::uint64_t offset;
+    std::uint64_t length;
+  };
+
+public:
+  using is_async_readable_stream = void;
+
+  async_readable_byteranges_stream(
+      stream_file file,
+      std::string_view boundary,
+      std::string_view content_type,
+      std::span<const http::header::range::subrange_t> ranges)
+      : file_(std::move(file))
+      , trailer_(fmt::format("\r\n--{}--\r\n", boundary))
+  {
+    const auto total = file_.size();
+    for (auto& r : ranges) {
+      parts_.push_back(part {
+          fmt::format("{}--{}\r\nContent-Type: {}\r\n"
+                      "Content-Range: bytes {}-{}/{}\r\n\r\n",
+                      parts_.empty() ? "" : "\r\n",
+                      boundary,
+                      content_type,
+                      r.offset,
+                      r.offset + r.length - 1,
+                      total),
+          r.offset,
+          r.length,
+      });
+      size_ += parts_.back().header.size() + r.length;
+    }
+    size_ += trailer_.size();
+  }
+
+  async_readable_byteranges_stream(const async_readable_byteranges_stream&)
+      = delete;
+
+  async_readable_byteranges_stream&
+  operator=(const async_readable_byteranges_stream&) = delete;
+
+  async_readable_byteranges_stream(async_readable_byteranges_stream&&)
+      = default;
+
+  async_readable_byteranges_stream&
+  operator=(async_readable_byteranges_stream&&) = default;
+
+  // Gets the size of the whole body.
+  auto size() const noexcept -> std::uint64_t
+  {
+    return size_;
+  }
+
+  auto size_hint() const -> optional<std::uint64_t>
+  {
+    return size_ - sent_;
+  }
+
+  auto
+  async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
+  {
+    while (index_ < parts_.size()) {
+      auto& p = parts_[index_];
+      if (!header_sent_) {
+        boost::system::error_code ec;
+        file_.seek(static_cast<std::int64_t>(p.offset),
+                   net::file_base::seek_set,
+                   ec);
+        if (ec) {
+          co_return unexpected { ec };
+        }
+
+        header_sent_ = true;
+        remaining_ = p.length;
+        co_return to_bytes(p.header);
+      }
+
+      if (remaining_ > 0) {
+        auto buffer = bytes(std::min<std::uint64_t>(remaining_, 65536));
+        if (auto result = co_await file_.async_read_some(net::buffer(buffer),
+                                                         use_awaitable);
+            result) {
+          buffer.resize(*result);
+          remaining_ -= *result;
+          sent_ += *result;
+          co_return buffer;
+        } else if (result.error() == net::error::eof) {
+          co_return nullopt;
+        } else {
+          co_return unexpected { result.error() };
+        }
+      }
+
+      ++index_;
+      header_sent_ = false;
+    }
+
+    if (!trailer_sent_) {
+      trailer_sent_ = true;
+      co_return to_bytes(trailer_);
+    }
+
+    co_return nullopt;
+  }
+
+private:
+  auto to_bytes(std::string_view sv) -> bytes
+  {
+    sent_ += sv.size();
+    const auto data = std::as_bytes(std::span(sv.data(), sv.size()));
+    return bytes(data.begin(), data.end());
+  }
+
+  stream_file file_;
+  std::vector<part> parts_;
+  std::string trailer_;
+  std::uint64_t size_ = 0;
+  std::uint64_t sent_ = 0;
+  std::size_t index_ = 0;
+  bool header_sent_ = false;
+  std::uint64_t remaining_ = 0;
+  bool trailer_sent_ = false;
+};
+
+#endif
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_DETAIL_ASYNC_SPILL_BODY_HPP
+#define FITORIA_WEB_DETAIL_ASYNC_SPILL_BODY_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/net.hpp>
+
+#include <fitoria/web/any_async_readable_stream.hpp>
+#include <fitoria/web/async_read_into_stream_file.hpp>
+#include <fitoria/web/async_readable_file_stream.hpp>
+#include <fitoria/web/async_readable_vector_stream.hpp>
+
+#include <filesystem>
+#include <system_error>
+
+#if defined(BOOST_ASIO_HAS_FILE) && !defined(FITORIA_TARGET_WINDOWS)
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::detail {
+
+#if defined(BOOST_ASIO_HAS_FILE)
+
+// Opens an anonymous file in the temporary directory, which is removed by the
+// system once it is closed.
+inline auto open_temporary_file(const executor_type& ex)
+    -> expected<stream_file, std::error_code>
+{
+  auto ec = std::error_code();
+  const auto dir = std::filesystem::temp_directory_path(ec);
+  if (ec) {
+    return unexpected { ec };
+  }
+
+#if defined(FITORIA_TARGET_WINDOWS)
+  wchar_t path[MAX_PATH];
+  if (::GetTempFileNameW(dir.c_str(), L"fit", 0, path) == 0) {
+    return unexpected { std::error_code(static_cast<int>(::GetLastError()),
+                                        std::system_category()) };
+  }
+
+  auto handle = ::CreateFileW(path,
+                              GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_DELETE,
+                              nullptr,
+                              TRUNCATE_EXISTING,
+                              FILE_ATTRIBUTE_TEMPORARY
+                                  | FILE_FLAG_DELETE_ON_CLOSE
+                                  | FILE_FLAG_OVERLAPPED,
+                              nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    const auto error = ::GetLastError();
+    ::DeleteFileW(path);
+    return unexpected { std::error_code(static_cast<int>(error),
+                                        std::system_category()) };
+  }
+
+  return stream_file(ex, handle);
+#else
+  int fd = -1;
+#if defined(O_TMPFILE)
+  fd = ::open(dir.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, S_IRUSR | S_IWUSR);
+#endif
+  // O_TMPFILE is not supported by every file system
+  if (fd == -1) {
+    auto path = (dir / "fitoria-XXXXXX").string();
+    fd = ::mkstemp(path.data());
+    if (fd != -1) {
+      ::unlink(path.c_str());
+    }
+  }
+  if (fd == -1) {
+    return unexpected { std::error_code(errno, std::system_category()) };
+  }
+
+  return stream_file(ex, fd);
+#endif
+}
+
+// Reads the whole body, keeping it in memory as long as it does not exceed
+// `threshold` bytes. Otherwise the body is written into a temporary file and
+// read from there.
+template <async_readable_stream AsyncReadableStream>
+auto async_spill_body(AsyncReadableStream&& stream, std::uint64_t threshold)
+    -> awaitable<expected<any_async_readable_stream, std::error_code>>
+{
+  auto buffer = bytes();
+
+  for (auto data = co_await stream.async_read_some(); data;
+       data = co_await stream.async_read_some()) {
+    auto& d = *data;
+    if (!d) {
+      co_return unexpected { d.error() };
+    }
+
+    if (buffer.size() + d->size() <= threshold) {
+      if (buffer.empty()) {
+        buffer = std::move(*d);
+      } else {
+        buffer.insert(buffer.end(), d->begin(), d->end());
+      }
+      continue;
+    }
+
+    auto file = open_temporary_file(co_await net::this_coro::executor);
+    if (!file) {
+      co_return unexpected { file.error() };
+    }
+
+    for (auto* b : { &buffer, &*d }) {
+      if (auto result
+          = co_await net::async_write(*file, net::buffer(*b), use_awaitable);
+          !result) {
+        co_return unexpected { result.error() };
+      }
+    }
+    buffer = bytes();
+
+    if (auto result = co_await async_read_into_stream_file(stream, *file);
+        !result) {
+      co_return unexpected { result.error() };
+    }
+
+    boost::system::error_code ec;
+    file->seek(0, net::file_base::seek_set, ec);
+    if (ec) {
+      co_return unexpected { ec };
+    }
+
+    co_return async_readable_file_stream(std::move(*file));
+  }
+
+  co_return async_readable_vector_stream(std::move(buffer));
+}
+
+#endif
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
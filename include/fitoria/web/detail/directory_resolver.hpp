@@ -0,0 +1,255 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_DETAIL_DIRECTORY_RESOLVER_HPP
+#define FITORIA_WEB_DETAIL_DIRECTORY_RESOLVER_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/net.hpp>
+#include <fitoria/core/strings.hpp>
+
+#include <fitoria/web/detail/static_file_metadata.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(BOOST_ASIO_HAS_FILE) && !defined(BOOST_ASIO_WINDOWS)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__) && __has_include(<linux/openat2.h>)
+#include <linux/openat2.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::detail {
+
+#if defined(BOOST_ASIO_HAS_FILE)
+
+// Resolves relative paths beneath a root directory. On POSIX the root is kept
+// open and files are opened relative to its descriptor, with
+// `openat2(RESOLVE_BENEATH)` on Linux, so that neither `..` nor a symbolic
+// link can escape the root. Where `openat2` is unavailable, paths containing
+// `..` components are rejected before `openat`.
+class directory_resolver {
+public:
+  static auto open(const std::string& root)
+      -> expected<directory_resolver, std::error_code>
+  {
+#if defined(BOOST_ASIO_WINDOWS)
+    std::error_code ec;
+    if (!std::filesystem::is_directory(root, ec)) {
+      if (!ec) {
+        ec = std::make_error_code(std::errc::not_a_directory);
+      }
+      return unexpected { ec };
+    }
+
+    return directory_resolver(root);
+#else
+    auto fd = ::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+      return unexpected { std::error_code(errno, std::system_category()) };
+    }
+
+    return directory_resolver(root, fd);
+#endif
+  }
+
+  directory_resolver(const directory_resolver&) = delete;
+
+  directory_resolver& operator=(const directory_resolver&) = delete;
+
+  directory_resolver(directory_resolver&& other) noexcept
+      : root_(std::move(other.root_))
+#if !defined(BOOST_ASIO_WINDOWS)
+      , fd_(std::exchange(other.fd_, -1))
+#endif
+  {
+  }
+
+  directory_resolver& operator=(directory_resolver&& other) noexcept
+  {
+    if (this != &other) {
+      close();
+      root_ = std::move(other.root_);
+#if !defined(BOOST_ASIO_WINDOWS)
+      fd_ = std::exchange(other.fd_, -1);
+#endif
+    }
+    return *this;
+  }
+
+  ~directory_resolver()
+  {
+    close();
+  }
+
+  auto root() const noexcept -> const std::string&
+  {
+    return root_;
+  }
+
+  // Opens the file at `path` relative to the root with read-only permission.
+  // Fails with `std::errc::is_a_directory` if it refers to a directory.
+  template <typename File>
+  auto open_file(const executor_type& ex, std::string_view path) const
+      -> expected<File, std::error_code>
+  {
+    if (path.find('\0') != std::string_view::npos) {
+      return unexpected { std::make_error_code(std::errc::invalid_argument) };
+    }
+
+#if defined(BOOST_ASIO_WINDOWS)
+    if (!is_beneath(path)
+        || path.find_first_of("\\:") != std::string_view::npos) {
+      return unexpected { std::make_error_code(
+          std::errc::no_such_file_or_directory) };
+    }
+
+    auto full = std::filesystem::path(root_) / std::filesystem::path(path);
+    std::error_code ec;
+    if (std::filesystem::is_directory(full, ec)) {
+      return unexpected { std::make_error_code(std::errc::is_a_directory) };
+    }
+
+    return detail::open_file<File>(ex, full.string());
+#else
+    auto fd = open_beneath(path);
+    if (fd < 0) {
+      return unexpected { std::error_code(errno, std::system_category()) };
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      const auto ec = std::error_code(errno, std::system_category());
+      ::close(fd);
+      return unexpected { ec };
+    }
+    if (S_ISDIR(st.st_mode)) {
+      ::close(fd);
+      return unexpected { std::make_error_code(std::errc::is_a_directory) };
+    }
+
+    auto file = File(ex);
+    boost::system::error_code ec;
+    file.assign(fd, ec); // NOLINT
+    if (ec) {
+      ::close(fd);
+      return unexpected { ec };
+    }
+
+    return file;
+#endif
+  }
+
+  // Gets the last write time of a file opened by `open_file()`.
+  template <typename File>
+  auto get_last_modified_time([[maybe_unused]] File& file,
+                              [[maybe_unused]] std::string_view path) const
+      -> expected<file_time_point, std::error_code>
+  {
+#if defined(BOOST_ASIO_WINDOWS)
+    return detail::get_last_modified_time(
+        (std::filesystem::path(root_) / std::filesystem::path(path)).string());
+#else
+    struct stat st;
+    if (::fstat(file.native_handle(), &st) != 0) {
+      return unexpected { std::error_code(errno, std::system_category()) };
+    }
+
+    const auto since_epoch = std::chrono::seconds(st.st_mtim.tv_sec)
+        + std::chrono::nanoseconds(st.st_mtim.tv_nsec);
+    return std::chrono::file_clock::from_sys(
+        std::chrono::sys_time<std::chrono::nanoseconds>(since_epoch));
+#endif
+  }
+
+private:
+#if defined(BOOST_ASIO_WINDOWS)
+  explicit directory_resolver(std::string root)
+      : root_(std::move(root))
+  {
+  }
+
+  void close() noexcept { }
+#else
+  directory_resolver(std::string root, int fd)
+      : root_(std::move(root))
+      , fd_(fd)
+  {
+  }
+
+  void close() noexcept
+  {
+    if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  auto open_beneath(std::string_view path) const -> int
+  {
+    const auto relative = std::string(path.empty() ? "." : path);
+#if defined(__linux__) && defined(SYS_openat2) && defined(RESOLVE_BENEATH)
+    auto how = open_how {};
+    how.flags = O_RDONLY | O_CLOEXEC;
+    how.resolve = RESOLVE_BENEATH | RESOLVE_NO_MAGICLINKS;
+    auto fd = static_cast<int>(
+        ::syscall(SYS_openat2, fd_, relative.c_str(), &how, sizeof(how)));
+    if (fd >= 0 || errno != ENOSYS) {
+      return fd;
+    }
+#endif
+    if (!is_beneath(path)) {
+      errno = ENOENT;
+      return -1;
+    }
+
+    return ::openat(fd_, relative.c_str(), O_RDONLY | O_CLOEXEC);
+  }
+#endif
+
+  // Lexical check of the relative path, only used where the file system can
+  // not confine the resolution to the root.
+  static auto is_beneath(std::string_view path) -> bool
+  {
+    if (path.starts_with('/')) {
+      return false;
+    }
+
+    for (auto segment : split_of(path, "/")) {
+      if (segment == "..") {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  std::string root_;
+#if !defined(BOOST_ASIO_WINDOWS)
+  int fd_ = -1;
+#endif
+};
+
+#endif
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
@@ -0,0 +1,487 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_DETAIL_JSON_CODEC_HPP
+#define FITORIA_WEB_DETAIL_JSON_CODEC_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/json.hpp>
+#include <fitoria/core/optional.hpp>
+#include <fitoria/core/type_traits.hpp>
+
+#include <fitoria/web/error.hpp>
+
+#include <boost/json/basic_parser_impl.hpp>
+#include <boost/pfr.hpp>
+
+#include <algorithm>
+#include <bitset>
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::detail {
+
+template <typename T>
+concept json_character = std::same_as<T, char> || std::same_as<T, wchar_t>
+    || std::same_as<T, char8_t> || std::same_as<T, char16_t>
+    || std::same_as<T, char32_t>;
+
+template <typename T>
+concept json_scalar = std::same_as<T, bool>
+    || (std::integral<T> && !json_character<T>) || std::floating_point<T>
+    || std::same_as<T, std::string>;
+
+template <typename T>
+concept json_field = json_scalar<T>
+    || ((is_specialization_of_v<T, optional>
+         || is_specialization_of_v<T, std::optional>)
+        && json_scalar<typename T::value_type>);
+
+template <typename T, std::size_t... Is>
+consteval bool json_fields(std::index_sequence<Is...>)
+{
+  return (json_field<boost::pfr::tuple_element_t<Is, T>> && ...);
+}
+
+/// Aggregates whose fields are json scalars are encoded/decoded directly
+/// through Boost.PFR, types customized with ``tag_invoke`` are not.
+template <typename T>
+concept json_direct_decodable = std::is_aggregate_v<T>
+    && std::default_initializable<T> && !boost::json::has_value_to<T>::value
+    && json_fields<T>(
+        std::make_index_sequence<boost::pfr::tuple_size_v<T>> {});
+
+template <typename T>
+concept json_direct_encodable = std::is_aggregate_v<T>
+    && !boost::json::has_value_from<T>::value
+    && json_fields<T>(
+        std::make_index_sequence<boost::pfr::tuple_size_v<T>> {});
+
+template <typename Container>
+void json_append(Container& out, std::string_view sv)
+{
+  const auto size = out.size();
+  out.resize(size + sv.size());
+  std::memcpy(out.data() + size, sv.data(), sv.size());
+}
+
+template <typename Container>
+void json_append_string(Container& out, std::string_view sv)
+{
+  static constexpr char hex[] = "0123456789abcdef";
+
+  json_append(out, "\"");
+  auto first = sv.begin();
+  for (auto it = sv.begin(); it != sv.end(); ++it) {
+    const auto c = static_cast<unsigned char>(*it);
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+
+    json_append(out, std::string_view(first, it));
+    first = it + 1;
+    switch (c) {
+    case '"':
+      json_append(out, "\\\"");
+      break;
+    case '\\':
+      json_append(out, "\\\\");
+      break;
+    case '\b':
+      json_append(out, "\\b");
+      break;
+    case '\f':
+      json_append(out, "\\f");
+      break;
+    case '\n':
+      json_append(out, "\\n");
+      break;
+    case '\r':
+      json_append(out, "\\r");
+      break;
+    case '\t':
+      json_append(out, "\\t");
+      break;
+    default: {
+      const char escaped[] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+      json_append(out, std::string_view(escaped, sizeof(escaped)));
+      break;
+    }
+    }
+  }
+  json_append(out, std::string_view(first, sv.end()));
+  json_append(out, "\"");
+}
+
+template <typename Container, typename T>
+void json_append_field(Container& out, const T& value)
+{
+  if constexpr (std::same_as<T, bool>) {
+    json_append(out, value ? "true" : "false");
+  } else if constexpr (std::same_as<T, std::string>) {
+    json_append_string(out, value);
+  } else if constexpr (std::integral<T> || std::floating_point<T>) {
+    if constexpr (std::floating_point<T>) {
+      if (!std::isfinite(value)) {
+        json_append(out, "null");
+        return;
+      }
+    }
+
+    char buffer[32];
+    auto [ptr, ec] = std::to_chars(std::begin(buffer), std::end(buffer), value);
+    json_append(out, std::string_view(buffer, ptr));
+  } else {
+    if (value) {
+      json_append_field(out, *value);
+    } else {
+      json_append(out, "null");
+    }
+  }
+}
+
+/// Serializes ``value`` as a json object into ``out`` without building a
+/// ``boost::json::value``.
+template <json_direct_encodable T, typename Container>
+void json_encode(const T& value, Container& out)
+{
+  json_append(out, "{");
+  [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+    (
+        [&] {
+          if constexpr (Is != 0) {
+            json_append(out, ",");
+          }
+          json_append_string(out, boost::pfr::get_name<Is, T>());
+          json_append(out, ":");
+          json_append_field(out, boost::pfr::get<Is>(value));
+        }(),
+        ...);
+  }(std::make_index_sequence<boost::pfr::tuple_size_v<T>> {});
+  json_append(out, "}");
+}
+
+/// Serializes ``jv`` into ``out`` without an intermediate string.
+template <typename Container>
+void json_encode(const boost::json::value& jv, Container& out)
+{
+  boost::json::serializer sr;
+  sr.reset(&jv);
+  while (!sr.done()) {
+    const auto size = out.size();
+    out.resize(std::max<std::size_t>(size * 2, size + 256));
+    auto sv = sr.read(reinterpret_cast<char*>(out.data()) + size,
+                      out.size() - size);
+    out.resize(size + sv.size());
+  }
+}
+
+/// ``boost::json::basic_parser`` handler which assigns the members of the
+/// top-level object straight into the fields of ``T``. Unknown members are
+/// skipped.
+template <json_direct_decodable T>
+class json_decode_handler {
+  static constexpr std::size_t num_fields = boost::pfr::tuple_size_v<T>;
+  static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+public:
+  static constexpr std::size_t max_object_size
+      = std::numeric_limits<std::size_t>::max();
+  static constexpr std::size_t max_array_size
+      = std::numeric_limits<std::size_t>::max();
+  static constexpr std::size_t max_key_size
+      = std::numeric_limits<std::size_t>::max();
+  static constexpr std::size_t max_string_size
+      = std::numeric_limits<std::size_t>::max();
+
+  auto release() -> expected<T, std::error_code>
+  {
+    if (!assigned_.all()) {
+      // absent optional fields are treated as null
+      bool missing = false;
+      [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+        ((missing = missing
+              || (!assigned_.test(Is)
+                  && json_scalar<boost::pfr::tuple_element_t<Is, T>>)),
+         ...);
+      }(std::make_index_sequence<num_fields> {});
+      if (missing) {
+        return unexpected { make_error_code(
+            error::extractor_field_name_not_found) };
+      }
+    }
+
+    return std::move(value_);
+  }
+
+  bool on_document_begin(boost::system::error_code&)
+  {
+    return true;
+  }
+
+  bool on_document_end(boost::system::error_code&)
+  {
+    return true;
+  }
+
+  bool on_array_begin(boost::system::error_code& ec)
+  {
+    return depth_ > 0 ? begin_container(ec) : not_object(ec);
+  }
+
+  bool on_array_end(std::size_t, boost::system::error_code&)
+  {
+    return end_container();
+  }
+
+  bool on_object_begin(boost::system::error_code& ec)
+  {
+    return begin_container(ec);
+  }
+
+  bool on_object_end(std::size_t, boost::system::error_code&)
+  {
+    return end_container();
+  }
+
+  bool on_string_part(boost::json::string_view sv,
+                      std::size_t,
+                      boost::system::error_code&)
+  {
+    if (depth_ == 1 && field_ != npos) {
+      str_.append(sv.data(), sv.size());
+    }
+    return true;
+  }
+
+  bool on_string(boost::json::string_view sv,
+                 std::size_t,
+                 boost::system::error_code& ec)
+  {
+    if (depth_ == 1 && field_ != npos) {
+      str_.append(sv.data(), sv.size());
+      auto result = assign(std::move(str_), ec);
+      str_.clear();
+      return result;
+    }
+    return depth_ > 0 || not_object(ec);
+  }
+
+  bool on_key_part(boost::json::string_view sv,
+                   std::size_t,
+                   boost::system::error_code&)
+  {
+    if (depth_ == 1) {
+      key_.append(sv.data(), sv.size());
+    }
+    return true;
+  }
+
+  bool on_key(boost::json::string_view sv,
+              std::size_t,
+              boost::system::error_code&)
+  {
+    if (depth_ == 1) {
+      key_.append(sv.data(), sv.size());
+      field_ = find_field(key_);
+      key_.clear();
+    }
+    return true;
+  }
+
+  bool on_number_part(boost::json::string_view, boost::system::error_code&)
+  {
+    return true;
+  }
+
+  bool on_int64(std::int64_t value,
+                boost::json::string_view,
+                boost::system::error_code& ec)
+  {
+    return on_scalar(value, ec);
+  }
+
+  bool on_uint64(std::uint64_t value,
+                 boost::json::string_view,
+                 boost::system::error_code& ec)
+  {
+    return on_scalar(value, ec);
+  }
+
+  bool on_double(double value,
+                 boost::json::string_view,
+                 boost::system::error_code& ec)
+  {
+    return on_scalar(value, ec);
+  }
+
+  bool on_bool(bool value, boost::system::error_code& ec)
+  {
+    return on_scalar(value, ec);
+  }
+
+  bool on_null(boost::system::error_code& ec)
+  {
+    return on_scalar(nullptr, ec);
+  }
+
+  bool on_comment_part(boost::json::string_view, boost::system::error_code&)
+  {
+    return true;
+  }
+
+  bool on_comment(boost::json::string_view, boost::system::error_code&)
+  {
+    return true;
+  }
+
+private:
+  static auto find_field(std::string_view key) -> std::size_t
+  {
+    auto index = npos;
+    [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      (void)((boost::pfr::get_name<Is, T>() == key ? (index = Is, true)
+                                                     : false)
+             || ...);
+    }(std::make_index_sequence<num_fields> {});
+    return index;
+  }
+
+  static bool not_object(boost::system::error_code& ec)
+  {
+    ec = boost::json::error::not_object;
+    return false;
+  }
+
+  bool begin_container(boost::system::error_code& ec)
+  {
+    if (depth_ == 1 && field_ != npos) {
+      // fields are scalars, nested values are only allowed to be skipped
+      ec = boost::json::error::not_object;
+      return false;
+    }
+    ++depth_;
+    return true;
+  }
+
+  bool end_container()
+  {
+    if (--depth_ == 1) {
+      field_ = npos;
+    }
+    return true;
+  }
+
+  template <typename Value>
+  bool on_scalar(Value value, boost::system::error_code& ec)
+  {
+    if (depth_ == 1 && field_ != npos) {
+      return assign(value, ec);
+    }
+    return depth_ > 0 || not_object(ec);
+  }
+
+  template <typename Value>
+  bool assign(Value&& value, boost::system::error_code& ec)
+  {
+    const auto index = std::exchange(field_, npos);
+    bool result = true;
+    [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      (void)((Is == index
+                  ? (result = assign_field(boost::pfr::get<Is>(value_),
+                                           std::forward<Value>(value),
+                                           ec),
+                     assigned_.set(Is),
+                     true)
+                  : false)
+             || ...);
+    }(std::make_index_sequence<num_fields> {});
+    return result;
+  }
+
+  template <typename Field, typename Value>
+  static bool
+  assign_field(Field& field, Value&& value, boost::system::error_code& ec)
+  {
+    using value_type = std::remove_cvref_t<Value>;
+
+    if constexpr (json_scalar<Field>) {
+      if constexpr (std::same_as<Field, bool>) {
+        if constexpr (std::same_as<value_type, bool>) {
+          field = value;
+          return true;
+        } else {
+          ec = boost::json::error::not_bool;
+          return false;
+        }
+      } else if constexpr (std::same_as<Field, std::string>) {
+        if constexpr (std::same_as<value_type, std::string>) {
+          field = std::forward<Value>(value);
+          return true;
+        } else {
+          ec = boost::json::error::not_string;
+          return false;
+        }
+      } else if constexpr (std::integral<Field>) {
+        if constexpr (std::same_as<value_type, std::int64_t>
+                      || std::same_as<value_type, std::uint64_t>) {
+          if (!std::in_range<Field>(value)) {
+            ec = boost::json::error::not_exact;
+            return false;
+          }
+          field = static_cast<Field>(value);
+          return true;
+        } else {
+          ec = boost::json::error::not_integer;
+          return false;
+        }
+      } else {
+        if constexpr (std::same_as<value_type, std::int64_t>
+                      || std::same_as<value_type, std::uint64_t>
+                      || std::same_as<value_type, double>) {
+          field = static_cast<Field>(value);
+          return true;
+        } else {
+          ec = boost::json::error::not_number;
+          return false;
+        }
+      }
+    } else {
+      if constexpr (std::same_as<value_type, std::nullptr_t>) {
+        field.reset();
+        return true;
+      } else {
+        return assign_field(field.emplace(), std::forward<Value>(value), ec);
+      }
+    }
+  }
+
+  T value_ {};
+  std::bitset<num_fields> assigned_;
+  std::size_t depth_ = 0;
+  std::size_t field_ = npos;
+  std::string key_;
+  std::string str_;
+};
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
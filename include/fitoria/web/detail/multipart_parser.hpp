@@ -0,0 +1,301 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_DETAIL_MULTIPART_PARSER_HPP
+#define FITORIA_WEB_DETAIL_MULTIPART_PARSER_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/net.hpp>
+#include <fitoria/core/optional.hpp>
+#include <fitoria/core/strings.hpp>
+
+#include <fitoria/http.hpp>
+
+#include <fitoria/web/any_async_readable_stream.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::detail {
+
+struct multipart_match {
+  std::size_t pos;
+  bool complete;
+};
+
+// Finds the first occurrence of `delimiter` in `data`. If there is none, a
+// delimiter which may be completed by the following data is looked for at the
+// end of `data`. Returns `data.size()` if neither is found.
+inline auto find_multipart_delimiter(std::string_view data,
+                                     std::string_view delimiter)
+    -> multipart_match
+{
+  const auto* first = data.data();
+  std::size_t pos = 0;
+  while (pos < data.size()) {
+    const auto* p = static_cast<const char*>(
+        std::memchr(first + pos, delimiter.front(), data.size() - pos));
+    if (p == nullptr) {
+      break;
+    }
+
+    pos = static_cast<std::size_t>(p - first);
+    const auto n = std::min(data.size() - pos, delimiter.size());
+    if (std::memcmp(p, delimiter.data(), n) == 0) {
+      return { pos, n == delimiter.size() };
+    }
+    ++pos;
+  }
+
+  return { data.size(), false };
+}
+
+// Incremental parser of a multipart body (RFC 2046). The body is read chunk by
+// chunk, the data of a part is handed out as soon as it is known not to belong
+// to the following delimiter.
+class multipart_parser {
+  enum class state {
+    preamble,
+    delimiter,
+    headers,
+    body,
+    done,
+  };
+
+  static constexpr std::size_t header_limit = 16 * 1024;
+
+public:
+  multipart_parser(any_async_readable_stream body, std::string_view boundary)
+      : body_(std::move(body))
+      , delimiter_("\r\n--")
+  {
+    delimiter_.append(boundary);
+    // the first delimiter is allowed to start at the very beginning of the
+    // body, which does not have a preceding CRLF
+    append("\r\n");
+  }
+
+  multipart_parser(const multipart_parser&) = delete;
+
+  multipart_parser& operator=(const multipart_parser&) = delete;
+
+  auto generation() const noexcept -> std::uint64_t
+  {
+    return generation_;
+  }
+
+  // Skips the rest of the current part and parses the headers of the next
+  // one. Returns `nullopt` after the close delimiter.
+  auto async_next_part()
+      -> awaitable<optional<expected<http::header_map, std::error_code>>>
+  {
+    for (;;) {
+      if (ec_) {
+        co_return unexpected { ec_ };
+      }
+
+      switch (state_) {
+      case state::preamble:
+      case state::body:
+        if (auto data = co_await async_read_body(); data && !*data) {
+          co_return unexpected { data->error() };
+        }
+        break;
+      case state::delimiter:
+        if (auto result = co_await async_parse_delimiter(); !result) {
+          co_return unexpected { fail(result.error()) };
+        }
+        break;
+      case state::headers:
+        if (auto headers = co_await async_parse_headers(); headers) {
+          state_ = state::body;
+          ++generation_;
+          co_return std::move(*headers);
+        } else {
+          co_return unexpected { fail(headers.error()) };
+        }
+      case state::done:
+        co_return nullopt;
+      }
+    }
+  }
+
+  // Reads the data of the current part. Returns `nullopt` once the delimiter
+  // following the part is reached.
+  auto async_read_body()
+      -> awaitable<optional<expected<bytes, std::error_code>>>
+  {
+    while (state_ == state::preamble || state_ == state::body) {
+      const auto m = find_multipart_delimiter(pending(), delimiter_);
+      if (m.pos > 0) {
+        co_return take(m.pos);
+      }
+      if (m.complete) {
+        offset_ += delimiter_.size();
+        state_ = state::delimiter;
+        break;
+      }
+
+      if (auto result = co_await async_fill(); !result) {
+        co_return unexpected { fail(result.error()) };
+      }
+    }
+
+    co_return nullopt;
+  }
+
+private:
+  auto async_parse_delimiter() -> awaitable<expected<void, std::error_code>>
+  {
+    for (;;) {
+      const auto data = pending();
+      if (data.starts_with("--")) {
+        state_ = state::done;
+        co_return expected<void, std::error_code>();
+      }
+
+      // transport padding is allowed between the boundary and the CRLF
+      const auto pos = std::min(data.find_first_not_of(" \t"), data.size());
+      if (data.size() - pos >= 2) {
+        if (data.substr(pos, 2) != "\r\n") {
+          co_return unexpected { make_error_code(std::errc::bad_message) };
+        }
+        offset_ += pos + 2;
+        state_ = state::headers;
+        co_return expected<void, std::error_code>();
+      }
+
+      if (auto result = co_await async_fill(); !result) {
+        co_return unexpected { result.error() };
+      }
+    }
+  }
+
+  auto async_parse_headers()
+      -> awaitable<expected<http::header_map, std::error_code>>
+  {
+    for (;;) {
+      const auto data = pending();
+      if (data.starts_with("\r\n")) {
+        offset_ += 2;
+        co_return http::header_map();
+      }
+
+      if (auto pos = data.find("\r\n\r\n"); pos != std::string_view::npos) {
+        auto headers = parse_headers(data.substr(0, pos + 2));
+        offset_ += pos + 4;
+        co_return headers;
+      }
+
+      if (data.size() > header_limit) {
+        co_return unexpected { make_error_code(std::errc::message_size) };
+      }
+
+      if (auto result = co_await async_fill(); !result) {
+        co_return unexpected { result.error() };
+      }
+    }
+  }
+
+  static auto parse_headers(std::string_view data)
+      -> expected<http::header_map, std::error_code>
+  {
+    auto headers = http::header_map();
+    while (!data.empty()) {
+      const auto eol = data.find("\r\n");
+      const auto line = data.substr(0, eol);
+      data.remove_prefix(eol + 2);
+
+      const auto colon = line.find(':');
+      if (colon == std::string_view::npos || colon == 0) {
+        return unexpected { make_error_code(std::errc::bad_message) };
+      }
+      headers.insert(line.substr(0, colon), trim(line.substr(colon + 1)));
+    }
+
+    return headers;
+  }
+
+  auto async_fill() -> awaitable<expected<void, std::error_code>>
+  {
+    auto data = co_await body_.async_read_some();
+    if (!data) {
+      // the body ended before the close delimiter
+      co_return unexpected { make_error_code(std::errc::bad_message) };
+    }
+    if (!*data) {
+      co_return unexpected { data->error() };
+    }
+
+    auto& d = **data;
+    if (offset_ == buffer_.size()) {
+      buffer_ = std::move(d);
+      offset_ = 0;
+    } else {
+      buffer_.erase(buffer_.begin(),
+                    buffer_.begin() + static_cast<std::ptrdiff_t>(offset_));
+      offset_ = 0;
+      buffer_.insert(buffer_.end(), d.begin(), d.end());
+    }
+
+    co_return expected<void, std::error_code>();
+  }
+
+  auto pending() const noexcept -> std::string_view
+  {
+    return { reinterpret_cast<const char*>(buffer_.data()) + offset_,
+             buffer_.size() - offset_ };
+  }
+
+  auto take(std::size_t n) -> bytes
+  {
+    if (offset_ == 0 && n == buffer_.size()) {
+      return std::exchange(buffer_, bytes());
+    }
+
+    const auto first = buffer_.begin() + static_cast<std::ptrdiff_t>(offset_);
+    offset_ += n;
+    return bytes(first, first + static_cast<std::ptrdiff_t>(n));
+  }
+
+  void append(std::string_view sv)
+  {
+    const auto data = std::as_bytes(std::span(sv.data(), sv.size()));
+    buffer_.insert(buffer_.end(), data.begin(), data.end());
+  }
+
+  auto fail(std::error_code ec) -> std::error_code
+  {
+    ec_ = ec;
+    state_ = state::done;
+    return ec;
+  }
+
+  any_async_readable_stream body_;
+  std::string delimiter_;
+  bytes buffer_;
+  std::size_t offset_ = 0;
+  state state_ = state::preamble;
+  std::uint64_t generation_ = 0;
+  std::error_code ec_;
+};
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
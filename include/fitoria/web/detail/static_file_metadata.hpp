@@ -0,0 +1,265 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_DETAIL_STATIC_FILE_METADATA_HPP
+#define FITORIA_WEB_DETAIL_STATIC_FILE_METADATA_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/chrono.hpp>
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/net.hpp>
+#include <fitoria/core/optional.hpp>
+#include <fitoria/core/strings.hpp>
+
+#include <fitoria/http.hpp>
+#include <fitoria/mime.hpp>
+
+#include <fitoria/web/detail/async_readable_byteranges_stream.hpp>
+#include <fitoria/web/request.hpp>
+#include <fitoria/web/response.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::detail {
+
+using file_time_point = std::chrono::time_point<std::chrono::file_clock>;
+
+#if defined(BOOST_ASIO_HAS_FILE)
+
+// Opens the file with read-only permission, `File` is either `stream_file` or
+// `random_access_file`.
+template <typename File>
+auto open_file(const executor_type& ex, const std::string& path)
+    -> expected<File, std::error_code>
+{
+  auto file = File(ex);
+
+  boost::system::error_code ec;
+  file.open(path, net::file_base::read_only, ec); // NOLINT
+  if (ec) {
+    return unexpected { ec };
+  }
+
+  return file;
+}
+
+#endif
+
+inline auto get_last_modified_time(const std::string& path)
+    -> expected<file_time_point, std::error_code>
+{
+  std::error_code ec;
+  if (auto time = std::filesystem::last_write_time(path, ec); !ec) {
+    return time;
+  }
+
+  return unexpected { ec };
+}
+
+struct precompressed_encoding {
+  std::string_view content_encoding;
+  std::string_view extension;
+};
+
+// The content codings of precompressed siblings of static files, in the order
+// of preference.
+inline constexpr auto precompressed_encodings
+    = std::array<precompressed_encoding, 3> {
+        precompressed_encoding { "br", ".br" },
+        precompressed_encoding { "zstd", ".zst" },
+        precompressed_encoding { "gzip", ".gz" },
+      };
+
+// Makes the strong ETag of a file. The content coding of a precompressed file
+// is appended, so that each representation has an ETag of its own.
+inline auto get_etag(const std::uint64_t size,
+                     const file_time_point& last_modified_time,
+                     std::string_view content_encoding = {})
+    -> http::header::entity_tag
+{
+  const auto secs = std::chrono::floor<std::chrono::seconds>(
+                        chrono::to_utc(last_modified_time))
+                        .time_since_epoch()
+                        .count();
+  if (content_encoding.empty()) {
+    return http::header::entity_tag::make_strong(
+        fmt::format("{}-{:016x}", size, secs));
+  }
+
+  return http::header::entity_tag::make_strong(
+      fmt::format("{}-{:016x}-{}", size, secs, content_encoding));
+}
+
+inline auto get_content_disposition(const std::string& path,
+                                    const mime::mime_view& ct) -> std::string
+{
+  if (ct.type() == "audio" || ct.type() == "image" || ct.type() == "text"
+      || ct.type() == "video" || ct == mime::application_javascript()
+      || ct == mime::application_json() || ct == mime::application_wasm()) {
+    return fmt::format("inline");
+  }
+
+  auto p = std::filesystem::path(path);
+  return fmt::format(R"(attachment; filename="{}")", p.filename().string());
+}
+
+inline auto check_if_not_modified(
+    const http::header::entity_tag& etag,
+    [[maybe_unused]] const file_time_point& last_modified_time,
+    const http::header_map& headers) -> optional<bool>
+{
+  if (auto header = headers.get(http::field::if_none_match); header) {
+    if (auto m = http::header::if_none_match::parse(*header); m) {
+      return m->is_any()
+          || std::any_of(m->begin(), m->end(), [&](auto& element) {
+               return etag.weakly_equal_to(element);
+             });
+    }
+
+    return nullopt;
+  }
+
+#if defined(FITORIA_HAS_STD_CHRONO_PARSE)
+
+  if (auto header = headers.get(http::field::if_modified_since); header) {
+    if (auto d = http::header::date::parse(*header); d) {
+      return http::header::date(last_modified_time) <= *d;
+    }
+
+    return nullopt;
+  }
+
+#endif
+
+  return false;
+}
+
+// The headers of a static file, rendered once so that they can be reused by
+// the responses of every request for the file.
+struct static_file_metadata {
+  std::uint64_t size;
+  file_time_point last_write_time;
+  http::header::entity_tag etag;
+  std::string etag_str;
+  std::string last_modified_str;
+  std::string content_type_str;
+  std::string content_disposition;
+  std::string unsatisfied_range_str;
+
+  static auto make(const std::string& path,
+                   std::uint64_t size,
+                   const file_time_point& last_write_time)
+      -> static_file_metadata
+  {
+    auto etag = get_etag(size, last_write_time);
+    auto etag_str = etag.to_string();
+    const auto ct = mime::mime_view::from_path(path).value_or(
+        mime::application_octet_stream());
+    return {
+      .size = size,
+      .last_write_time = last_write_time,
+      .etag = std::move(etag),
+      .etag_str = std::move(etag_str),
+      .last_modified_str = http::header::date(last_write_time).to_string(),
+      .content_type_str = std::string(std::string_view(ct)),
+      .content_disposition = get_content_disposition(path, ct),
+      .unsatisfied_range_str = fmt::format("bytes */{}", size),
+    };
+  }
+};
+
+// Creates the response for a static file, handling `Range` / `If-None-Match` /
+// `If-Modified-Since` headers of the request. `set_body(builder, offset,
+// length)` sets the requested range of the file as the body. A request for
+// several ranges is answered with the whole file rather than a
+// `multipart/byteranges` body.
+template <typename SetBody>
+auto make_static_file_response(const static_file_metadata& meta,
+                               const request& req,
+                               SetBody&& set_body) -> response
+{
+  auto not_modified = check_if_not_modified(
+      meta.etag, meta.last_write_time, req.headers());
+  if (!not_modified) {
+    return response::bad_request()
+        .set_header(http::field::accept_ranges, "bytes")
+        .set_header(http::field::content_range, meta.unsatisfied_range_str)
+        .build();
+  }
+  if (*not_modified) {
+    return response::not_modified()
+        .set_header(http::field::last_modified, meta.last_modified_str)
+        .set_header(http::field::etag, meta.etag_str)
+        .set_body("");
+  }
+
+  if (auto header = req.headers().get(http::field::range); header) {
+    auto ranges = std::vector<http::header::range::subrange_t>();
+    if (auto range = http::header::range::parse(*header, meta.size);
+        range && cmp_eq_ci(range->unit(), "bytes")) {
+      std::ranges::copy_if(*range, std::back_inserter(ranges), [&](auto& r) {
+        return r.length > 0 && r.offset + r.length <= meta.size;
+      });
+    }
+    if (ranges.empty()) {
+      return response::range_not_satisfiable()
+          .set_header(http::field::accept_ranges, "bytes")
+          .set_header(http::field::content_range, meta.unsatisfied_range_str)
+          .build();
+    }
+
+    // ranges are coalesced the same way as `static_file` does, several
+    // ranges which remain are answered with the whole file
+    ranges = coalesce_ranges(std::move(ranges));
+    if (ranges.size() == 1) {
+      const auto r = ranges[0];
+      return set_body(
+          response::partial_content()
+              .set_header(http::field::last_modified, meta.last_modified_str)
+              .set_header(http::field::etag, meta.etag_str)
+              .set_header(http::field::content_type, meta.content_type_str)
+              .set_header(http::field::content_disposition,
+                          meta.content_disposition)
+              .set_header(http::field::accept_ranges, "bytes")
+              .set_header(http::field::content_range,
+                          fmt::format("bytes {}-{}/{}",
+                                      r.offset,
+                                      r.offset + r.length - 1,
+                                      meta.size)),
+          r.offset,
+          r.length);
+    }
+  }
+
+  return set_body(
+      response::ok()
+          .set_header(http::field::last_modified, meta.last_modified_str)
+          .set_header(http::field::etag, meta.etag_str)
+          .set_header(http::field::content_type, meta.content_type_str)
+          .set_header(http::field::content_disposition,
+                      meta.content_disposition)
+          .set_header(http::field::accept_ranges, "bytes"),
+      0,
+      meta.size);
+}
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
@@ -18,11 +18,16 @@
 
 #include <fitoria/log.hpp>
 
+#include <fitoria/web/detail/async_spill_body.hpp>
 #include <fitoria/web/detail/make_acceptor.hpp>
 
 #include <fitoria/web/async_message_parser_stream.hpp>
+#include <fitoria/web/async_readable_mmap_stream.hpp>
+#include <fitoria/web/async_readable_shared_buffer_stream.hpp>
+#include <fitoria/web/async_readable_vector_stream.hpp>
 #include <fitoria/web/async_write_chunks.hpp>
 #include <fitoria/web/handler.hpp>
+#include <fitoria/web/memory_budget.hpp>
 #include <fitoria/web/request.hpp>
 #include <fitoria/web/response.hpp>
 #include <fitoria/web/router.hpp>
@@ -60,6 +65,9 @@ class http_server {
               optional<duration_type> request_timeout,
               optional<std::uint32_t> request_header_limit,
               optional<std::uint64_t> request_body_limit,
+              optional<std::uint64_t> request_body_spill_threshold,
+              optional<chunk_coalescing> response_chunk_coalescing,
+              std::shared_ptr<memory_budget> memory_budget,
               optional<exception_handler_t> exception_handler)
       : ex_(std::move(ex))
       , router_(std::move(router))
@@ -69,6 +77,9 @@ class http_server {
       , request_timeout_(request_timeout)
       , request_header_limit_(request_header_limit)
       , request_body_limit_(request_body_limit)
+      , request_body_spill_threshold_(request_body_spill_threshold)
+      , response_chunk_coalescing_(response_chunk_coalescing)
+      , memory_budget_(std::move(memory_budget))
       , exception_handler_(
             exception_handler.value_or(default_exception_handler))
   {
@@ -153,6 +164,37 @@ public:
     return request_body_limit_;
   }
 
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the size in bytes above which client request body is spilled to a
+  /// temporary file.
+  ///
+  /// DESCRIPTION
+  ///   Get the size in bytes above which client request body is spilled to a
+  ///   temporary file. ``nullopt`` indicates the body is streamed to the
+  ///   handler directly.
+  ///
+  /// @endverbatim
+  auto request_body_spill_threshold() const noexcept
+      -> optional<std::uint64_t>
+  {
+    return request_body_spill_threshold_;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the options for coalescing chunks of chunked responses.
+  ///
+  /// DESCRIPTION
+  ///   Get the options for coalescing chunks of chunked responses. ``nullopt``
+  ///   indicates every chunk is written as soon as it is read.
+  ///
+  /// @endverbatim
+  auto response_chunk_coalescing() const noexcept -> optional<chunk_coalescing>
+  {
+    return response_chunk_coalescing_;
+  }
+
   /// @verbatim embed:rst:leading-slashes
   ///
   /// Binds address and create an acceptor for TCP connections.
@@ -304,6 +346,10 @@ private:
   auto do_listen(socket_acceptor<Protocol> acceptor) const -> awaitable<void>
   {
     for (;;) {
+      // leave new connections in the backlog while over budget
+      if (memory_budget_) {
+        co_await memory_budget_->async_wait_available();
+      }
       if (auto socket = co_await acceptor.async_accept(use_awaitable); socket) {
         net::co_spawn(
             ex_,
@@ -319,6 +365,10 @@ private:
                  net::ssl::context& ssl_ctx) const -> awaitable<void>
   {
     for (;;) {
+      // leave new connections in the backlog while over budget
+      if (memory_budget_) {
+        co_await memory_budget_->async_wait_available();
+      }
       if (auto socket = co_await acceptor.async_accept(use_awaitable); socket) {
         net::co_spawn(ex_,
                       do_session(shared_ssl_stream<Protocol>(std::move(*socket),
@@ -394,8 +444,17 @@ private:
     using boost::beast::websocket::is_upgrade;
 
     auto buffer = std::make_shared<flat_buffer>();
+    auto account = memory_budget_
+        ? std::make_shared<memory_budget::account>(memory_budget_)
+        : nullptr;
 
     for (;;) {
+      // buffers of the previous request are released by now
+      if (account) {
+        account->update(buffer->capacity());
+        co_await account->async_wait_available();
+      }
+
       auto parser = std::make_shared<request_parser<buffer_body>>();
       parser->header_limit(request_header_limit_.value_or(UINT32_MAX));
       parser->body_limit(request_body_limit_.value_or(UINT64_MAX));
@@ -418,6 +477,9 @@ private:
           co_return unexpected { bytes_read.error() };
         }
       }
+      if (account) {
+        account->update(buffer->capacity());
+      }
 
       const bool keep_alive = parser->get().keep_alive();
       const bool upgrade = is_upgrade(parser->get());
@@ -429,8 +491,9 @@ private:
 
         // we don't handle expect: 100-continue here,
         // boost::beast::websocket::stream::accept() will do it for us
-        (*session_state)[std::type_index(typeid(websocket))]
-            = websocket(stream);
+        auto ws = websocket(stream);
+        ws.set_memory_account(account);
+        (*session_state)[std::type_index(typeid(websocket))] = std::move(ws);
       } else {
         if (auto it = parser->get().find(http::field::expect);
             it != parser->get().end()
@@ -450,6 +513,35 @@ private:
           url) {
         if (auto route = router_.try_find(parser->get().method(), url->path());
             route) {
+          auto body = [&]() -> any_async_readable_stream {
+            if (parser->get().has_content_length() || parser->get().chunked()) {
+              return async_message_parser_stream(
+                  buffer, stream, parser, account);
+            }
+
+            return async_readable_vector_stream();
+          }();
+#if defined(BOOST_ASIO_HAS_FILE)
+          if (request_body_spill_threshold_ && !upgrade
+              && (parser->get().has_content_length()
+                  || parser->get().chunked())) {
+            if (auto spilled = co_await detail::async_spill_body(
+                    std::move(body), *request_body_spill_threshold_);
+                spilled) {
+              body = std::move(*spilled);
+            } else if (spilled.error()
+                       == make_error_code(
+                           boost::beast::http::error::body_limit)) {
+              res = web::response::payload_too_large()
+                        .set_header(http::field::content_type,
+                                    mime::text_plain())
+                        .set_body("request body size exceeds limit");
+              co_return co_await do_response(stream, res, false);
+            } else {
+              co_return unexpected { spilled.error() };
+            }
+          }
+#endif
           auto req = web::request(
               connect_info(get_lowest_layer(stream).socket()),
               path_info(std::string(route->matcher().pattern()),
@@ -459,14 +551,7 @@ private:
               http::detail::from_impl_version(parser->get().version()),
               http::header_map::from_impl(parser->get()),
               query_map::from(url->params()),
-              [&]() -> any_async_readable_stream {
-                if (parser->get().has_content_length()
-                    || parser->get().chunked()) {
-                  return async_message_parser_stream(buffer, stream, parser);
-                }
-
-                return async_readable_vector_stream();
-              }(),
+              std::move(body),
               route->states().copy_prepend(session_state));
           res = co_await route->operator()(req);
         } else {
@@ -488,7 +573,9 @@ private:
           co_return unexpected { result.error() };
         }
       } else {
-        if (auto exp = co_await do_response(stream, res, keep_alive); !exp) {
+        if (auto exp
+            = co_await do_response(stream, res, keep_alive, account.get());
+            !exp) {
           co_return unexpected { exp.error() };
         }
       }
@@ -502,7 +589,10 @@ private:
   }
 
   template <typename Stream>
-  auto do_response(Stream& stream, response& res, bool keep_alive) const
+  auto do_response(Stream& stream,
+                   response& res,
+                   bool keep_alive,
+                   memory_budget::account* account = nullptr) const
       -> awaitable<expected<void, std::error_code>>
   {
     co_return co_await std::visit(
@@ -510,7 +600,8 @@ private:
                       return do_null_body_response(stream, res, keep_alive);
                     },
                      [&](any_body::sized) {
-                       return do_sized_response(stream, res, keep_alive);
+                       return do_sized_response(
+                           stream, res, keep_alive, account);
                      },
                      [&](any_body::chunked) {
                        return do_chunked_response(stream, res, keep_alive);
@@ -542,13 +633,24 @@ private:
   }
 
   template <typename Stream>
-  auto do_sized_response(Stream& stream, response& res, bool keep_alive) const
+  auto do_sized_response(Stream& stream,
+                         response& res,
+                         bool keep_alive,
+                         memory_budget::account* account) const
       -> awaitable<expected<void, std::error_code>>
   {
+    // a body in memory is sent along with the headers in a single write
+    if (auto size = std::get<any_body::sized>(res.body().size()).size;
+        size && !res.body().stream().target<async_readable_vector_stream>()) {
+      co_return co_await do_sized_stream_response(
+          stream, res, keep_alive, *size, account);
+    }
+
     using boost::beast::http::response;
-    using boost::beast::http::vector_body;
+    using bytes_body = boost::beast::http::vector_body<bytes::value_type,
+                                                       bytes::allocator_type>;
 
-    auto r = response<vector_body<std::byte>>(
+    auto r = response<bytes_body>(
         res.status().value(), http::detail::to_impl_version(res.version()));
     res.headers().to_impl(r);
     if (auto data = co_await async_read_until_eof<bytes>(res.body().stream());
@@ -557,12 +659,107 @@ private:
     } else if (data.error() != make_error_code(net::error::eof)) {
       co_return unexpected { data.error() };
     }
+    if (account) {
+      // released when the next request starts
+      account->charge(r.body().size());
+    }
     r.keep_alive(keep_alive);
     r.prepare_payload();
 
     co_return co_await async_write(stream, r, use_awaitable);
   }
 
+  template <typename Stream>
+  auto do_sized_stream_response(Stream& stream,
+                                response& res,
+                                bool keep_alive,
+                                std::size_t size,
+                                memory_budget::account* account) const
+      -> awaitable<expected<void, std::error_code>>
+  {
+    using boost::beast::http::buffer_body;
+    using boost::beast::http::response;
+    using boost::beast::http::response_serializer;
+    using beast_error = boost::beast::http::error;
+
+    auto r = response<buffer_body>(
+        res.status().value(), http::detail::to_impl_version(res.version()));
+    res.headers().to_impl(r);
+    r.keep_alive(keep_alive);
+    r.content_length(size);
+    r.body().data = nullptr;
+    r.body().more = true;
+
+    auto ser = response_serializer<buffer_body>(r);
+
+    // a mapped file or a shared buffer is written straight from memory along
+    // with the headers, instead of being copied out chunk by chunk
+    auto in_memory = [&]() -> optional<std::span<const std::byte>> {
+      auto& body = res.body().stream();
+      if (auto s = body.target<async_readable_mmap_stream>(); s) {
+        return s->remaining();
+      }
+      if (auto s = body.target<async_readable_shared_buffer_stream>(); s) {
+        return s->remaining();
+      }
+      return nullopt;
+    }();
+    if (in_memory) {
+      const auto data = *in_memory;
+      if (data.size() != size) {
+        co_return unexpected { make_error_code(
+            data.size() > size ? beast_error::body_limit
+                               : beast_error::partial_message) };
+      }
+
+      r.body().data = const_cast<std::byte*>(data.data());
+      r.body().size = data.size();
+      r.body().more = false;
+      co_return co_await async_write(stream, ser, use_awaitable);
+    }
+
+    // the body is written chunk by chunk as it is read, the headers go out
+    // along with the first chunk, and the declared length is enforced since
+    // the headers may already be sent
+    std::size_t written = 0;
+    for (auto data = co_await res.body().stream().async_read_some(); data;
+         data = co_await res.body().stream().async_read_some()) {
+      auto& d = *data;
+      if (!d) {
+        co_return unexpected { d.error() };
+      }
+      if (d->empty()) {
+        continue;
+      }
+      if (d->size() > size - written) {
+        co_return unexpected { make_error_code(beast_error::body_limit) };
+      }
+
+      r.body().data = d->data();
+      r.body().size = d->size();
+      if (account) {
+        account->charge(d->size());
+      }
+      auto result = co_await async_write(stream, ser, use_awaitable);
+      if (account) {
+        account->credit(d->size());
+      }
+      if (!result
+          && result.error() != make_error_code(beast_error::need_buffer)) {
+        co_return unexpected { result.error() };
+      }
+      written += d->size();
+    }
+
+    if (written != size) {
+      co_return unexpected { make_error_code(beast_error::partial_message) };
+    }
+
+    r.body().data = nullptr;
+    r.body().more = false;
+    co_return co_await async_write(stream, ser, use_awaitable);
+  }
+
   template <typename Stream>
   auto do_chunked_response(Stream& stream, response& res, bool keep_alive) const
       -> awaitable<expected<void, std::error_code>>
@@ -584,7 +781,8 @@ private:
       co_return unexpected { result.error() };
     }
 
-    co_return co_await async_write_chunks(stream, res.body().stream());
+    co_return co_await async_write_chunks(
+        stream, res.body().stream(), response_chunk_coalescing_);
   }
 
 #if FITORIA_NO_EXCEPTIONS
@@ -614,6 +812,9 @@ private:
   optional<duration_type> request_timeout_;
   optional<std::uint32_t> request_header_limit_;
   optional<std::uint64_t> request_body_limit_;
+  optional<std::uint64_t> request_body_spill_threshold_;
+  optional<chunk_coalescing> response_chunk_coalescing_;
+  std::shared_ptr<memory_budget> memory_budget_;
   exception_handler_t exception_handler_;
 };
 
@@ -739,6 +940,95 @@ public:
     return std::move(*this);
   }
 
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Set the size in bytes above which client request body is spilled to a
+  /// temporary file.
+  ///
+  /// DESCRIPTION
+  ///   Set the size in bytes above which client request body is spilled to a
+  ///   temporary file. The body is read before invoking the handler, it is
+  ///   kept in memory as long as it does not exceed ``threshold``, otherwise
+  ///   it is written into an anonymous temporary file (``O_TMPFILE`` if
+  ///   available) which is removed once the request is finished. Either way
+  ///   the handler reads ``request::body()`` as usual, and a spilled body can
+  ///   be accessed as a file through
+  ///   ``request::body().target<async_readable_file_stream>()``. This allows
+  ///   a large ``request_body_limit`` without letting concurrent uploads
+  ///   exhaust memory. Only takes effect if file support
+  ///   (``BOOST_ASIO_HAS_FILE``) is available. Pass ``nullopt`` to stream the
+  ///   body to the handler directly. Default is ``nullopt``.
+  ///
+  /// @endverbatim
+  auto set_request_body_spill_threshold(
+      optional<std::uint64_t> threshold) & noexcept -> builder&
+  {
+    request_body_spill_threshold_ = threshold;
+    return *this;
+  }
+
+  auto set_request_body_spill_threshold(
+      optional<std::uint64_t> threshold) && noexcept -> builder&&
+  {
+    set_request_body_spill_threshold(threshold);
+    return std::move(*this);
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Set the options for coalescing chunks of chunked responses.
+  ///
+  /// DESCRIPTION
+  ///   Set the options for coalescing chunks of chunked responses. Small chunks
+  ///   yielded by a stream body are batched into a single chunk, which saves
+  ///   syscalls and TLS records. Pass ``nullopt`` to write every chunk as soon
+  ///   as it is read. Default is ``nullopt``.
+  ///
+  /// @endverbatim
+  auto set_response_chunk_coalescing(
+      optional<chunk_coalescing> coalescing) & noexcept -> builder&
+  {
+    response_chunk_coalescing_ = coalescing;
+    return *this;
+  }
+
+  auto set_response_chunk_coalescing(
+      optional<chunk_coalescing> coalescing) && noexcept -> builder&&
+  {
+    set_response_chunk_coalescing(coalescing);
+    return std::move(*this);
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Set the ``memory_budget`` charged by the connections of the server.
+  ///
+  /// DESCRIPTION
+  ///   Set the ``memory_budget`` charged by the connections of the server. The
+  ///   same budget can be shared by multiple servers to bound the memory of
+  ///   the whole process. While the budget is exceeded, new connections are
+  ///   deferred and sessions pause before reading the next request, until the
+  ///   usage is back under the limit or the ``max_pause`` of the budget
+  ///   elapses, 1 second by default, whichever comes first. Request bodies are
+  ///   charged only while a buffer is being read, not once handed off to the
+  ///   handler. Pass ``nullptr`` to disable the accounting. Default is
+  ///   ``nullptr``.
+  ///
+  /// @endverbatim
+  auto set_memory_budget(std::shared_ptr<memory_budget> budget) & noexcept
+      -> builder&
+  {
+    memory_budget_ = std::move(budget);
+    return *this;
+  }
+
+  auto set_memory_budget(std::shared_ptr<memory_budget> budget) && noexcept
+      -> builder&&
+  {
+    set_memory_budget(std::move(budget));
+    return std::move(*this);
+  }
+
 #if !FITORIA_NO_EXCEPTIONS
 
   /// @verbatim embed:rst:leading-slashes
@@ -852,6 +1142,9 @@ public:
              request_timeout_,
              request_header_limit_,
              request_body_limit_,
+             request_body_spill_threshold_,
+             response_chunk_coalescing_,
+             memory_budget_,
              std::move(exception_handler_) };
   }
 
@@ -863,6 +1156,9 @@ private:
   optional<duration_type> request_timeout_ = std::chrono::seconds(5);
   optional<std::uint32_t> request_header_limit_ = 8 * 1024;
   optional<std::uint64_t> request_body_limit_ = 1 * 1024 * 1024;
+  optional<std::uint64_t> request_body_spill_threshold_;
+  optional<chunk_coalescing> response_chunk_coalescing_;
+  std::shared_ptr<memory_budget> memory_budget_;
   optional<exception_handler_t> exception_handler_;
 };
 
@@ -17,13 +17,15 @@
 #include <fitoria/web/error.hpp>
 #include <fitoria/web/from_request.hpp>
 
+#include <system_error>
+
 FITORIA_NAMESPACE_BEGIN
 
 namespace web {
 
 #if !defined(FITORIA_DOC)
 
-template <typename T>
+template <typename T, std::uint64_t Limit = 1 * 1024 * 1024>
 class json_of : public T {
 public:
   static_assert(not_cvref<T>, "T must not be cvref qualified");
@@ -33,8 +35,8 @@ public:
   {
   }
 
-  friend auto tag_invoke(from_request_t<json_of<T>>, request& req)
-      -> awaitable<expected<json_of<T>, response>>
+  friend auto tag_invoke(from_request_t<json_of<T, Limit>>, request& req)
+      -> awaitable<expected<json_of<T, Limit>, response>>
   {
     if (auto mime = req.headers()
                         .get(http::field::content_type)
@@ -48,13 +50,15 @@ public:
       };
     }
 
-    auto body = co_await from_request<std::string>(req);
-    if (!body) {
-      co_return unexpected { body.error() };
-    }
-
-    if (auto form = detail::as_json<T>(*body); form) {
-      co_return std::move(*form);
+    if (auto json = co_await detail::async_read_json<T>(req.body(), Limit);
+        json) {
+      co_return std::move(*json);
+    } else if (json.error() == std::errc::message_size) {
+      co_return unexpected {
+        response::payload_too_large()
+            .set_header(http::field::content_type, mime::text_plain())
+            .set_body("request body is too large.")
+      };
     } else {
       co_return unexpected {
         response::bad_request()
@@ -71,8 +75,13 @@ public:
 ///
 /// Extractor for parsing json into type ``T``.
 ///
+/// DESCRIPTION
+///   Extractor for parsing json into type ``T``. The request body is fed into
+///   the json parser chunk by chunk as it arrives, and the request is rejected
+///   with ``413 Payload Too Large`` once the body exceeds ``Limit`` bytes.
+///
 /// @endverbatim
-template <typename T>
+template <typename T, std::uint64_t Limit = 1 * 1024 * 1024>
 class json_of;
 
 #endif
@@ -0,0 +1,262 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_MEMORY_BUDGET_HPP
+#define FITORIA_WEB_MEMORY_BUDGET_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/net.hpp>
+#include <fitoria/core/optional.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web {
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// A process-wide budget of memory held by connection buffers.
+///
+/// DESCRIPTION
+///   A process-wide budget of memory held by connection buffers. Servers
+///   sharing the budget charge it for the connection buffers, request body
+///   buffers being read, in-memory response bodies and websocket messages
+///   they hold, and credit it once those are released or handed off. While
+///   ``usage()`` exceeds ``limit()``, new connections are not accepted and
+///   sessions pause before reading the next request or message, until a
+///   credit brings ``usage()`` back under ``limit()``.
+///
+///   If ``max_pause`` is set, a pause lasts ``max_pause`` at most, after which
+///   the connection goes ahead even though the budget is still exceeded, so
+///   that idle connections whose buffers hold the budget themselves can never
+///   stall each other forever. The limit is then a soft one: it delays new
+///   work instead of refusing it. Pass ``nullopt`` to pause until the budget
+///   is available however long it takes. Default is 1 second.
+///
+///   ``usage()`` can be exported as a gauge.
+///
+/// @endverbatim
+class memory_budget {
+public:
+  class account;
+
+  explicit memory_budget(std::uint64_t limit,
+                         optional<std::chrono::steady_clock::duration> max_pause
+                         = std::chrono::seconds(1))
+      : limit_(limit)
+      , max_pause_(max_pause)
+  {
+  }
+
+  memory_budget(const memory_budget&) = delete;
+
+  memory_budget& operator=(const memory_budget&) = delete;
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the limit in bytes.
+  ///
+  /// @endverbatim
+  auto limit() const noexcept -> std::uint64_t
+  {
+    return limit_;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the number of bytes currently charged.
+  ///
+  /// @endverbatim
+  auto usage() const noexcept -> std::uint64_t
+  {
+    return usage_.load(std::memory_order_relaxed);
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Check whether the usage exceeds the limit.
+  ///
+  /// @endverbatim
+  auto exceeded() const noexcept -> bool
+  {
+    return usage() > limit_;
+  }
+
+  void charge(std::uint64_t size) noexcept
+  {
+    usage_.fetch_add(size, std::memory_order_relaxed);
+  }
+
+  void credit(std::uint64_t size) noexcept
+  {
+    const auto usage = usage_.fetch_sub(size, std::memory_order_relaxed);
+    if (usage > limit_ && usage - size <= limit_) {
+      notify_all();
+    }
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Suspend while the usage exceeds the limit.
+  ///
+  /// DESCRIPTION
+  ///   Suspend until a credit brings the usage back under the limit, or for
+  ///   ``max_pause`` at most if it is set.
+  ///
+  /// @endverbatim
+  auto async_wait_available() -> awaitable<void>
+  {
+    using boost::asio::experimental::awaitable_operators::operator||;
+
+    if (!exceeded()) {
+      co_return;
+    }
+
+    // credits are made by other sessions which may run on other threads, the
+    // thread-safe channel wakes this one up on its own executor
+    auto waiter = waiter_guard(*this, co_await net::this_coro::executor);
+
+    // the usage may have dropped before the waiter is registered
+    if (exceeded()) {
+      if (max_pause_) {
+        auto timer = net::steady_timer(co_await net::this_coro::executor);
+        timer.expires_after(*max_pause_);
+        co_await (waiter.channel().async_receive(use_awaitable)
+                  || timer.async_wait(use_awaitable));
+      } else {
+        co_await waiter.channel().async_receive(use_awaitable);
+      }
+    }
+  }
+
+private:
+  using waiter_t = net::experimental::concurrent_channel<
+      executor_type,
+      void(boost::system::error_code)>;
+
+  // keeps a waiter registered until the wait ends or is destroyed
+  class waiter_guard {
+  public:
+    waiter_guard(memory_budget& budget, const executor_type& ex)
+        : budget_(budget)
+    {
+      auto lock = std::lock_guard(budget_.mutex_);
+      it_ = budget_.waiters_.emplace(budget_.waiters_.end(), ex, 1);
+    }
+
+    waiter_guard(const waiter_guard&) = delete;
+
+    waiter_guard& operator=(const waiter_guard&) = delete;
+
+    ~waiter_guard()
+    {
+      auto lock = std::lock_guard(budget_.mutex_);
+      budget_.waiters_.erase(it_);
+    }
+
+    auto channel() noexcept -> waiter_t&
+    {
+      return *it_;
+    }
+
+  private:
+    memory_budget& budget_;
+    std::list<waiter_t>::iterator it_;
+  };
+
+  void notify_all() noexcept
+  {
+    auto lock = std::lock_guard(mutex_);
+    for (auto& waiter : waiters_) {
+      waiter.try_send(boost::system::error_code());
+    }
+  }
+
+  std::uint64_t limit_;
+  optional<std::chrono::steady_clock::duration> max_pause_;
+  std::atomic<std::uint64_t> usage_ = 0;
+  std::mutex mutex_;
+  std::list<waiter_t> waiters_;
+};
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// The share of a ``memory_budget`` charged by a single connection.
+///
+/// DESCRIPTION
+///   The share of a ``memory_budget`` charged by a single connection. Whatever
+///   is still charged is credited back to the budget on destruction.
+///
+/// @endverbatim
+class memory_budget::account {
+public:
+  explicit account(std::shared_ptr<memory_budget> budget)
+      : budget_(std::move(budget))
+  {
+  }
+
+  account(const account&) = delete;
+
+  account& operator=(const account&) = delete;
+
+  ~account()
+  {
+    budget_->credit(balance_);
+  }
+
+  auto balance() const noexcept -> std::uint64_t
+  {
+    return balance_;
+  }
+
+  void charge(std::uint64_t size) noexcept
+  {
+    balance_ += size;
+    budget_->charge(size);
+  }
+
+  void credit(std::uint64_t size) noexcept
+  {
+    size = std::min(size, balance_);
+    balance_ -= size;
+    budget_->credit(size);
+  }
+
+  // Charges or credits the difference, so that `size` bytes are charged.
+  void update(std::uint64_t size) noexcept
+  {
+    if (size > balance_) {
+      charge(size - balance_);
+    } else {
+      credit(balance_ - size);
+    }
+  }
+
+  auto async_wait_available() const -> awaitable<void>
+  {
+    return budget_->async_wait_available();
+  }
+
+private:
+  std::shared_ptr<memory_budget> budget_;
+  std::uint64_t balance_ = 0;
+};
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
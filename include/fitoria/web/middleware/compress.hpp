@@ -0,0 +1,623 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_MIDDLEWARE_COMPRESS_HPP
+#define FITORIA_WEB_MIDDLEWARE_COMPRESS_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/format.hpp>
+#include <fitoria/core/net.hpp>
+#include <fitoria/core/optional.hpp>
+#include <fitoria/core/strings.hpp>
+#include <fitoria/core/type_traits.hpp>
+#include <fitoria/core/utility.hpp>
+
+#include <fitoria/http.hpp>
+
+#include <fitoria/web/async_readable_shared_buffer_stream.hpp>
+#include <fitoria/web/async_readable_vector_stream.hpp>
+#include <fitoria/web/middleware/compress_cache.hpp>
+#include <fitoria/web/middleware/compress_dictionary.hpp>
+#include <fitoria/web/middleware/detail/async_brotli_deflate_stream.hpp>
+#include <fitoria/web/middleware/detail/async_gzip_deflate_stream.hpp>
+#include <fitoria/web/middleware/detail/async_zstd_deflate_stream.hpp>
+#include <fitoria/web/middleware/detail/context_pool.hpp>
+#include <fitoria/web/middleware/detail/offload.hpp>
+#include <fitoria/web/request.hpp>
+#include <fitoria/web/response.hpp>
+#include <fitoria/web/to_middleware.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::middleware {
+
+template <typename Request, typename Response, typename Next>
+class compress_middleware {
+  friend class compress;
+
+public:
+  auto operator()(Request req) const -> Response
+  {
+    auto res = co_await next_(req);
+    if (req.method() == http::verb::head || !is_compressible(res)) {
+      co_return res;
+    }
+
+    auto vary = add_vary(res.headers().get(http::field::vary),
+                         "Accept-Encoding");
+    auto encoding = negotiate(req.headers());
+    if (dictionary_) {
+      vary = add_vary(vary, "Available-Dictionary");
+      if (auto coding = dictionary_->negotiate(req.headers()); coding) {
+        // dictionary codings are used for bodies which are in memory only
+        if (res.body().stream().target<async_readable_vector_stream>()) {
+          encoding = coding;
+        }
+      } else if (!dictionary_->url().empty()) {
+        auto link = fmt::format(R"(<{}>; rel="compression-dictionary")",
+                                dictionary_->url());
+        res = res.builder().insert_header(http::field::link, link).build();
+      }
+    }
+    auto etag = optional<http::header::entity_tag>();
+    if (cache_) {
+      etag = strong_etag(res);
+    }
+    // `If-None-Match` yields 304 for GET and HEAD only, HEAD is passed through
+    // above
+    if (etag && req.method() == http::verb::get
+        && is_not_modified(req, *etag)) {
+      co_return not_modified(res, *etag, encoding.has_value(), vary);
+    }
+
+    if (encoding) {
+      if (auto* buffer
+          = res.body().stream().target<async_readable_vector_stream>();
+          buffer) {
+        auto cached = optional<cached_t>();
+        if (etag) {
+          cached = cached_t { cache_target(req),
+                              etag->value(),
+                              cache_coding(*encoding) };
+        }
+        co_return co_await encode_buffer(
+            std::move(res), *buffer, *encoding, vary, cached);
+      }
+      co_return encode(std::move(res), *encoding, vary, executor_);
+    }
+
+    // the representation depends on `Accept-Encoding` even if it is not
+    // compressed for this request
+    co_return res.builder().set_header(http::field::vary, vary).build();
+  }
+
+private:
+  // qualities tuned for compressing responses on the fly
+  static constexpr std::uint32_t brotli_quality = 4;
+  static constexpr int gzip_level = 6;
+  static constexpr int zstd_level = 3;
+
+  // the request target, the strong `ETag` and the content coding a body is
+  // cached for
+  struct cached_t {
+    std::string target;
+    std::string etag;
+    std::string coding;
+  };
+
+  template <typename Next2>
+  compress_middleware(Next2&& next,
+                      std::size_t threshold,
+                      optional<net::any_io_executor> executor,
+                      std::shared_ptr<compress_cache> cache,
+                      optional<compress_dictionary> dictionary)
+      : next_(std::forward<Next2>(next))
+      , threshold_(threshold)
+      , executor_(std::move(executor))
+      , cache_(std::move(cache))
+      , dictionary_(std::move(dictionary))
+  {
+  }
+
+  // Compresses a body which is in memory already as a whole, the result is
+  // sent with its exact `Content-Length`. The body is sent as is if it does
+  // not shrink.
+  auto encode_buffer(response res,
+                     async_readable_vector_stream& stream,
+                     std::string_view encoding,
+                     const std::string& vary,
+                     const optional<cached_t>& cached) const
+      -> awaitable<response>
+  {
+    if (cached) {
+      if (auto hit
+          = cache_->find(cached->target, cached->etag, cached->coding);
+          hit) {
+        const auto size = hit->size();
+        co_return encoded_builder(res, encoding, vary)
+            .set_body(async_readable_shared_buffer_stream(std::move(hit)),
+                      size);
+      }
+    }
+
+    auto data = bytes();
+    if (auto chunk = co_await stream.async_read_some(); chunk && *chunk) {
+      data = std::move(**chunk);
+    }
+
+    auto compressed = co_await detail::offload(
+        executor_, [&] { return compress_buffer(data, encoding); });
+    if (!compressed || compressed->size() >= data.size()) {
+      const auto size = data.size();
+      co_return res.builder()
+          .set_header(http::field::vary, vary)
+          .set_body(async_readable_vector_stream(std::move(data)), size);
+    }
+
+    if (cached) {
+      auto shared = std::make_shared<const bytes>(std::move(*compressed));
+      cache_->insert(cached->target, cached->etag, cached->coding, shared);
+      const auto size = shared->size();
+      co_return encoded_builder(res, encoding, vary)
+          .set_body(async_readable_shared_buffer_stream(std::move(shared)),
+                    size);
+    }
+
+    const auto size = compressed->size();
+    co_return encoded_builder(res, encoding, vary)
+        .set_body(async_readable_vector_stream(std::move(*compressed)), size);
+  }
+
+  static auto strong_etag(const response& res)
+      -> optional<http::header::entity_tag>
+  {
+    if (auto header = res.headers().get(http::field::etag); header) {
+      if (auto etag = http::header::entity_tag::parse(*header);
+          etag && etag->strong()) {
+        return etag;
+      }
+    }
+
+    return nullopt;
+  }
+
+  static auto is_not_modified(const request& req,
+                              const http::header::entity_tag& etag) -> bool
+  {
+    if (auto header = req.headers().get(http::field::if_none_match); header) {
+      if (auto m = http::header::if_none_match::parse(*header); m) {
+        // `If-None-Match` uses the weak comparison, so that the weak `ETag`
+        // of a compressed representation matches as well
+        return m->is_any()
+            || std::ranges::any_of(
+                   *m, [&](auto& e) { return etag.weakly_equal_to(e); });
+      }
+    }
+
+    return false;
+  }
+
+  static auto not_modified(const response& res,
+                           const http::header::entity_tag& etag,
+                           bool encoded,
+                           const std::string& vary) -> response
+  {
+    auto builder = response::not_modified();
+    builder.set_header(http::field::etag,
+                       encoded ? http::header::entity_tag(etag)
+                                     .set_strong(false)
+                                     .to_string()
+                               : etag.to_string())
+        .set_header(http::field::vary, vary);
+    for (auto field : { http::field::cache_control,
+                        http::field::content_location,
+                        http::field::expires }) {
+      if (auto value = res.headers().get(field); value) {
+        builder.set_header(field, *value);
+      }
+    }
+
+    return builder.set_body("");
+  }
+
+  static auto cache_target(const request& req) -> std::string
+  {
+    if (req.query().empty()) {
+      return req.path().match_path();
+    }
+
+    return fmt::format(
+        "{}?{}", req.path().match_path(), req.query().to_string());
+  }
+
+  // A body compressed with a dictionary coding depends on the dictionary too,
+  // which is identified by its hash.
+  auto cache_coding(std::string_view encoding) const -> std::string
+  {
+    if (dictionary_ && (encoding == "dcb" || encoding == "dcz")) {
+      return fmt::format(
+          "{};{}", encoding, dictionary_->available_dictionary());
+    }
+
+    return std::string(encoding);
+  }
+
+  auto compress_buffer(std::span<const std::byte> input,
+                       std::string_view encoding) const
+      -> expected<bytes, std::error_code>
+  {
+    if (dictionary_ && (encoding == "dcb" || encoding == "dcz")) {
+      return dictionary_->compress(input, encoding);
+    }
+#if defined(FITORIA_HAS_BROTLI)
+    if (encoding == "br") {
+      return detail::brotli_encoder::compress(input, brotli_quality);
+    }
+#endif
+#if defined(FITORIA_HAS_ZSTD)
+    if (encoding == "zstd") {
+      return detail::context_pool<detail::zstd_encoder>::acquire(zstd_level)
+          ->compress(input);
+    }
+#endif
+#if defined(FITORIA_HAS_ZLIB)
+    if (encoding == "gzip") {
+      return detail::context_pool<detail::gzip_deflate_stream>::acquire(
+                 gzip_level)
+          ->compress(input);
+    }
+#endif
+
+    return unexpected { make_error_code(std::errc::not_supported) };
+  }
+
+  static auto encode(response res,
+                     std::string_view encoding,
+                     const std::string& vary,
+                     const optional<net::any_io_executor>& executor)
+      -> response
+  {
+    auto body = std::move(res.body().stream());
+    auto builder = encoded_builder(res, encoding, vary);
+
+#if defined(FITORIA_HAS_BROTLI)
+    if (encoding == "br") {
+      return builder.set_stream_body(detail::async_brotli_deflate_stream(
+          std::move(body), brotli_quality, executor));
+    }
+#endif
+#if defined(FITORIA_HAS_ZSTD)
+    if (encoding == "zstd") {
+      return builder.set_stream_body(detail::async_zstd_deflate_stream(
+          std::move(body), zstd_level, executor));
+    }
+#endif
+#if defined(FITORIA_HAS_ZLIB)
+    if (encoding == "gzip") {
+      return builder.set_stream_body(detail::async_gzip_deflate_stream(
+          std::move(body), gzip_level, executor));
+    }
+#endif
+
+    // `negotiate()` only yields the codings above
+    return builder.set_stream_body(std::move(body));
+  }
+
+  // Takes the headers of `res` for the representation encoded with
+  // `encoding`. The body of `res` is moved into the builder.
+  static auto encoded_builder(response& res,
+                              std::string_view encoding,
+                              const std::string& vary) -> response_builder
+  {
+    auto weak_etag = std::string();
+    if (auto etag = res.headers().get(http::field::etag);
+        etag && etag->starts_with('"')) {
+      // the compressed content is not byte-for-byte identical
+      weak_etag = fmt::format("W/{}", *etag);
+    }
+
+    auto builder = res.builder();
+    builder.set_header(http::field::vary, vary)
+        .set_header(http::field::content_encoding, encoding);
+    if (!weak_etag.empty()) {
+      builder.set_header(http::field::etag, weak_etag);
+    }
+    builder.headers().erase(http::field::content_length);
+    builder.headers().erase(http::field::accept_ranges);
+
+    return builder;
+  }
+
+  auto is_compressible(const response& res) const -> bool
+  {
+    const auto status = res.status().value();
+    if (res.status().category() != http::status_class::successful
+        || status == http::status::no_content
+        || status == http::status::partial_content) {
+      return false;
+    }
+    if (res.headers().contains(http::field::content_encoding)) {
+      return false;
+    }
+    if (auto cc = res.headers().get(http::field::cache_control);
+        cc && contains_token(*cc, "no-transform")) {
+      return false;
+    }
+    if (auto ct = res.headers().get(http::field::content_type);
+        ct && !is_compressible_type(*ct)) {
+      return false;
+    }
+
+    return std::visit(overloaded {
+                          [](any_body::null) { return false; },
+                          [&](any_body::sized s) {
+                            return !s.size || *s.size >= threshold_;
+                          },
+                          [](any_body::chunked) { return true; },
+                      },
+                      res.body().size());
+  }
+
+  // Picks the supported content coding of the highest quality, ties are
+  // broken in the order of `codings`.
+  static auto negotiate(const http::header_map& headers)
+      -> optional<std::string_view>
+  {
+    constexpr auto codings = std::array<std::string_view, 3> {
+#if defined(FITORIA_HAS_BROTLI)
+      "br",
+#else
+      "",
+#endif
+#if defined(FITORIA_HAS_ZSTD)
+      "zstd",
+#else
+      "",
+#endif
+#if defined(FITORIA_HAS_ZLIB)
+      "gzip",
+#else
+      "",
+#endif
+    };
+
+    auto header = headers.get(http::field::accept_encoding);
+    if (!header) {
+      return nullopt;
+    }
+    auto ae = http::header::accept_encoding::parse(*header);
+    if (!ae) {
+      return nullopt;
+    }
+
+    auto best = optional<std::string_view>();
+    std::uint16_t best_quality = 0;
+    for (auto coding : codings) {
+      if (coding.empty()) {
+        continue;
+      }
+      if (auto q = ae->quality(coding); q > best_quality) {
+        best = coding;
+        best_quality = q;
+      }
+    }
+
+    return best;
+  }
+
+  static auto is_compressible_type(std::string_view ct) -> bool
+  {
+    // media types which are compressed already, or which must be delivered
+    // without being buffered by the compressor
+    constexpr auto excluded = std::array<std::string_view, 14> {
+      "application/gzip",
+      "application/octet-stream",
+      "application/pdf",
+      "application/vnd.rar",
+      "application/x-7z-compressed",
+      "application/x-bzip2",
+      "application/x-gzip",
+      "application/x-rar-compressed",
+      "application/x-xz",
+      "application/zip",
+      "application/zstd",
+      "font/woff",
+      "font/woff2",
+      "text/event-stream",
+    };
+
+    auto type = trim(ct.substr(0, ct.find(';')));
+    if (auto pos = type.find('/'); pos != std::string_view::npos) {
+      auto top = type.substr(0, pos);
+      if (cmp_eq_ci(top, "audio") || cmp_eq_ci(top, "video")) {
+        return false;
+      }
+      if (cmp_eq_ci(top, "image")) {
+        return cmp_eq_ci(type, "image/svg+xml");
+      }
+    }
+
+    return std::ranges::none_of(
+        excluded, [&](auto e) { return cmp_eq_ci(type, e); });
+  }
+
+  static auto add_vary(optional<std::string_view> vary,
+                       std::string_view field) -> std::string
+  {
+    if (!vary || trim(*vary).empty()) {
+      return std::string(field);
+    }
+    if (contains_token(*vary, "*") || contains_token(*vary, field)) {
+      return std::string(*vary);
+    }
+
+    return fmt::format("{}, {}", *vary, field);
+  }
+
+  static auto contains_token(std::string_view list, std::string_view token)
+      -> bool
+  {
+    return std::ranges::any_of(split_of(list, ","), [&](auto t) {
+      return cmp_eq_ci(t, token);
+    });
+  }
+
+  Next next_;
+  std::size_t threshold_;
+  optional<net::any_io_executor> executor_;
+  std::shared_ptr<compress_cache> cache_;
+  optional<compress_dictionary> dictionary_;
+};
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// Middleware for compressing the response body.
+///
+/// DESCRIPTION
+///   Middleware for compressing the response body with the content coding
+///   preferred by the request's ``Accept-Encoding``, ``br``, ``zstd`` and
+///   ``gzip`` are supported. Successful responses are compressed unless they
+///   are smaller than the threshold, are already encoded, are marked
+///   ``no-transform``, or have a media type which is compressed already, e.g.
+///   images, audio, video and archives. A body which is in memory already, e.g.
+///   set by ``set_body()`` or ``set_json()``, is compressed in a single call
+///   and sent with its exact ``Content-Length``, or as is if it does not
+///   shrink; other bodies are compressed as a stream body. ``Content-Encoding``
+///   is set, a strong ``ETag`` is turned into a weak one, and ``Vary:
+///   Accept-Encoding`` is added to every compressible response.
+///   Small bodies of similar content, e.g. JSON of an API, compress several
+///   times better with a ``compress_dictionary`` set by ``set_dictionary()``.
+///
+/// @endverbatim
+class compress {
+public:
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Set the minimum size of a body of known size to be compressed. Default
+  /// is 1024 bytes.
+  ///
+  /// @endverbatim
+  auto set_threshold(std::size_t threshold) & noexcept -> compress&
+  {
+    threshold_ = threshold;
+    return *this;
+  }
+
+  auto set_threshold(std::size_t threshold) && noexcept -> compress&&
+  {
+    set_threshold(threshold);
+    return std::move(*this);
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Set the executor on which the body is compressed, e.g. the executor of a
+  /// ``net::thread_pool`` reserved for compression. The connection awaits each
+  /// compressed block before reading the next one from the body, so blocks
+  /// stay in order and a slow pool slows down the response rather than
+  /// buffering it. By default the body is compressed on the executor of the
+  /// connection.
+  ///
+  /// @endverbatim
+  auto set_executor(net::any_io_executor executor) & -> compress&
+  {
+    executor_ = std::move(executor);
+    return *this;
+  }
+
+  auto set_executor(net::any_io_executor executor) && -> compress&&
+  {
+    set_executor(std::move(executor));
+    return std::move(*this);
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Set the ``compress_cache`` keeping compressed bodies of responses with a
+  /// strong ``ETag``. With a cache, a request whose ``If-None-Match`` matches
+  /// the ``ETag`` of the response is answered with ``304 Not Modified``
+  /// without compressing anything. By default nothing is cached.
+  ///
+  /// @endverbatim
+  auto set_cache(std::shared_ptr<compress_cache> cache) & -> compress&
+  {
+    cache_ = std::move(cache);
+    return *this;
+  }
+
+  auto set_cache(std::shared_ptr<compress_cache> cache) && -> compress&&
+  {
+    set_cache(std::move(cache));
+    return std::move(*this);
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Set the ``compress_dictionary`` for the ``dcb`` and ``dcz`` content
+  /// codings. A body which is in memory is compressed with the dictionary if
+  /// the request announces it in ``Available-Dictionary`` and accepts either
+  /// coding, otherwise the dictionary is advertised by ``Link`` if its
+  /// ``url`` is set. ``Vary: Available-Dictionary`` is added to every
+  /// compressible response. By default no dictionary is used.
+  ///
+  /// @endverbatim
+  auto set_dictionary(compress_dictionary dictionary) & -> compress&
+  {
+    dictionary_ = std::move(dictionary);
+    return *this;
+  }
+
+  auto set_dictionary(compress_dictionary dictionary) && -> compress&&
+  {
+    set_dictionary(std::move(dictionary));
+    return std::move(*this);
+  }
+
+  template <typename Request,
+            typename Response,
+            decay_to<compress> Self,
+            typename Next>
+  friend auto
+  tag_invoke(to_middleware_t<Request, Response>, Self&& self, Next&& next)
+  {
+    return std::forward<Self>(self)
+        .template to_middleware_impl<Request, Response>(
+            std::forward<Next>(next));
+  }
+
+private:
+  template <typename Request, typename Response, typename Next>
+  auto to_middleware_impl(Next&& next) const
+  {
+    return compress_middleware<Request, Response, std::decay_t<Next>>(
+        std::forward<Next>(next), threshold_, executor_, cache_, dictionary_);
+  }
+
+  std::size_t threshold_ = 1024;
+  optional<net::any_io_executor> executor_;
+  std::shared_ptr<compress_cache> cache_;
+  optional<compress_dictionary> dictionary_;
+};
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
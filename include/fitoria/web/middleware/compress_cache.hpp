@@ -0,0 +1,215 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_MIDDLEWARE_COMPRESS_CACHE_HPP
+#define FITORIA_WEB_MIDDLEWARE_COMPRESS_CACHE_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/format.hpp>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::middleware {
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// An in-memory cache of compressed response bodies.
+///
+/// DESCRIPTION
+///   An in-memory cache of compressed response bodies for
+///   ``middleware::compress``, keyed by the request target, the strong
+///   ``ETag`` of the response and the content coding, which is qualified by
+///   the hash of the dictionary for dictionary codings. Since a strong ``ETag``
+///   changes whenever the content does, a response whose ``ETag`` is found is
+///   served with the cached bytes instead of being compressed again. Bodies
+///   are evicted in least recently used order once the cached bytes exceed
+///   ``max_size``, and bodies larger than ``max_entry_size`` after compression
+///   are not cached.
+///
+/// @endverbatim
+class compress_cache {
+  struct node {
+    std::shared_ptr<const bytes> value;
+    std::list<std::string>::iterator lru;
+  };
+
+public:
+  class builder {
+    friend class compress_cache;
+
+    std::uint64_t max_size_ = 64 * 1024 * 1024;
+    std::uint64_t max_entry_size_ = 1024 * 1024;
+
+  public:
+    builder() = default;
+
+    std::shared_ptr<compress_cache> build() const
+    {
+      return std::make_shared<compress_cache>(*this);
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the maximum number of bytes of cached bodies. Default is 64 MiB.
+    ///
+    /// @endverbatim
+    builder& set_max_size(std::uint64_t size)
+    {
+      max_size_ = size;
+      return *this;
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the maximum size of a compressed body to be cached. Default is
+    /// 1 MiB.
+    ///
+    /// @endverbatim
+    builder& set_max_entry_size(std::uint64_t size)
+    {
+      max_entry_size_ = size;
+      return *this;
+    }
+  };
+
+  compress_cache(builder builder)
+      : max_size_(builder.max_size_)
+      , max_entry_size_(builder.max_entry_size_)
+  {
+  }
+
+  compress_cache(const compress_cache&) = delete;
+
+  compress_cache& operator=(const compress_cache&) = delete;
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the number of cached bodies.
+  ///
+  /// @endverbatim
+  auto size() const -> std::size_t
+  {
+    auto lock = std::scoped_lock(mutex_);
+    return entries_.size();
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the number of bytes of cached bodies.
+  ///
+  /// @endverbatim
+  auto total_size() const -> std::uint64_t
+  {
+    auto lock = std::scoped_lock(mutex_);
+    return total_size_;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Remove all bodies from the cache.
+  ///
+  /// @endverbatim
+  void clear()
+  {
+    auto lock = std::scoped_lock(mutex_);
+    entries_.clear();
+    lru_.clear();
+    total_size_ = 0;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Find the body of ``target`` compressed with ``encoding`` whose strong
+  /// ``ETag`` is ``etag``. Returns ``nullptr`` on a miss.
+  ///
+  /// @endverbatim
+  auto find(std::string_view target,
+            std::string_view etag,
+            std::string_view encoding) -> std::shared_ptr<const bytes>
+  {
+    const auto key = make_key(target, etag, encoding);
+
+    auto lock = std::scoped_lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+      return nullptr;
+    }
+
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return it->second.value;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Cache the body of ``target`` compressed with ``encoding`` whose strong
+  /// ``ETag`` is ``etag``, replacing the previous one if there is one.
+  ///
+  /// @endverbatim
+  void insert(std::string_view target,
+              std::string_view etag,
+              std::string_view encoding,
+              std::shared_ptr<const bytes> data)
+  {
+    const auto size = data->size();
+    if (size > max_entry_size_ || size > max_size_) {
+      return;
+    }
+
+    auto key = make_key(target, etag, encoding);
+
+    auto lock = std::scoped_lock(mutex_);
+    if (auto it = entries_.find(key); it != entries_.end()) {
+      erase(it);
+    }
+    while (!lru_.empty() && total_size_ + size > max_size_) {
+      erase(entries_.find(lru_.back()));
+    }
+    lru_.push_front(key);
+    entries_.emplace(std::move(key), node { std::move(data), lru_.begin() });
+    total_size_ += size;
+  }
+
+private:
+  static auto make_key(std::string_view target,
+                       std::string_view etag,
+                       std::string_view encoding) -> std::string
+  {
+    // neither a content coding nor an entity tag contains NUL
+    return fmt::format("{}{}{}{}{}", encoding, '\0', etag, '\0', target);
+  }
+
+  void erase(std::unordered_map<std::string, node>::iterator it)
+  {
+    total_size_ -= it->second.value->size();
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+  }
+
+  std::uint64_t max_size_;
+  std::uint64_t max_entry_size_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, node> entries_;
+  std::list<std::string> lru_;
+  std::uint64_t total_size_ = 0;
+};
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
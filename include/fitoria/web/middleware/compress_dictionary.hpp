@@ -0,0 +1,442 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_MIDDLEWARE_COMPRESS_DICTIONARY_HPP
+#define FITORIA_WEB_MIDDLEWARE_COMPRESS_DICTIONARY_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/format.hpp>
+#include <fitoria/core/net.hpp>
+#include <fitoria/core/optional.hpp>
+#include <fitoria/core/strings.hpp>
+
+#include <fitoria/encoding/base64.hpp>
+
+#include <fitoria/http.hpp>
+
+#include <fitoria/web/async_readable_shared_buffer_stream.hpp>
+#include <fitoria/web/middleware/detail/async_brotli_deflate_stream.hpp>
+#include <fitoria/web/middleware/detail/async_zstd_deflate_stream.hpp>
+#include <fitoria/web/middleware/detail/context_pool.hpp>
+#include <fitoria/web/middleware/detail/sha256.hpp>
+#include <fitoria/web/request.hpp>
+#include <fitoria/web/response.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#if defined(FITORIA_HAS_ZSTD)
+// `ZSTD_createCDict_advanced()` is required to load a raw content dictionary
+#if !defined(ZSTD_STATIC_LINKING_ONLY)
+#define ZSTD_STATIC_LINKING_ONLY
+#endif
+#include <zstd.h>
+#endif
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::middleware {
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// A dictionary for compressing responses with Compression Dictionary
+/// Transport.
+///
+/// DESCRIPTION
+///   A dictionary for ``middleware::compress``, used with the ``dcb`` (brotli
+///   with a shared dictionary) and ``dcz`` (zstd with a dictionary) content
+///   codings of Compression Dictionary Transport (RFC 9842). The dictionary
+///   is prepared for both encoders once when it is built. Clients learn the
+///   dictionary by fetching it from a route served by the dictionary itself,
+///   e.g. ``route::get<"/dictionary">(dictionary)``, whose response carries
+///   ``Use-As-Dictionary``, and then announce it with the SHA-256 of its
+///   content in ``Available-Dictionary``. Responses advertise the route with
+///   ``Link: <url>; rel="compression-dictionary"`` if ``url`` is set.
+///
+///   The dictionary is used as raw content by both encoders, so that any
+///   decoder given the same bytes is able to decode the responses. A
+///   dictionary made of samples of the responses, e.g. by ``zstd --train``,
+///   is able to improve the ratio of small bodies by several times. ``dcb``
+///   requires brotli 1.1.0 or later.
+///
+/// @endverbatim
+class compress_dictionary {
+#if defined(FITORIA_HAS_ZSTD)
+  struct zstd_deleter {
+    void operator()(ZSTD_CDict* dictionary) const noexcept
+    {
+      ZSTD_freeCDict(dictionary);
+    }
+  };
+#endif
+#if defined(FITORIA_HAS_BROTLI_SHARED_DICTIONARY)
+  struct brotli_deleter {
+    void operator()(BrotliEncoderPreparedDictionary* dictionary) const noexcept
+    {
+      BrotliEncoderDestroyPreparedDictionary(dictionary);
+    }
+  };
+#endif
+
+  struct impl {
+    std::shared_ptr<const bytes> data;
+    std::array<std::byte, 32> hash;
+    std::string available_dictionary;
+    std::string use_as_dictionary;
+    http::header::entity_tag etag { true, "" };
+    std::string etag_str;
+    std::string url;
+    std::string cache_control;
+#if defined(FITORIA_HAS_ZSTD)
+    std::unique_ptr<ZSTD_CDict, zstd_deleter> zstd;
+#endif
+#if defined(FITORIA_HAS_BROTLI_SHARED_DICTIONARY)
+    std::unique_ptr<BrotliEncoderPreparedDictionary, brotli_deleter> brotli;
+#endif
+  };
+
+public:
+  class builder {
+    friend class compress_dictionary;
+
+    bytes data_;
+    std::string match_ = "/*";
+    std::string id_;
+    std::string url_;
+    std::chrono::seconds max_age_ = std::chrono::hours(24);
+
+  public:
+    explicit builder(bytes data)
+        : data_(std::move(data))
+    {
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Prepare the dictionary for the encoders and build it.
+    ///
+    /// @endverbatim
+    auto build() const -> expected<compress_dictionary, std::error_code>
+    {
+      if (data_.empty()) {
+        return unexpected { make_error_code(std::errc::invalid_argument) };
+      }
+
+      auto i = std::make_shared<impl>();
+      i->data = std::make_shared<const bytes>(data_);
+      i->hash = detail::sha256(*i->data);
+
+      auto hash = std::string();
+      encoding::base64::standard_encoder().encode(
+          i->hash.begin(), i->hash.end(), std::back_inserter(hash));
+      i->available_dictionary = fmt::format(":{}:", hash);
+      i->use_as_dictionary = fmt::format("match={}", quote(match_));
+      if (!id_.empty()) {
+        i->use_as_dictionary += fmt::format(", id={}", quote(id_));
+      }
+      i->etag = http::header::entity_tag::make_strong(hash);
+      i->etag_str = i->etag.to_string();
+      i->url = url_;
+      i->cache_control = fmt::format("public, max-age={}", max_age_.count());
+
+#if defined(FITORIA_HAS_ZSTD)
+      i->zstd.reset(ZSTD_createCDict_advanced(
+          i->data->data(),
+          i->data->size(),
+          ZSTD_dlm_byRef,
+          ZSTD_dct_rawContent,
+          ZSTD_getCParams(zstd_level, 0, i->data->size()),
+          ZSTD_defaultCMem));
+      if (!i->zstd) {
+        return unexpected { make_error_code(detail::zstd_error::init) };
+      }
+#endif
+#if defined(FITORIA_HAS_BROTLI_SHARED_DICTIONARY)
+      i->brotli.reset(BrotliEncoderPrepareDictionary(
+          BROTLI_SHARED_DICTIONARY_RAW,
+          i->data->size(),
+          reinterpret_cast<const std::uint8_t*>(i->data->data()),
+          brotli_quality,
+          nullptr,
+          nullptr,
+          nullptr));
+      if (!i->brotli) {
+        return unexpected { make_error_code(detail::brotli_error::init) };
+      }
+#endif
+
+      return compress_dictionary(std::move(i));
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the URL pattern of the requests the dictionary is used for, sent as
+    /// ``match`` of ``Use-As-Dictionary``. Default is ``/*``.
+    ///
+    /// @endverbatim
+    builder& set_match(std::string match)
+    {
+      match_ = std::move(match);
+      return *this;
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the identifier of the dictionary, sent as ``id`` of
+    /// ``Use-As-Dictionary``. Default is none.
+    ///
+    /// @endverbatim
+    builder& set_id(std::string id)
+    {
+      id_ = std::move(id);
+      return *this;
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the URL the dictionary is served at, advertised by the ``Link``
+    /// header of compressible responses. Default is none.
+    ///
+    /// @endverbatim
+    builder& set_url(std::string url)
+    {
+      url_ = std::move(url);
+      return *this;
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set how long clients may keep the dictionary, sent as ``max-age`` of
+    /// ``Cache-Control``. Default is 1 day.
+    ///
+    /// @endverbatim
+    builder& set_max_age(std::chrono::seconds max_age)
+    {
+      max_age_ = max_age;
+      return *this;
+    }
+  };
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the content of the dictionary.
+  ///
+  /// @endverbatim
+  auto data() const noexcept -> std::span<const std::byte>
+  {
+    return *impl_->data;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the SHA-256 of the content of the dictionary.
+  ///
+  /// @endverbatim
+  auto hash() const noexcept -> const std::array<std::byte, 32>&
+  {
+    return impl_->hash;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the value of ``Available-Dictionary`` announcing the dictionary.
+  ///
+  /// @endverbatim
+  auto available_dictionary() const noexcept -> std::string_view
+  {
+    return impl_->available_dictionary;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the URL the dictionary is served at.
+  ///
+  /// @endverbatim
+  auto url() const noexcept -> std::string_view
+  {
+    return impl_->url;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Pick the dictionary content coding of the highest quality accepted by a
+  /// request announcing the dictionary.
+  ///
+  /// @endverbatim
+  auto negotiate(const http::header_map& headers) const
+      -> optional<std::string_view>
+  {
+    constexpr auto codings = std::array<std::string_view, 2> {
+#if defined(FITORIA_HAS_BROTLI_SHARED_DICTIONARY)
+      "dcb",
+#else
+      "",
+#endif
+#if defined(FITORIA_HAS_ZSTD)
+      "dcz",
+#else
+      "",
+#endif
+    };
+
+    if (auto available = headers.get("Available-Dictionary");
+        !available || trim(*available) != impl_->available_dictionary) {
+      return nullopt;
+    }
+    auto header = headers.get(http::field::accept_encoding);
+    if (!header) {
+      return nullopt;
+    }
+    auto ae = http::header::accept_encoding::parse(*header);
+    if (!ae) {
+      return nullopt;
+    }
+
+    auto best = optional<std::string_view>();
+    std::uint16_t best_quality = 0;
+    for (auto coding : codings) {
+      if (coding.empty()) {
+        continue;
+      }
+      if (auto q = ae->quality(coding); q > best_quality) {
+        best = coding;
+        best_quality = q;
+      }
+    }
+
+    return best;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Compress ``input`` as a whole with the dictionary content coding
+  /// ``encoding``, i.e. ``dcb`` or ``dcz``, including the header identifying
+  /// the dictionary.
+  ///
+  /// @endverbatim
+  auto compress(std::span<const std::byte> input,
+                std::string_view encoding) const
+      -> expected<bytes, std::error_code>
+  {
+#if defined(FITORIA_HAS_BROTLI_SHARED_DICTIONARY)
+    if (encoding == "dcb") {
+      auto encoder = detail::brotli_encoder(brotli_quality);
+      if (!encoder.attach(impl_->brotli.get())) {
+        return unexpected { make_error_code(detail::brotli_error::error) };
+      }
+      return encoder.compress(input,
+                              header({ 0xff, 0x44, 0x43, 0x42 }, impl_->hash));
+    }
+#endif
+#if defined(FITORIA_HAS_ZSTD)
+    if (encoding == "dcz") {
+      // a skippable frame carrying the hash
+      return detail::context_pool<detail::zstd_encoder>::acquire(zstd_level)
+          ->compress(input,
+                     impl_->zstd.get(),
+                     header({ 0x5e, 0x2a, 0x4d, 0x18, 0x20, 0x00, 0x00, 0x00 },
+                            impl_->hash));
+    }
+#endif
+
+    return unexpected { make_error_code(std::errc::not_supported) };
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Serve the dictionary with ``Use-As-Dictionary``.
+  ///
+  /// DESCRIPTION
+  ///   Serve the dictionary with ``Use-As-Dictionary``, straight from the
+  ///   shared content without copying it. A request whose ``If-None-Match``
+  ///   matches the ``ETag`` of the dictionary is answered with
+  ///   ``304 Not Modified``.
+  ///
+  /// @endverbatim
+  auto operator()(const request& req) const -> awaitable<response>
+  {
+    if (auto header = req.headers().get(http::field::if_none_match); header) {
+      if (auto m = http::header::if_none_match::parse(*header);
+          m
+          && (m->is_any()
+              || std::any_of(m->begin(), m->end(), [&](auto& element) {
+                   return impl_->etag.weakly_equal_to(element);
+                 }))) {
+        co_return response::not_modified()
+            .set_header(http::field::etag, impl_->etag_str)
+            .set_header(http::field::cache_control, impl_->cache_control)
+            .set_body("");
+      }
+    }
+
+    co_return response::ok()
+        .set_header(http::field::content_type,
+                    mime::application_octet_stream())
+        .set_header("Use-As-Dictionary", impl_->use_as_dictionary)
+        .set_header(http::field::etag, impl_->etag_str)
+        .set_header(http::field::cache_control, impl_->cache_control)
+        .set_body(async_readable_shared_buffer_stream(impl_->data),
+                  impl_->data->size());
+  }
+
+private:
+  // qualities for the small bodies dictionaries are meant for
+  static constexpr std::uint32_t brotli_quality = 5;
+  static constexpr int zstd_level = 3;
+
+  explicit compress_dictionary(std::shared_ptr<const impl> impl)
+      : impl_(std::move(impl))
+  {
+  }
+
+  static auto header(std::initializer_list<std::uint8_t> magic,
+                     const std::array<std::byte, 32>& hash) -> bytes
+  {
+    auto out = bytes();
+    out.reserve(magic.size() + hash.size());
+    for (auto b : magic) {
+      out.push_back(std::byte(b));
+    }
+    out.insert(out.end(), hash.begin(), hash.end());
+    return out;
+  }
+
+  // an sf-string of RFC 8941
+  static auto quote(std::string_view str) -> std::string
+  {
+    auto out = std::string("\"");
+    for (auto c : str) {
+      if (c == '"' || c == '\\') {
+        out += '\\';
+      }
+      out += c;
+    }
+    out += '"';
+    return out;
+  }
+
+  std::shared_ptr<const impl> impl_;
+};
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
@@ -19,10 +19,14 @@
 #include <fitoria/web/middleware/detail/async_brotli_inflate_stream.hpp>
 #include <fitoria/web/middleware/detail/async_gzip_inflate_stream.hpp>
 #include <fitoria/web/middleware/detail/async_inflate_stream.hpp>
+#include <fitoria/web/middleware/detail/async_zstd_inflate_stream.hpp>
+#include <fitoria/web/middleware/detail/inflate_limit.hpp>
 #include <fitoria/web/request.hpp>
 #include <fitoria/web/response.hpp>
 #include <fitoria/web/to_middleware.hpp>
 
+#include <memory>
+
 FITORIA_NAMESPACE_BEGIN
 
 namespace web::middleware {
@@ -39,17 +43,25 @@ public:
       std::reverse(encs.begin(), encs.end());
 
       auto body = std::move(req.body());
+      auto exceeded = std::make_shared<bool>(false);
+      auto limit = [&]() {
+        return detail::inflate_limit(max_size_, max_ratio_, exceeded);
+      };
 
       for (auto& enc : encs) {
         if (cmp_eq_ci(enc, "deflate")) {
-          body = detail::async_inflate_stream(std::move(body));
+          body = detail::async_inflate_stream(std::move(body), limit());
 #if defined(FITORIA_HAS_ZLIB)
         } else if (cmp_eq_ci(enc, "gzip")) {
-          body = detail::async_gzip_inflate_stream(std::move(body));
+          body = detail::async_gzip_inflate_stream(std::move(body), limit());
 #endif
 #if defined(FITORIA_HAS_BROTLI)
         } else if (cmp_eq_ci(enc, "brotli")) {
-          body = detail::async_brotli_inflate_stream(std::move(body));
+          body = detail::async_brotli_inflate_stream(std::move(body), limit());
+#endif
+#if defined(FITORIA_HAS_ZSTD)
+        } else if (cmp_eq_ci(enc, "zstd")) {
+          body = detail::async_zstd_inflate_stream(std::move(body), limit());
 #endif
         } else if (cmp_eq_ci(enc, "identity")) {
         } else {
@@ -69,6 +81,14 @@ public:
       }
 
       req = builder.set_body(std::move(body));
+
+      auto res = co_await next_(req);
+      if (*exceeded) {
+        co_return response::payload_too_large()
+            .set_header(http::field::content_type, mime::text_plain())
+            .set_body("decompressed request body is too large.");
+      }
+      co_return res;
     }
 
     co_return co_await next_(req);
@@ -76,8 +96,12 @@ public:
 
 private:
   template <typename Next2>
-  decompress_middleware(Next2&& next)
+  decompress_middleware(Next2&& next,
+                        optional<std::uint64_t> max_size,
+                        optional<std::uint64_t> max_ratio)
       : next_(std::forward<Next2>(next))
+      , max_size_(max_size)
+      , max_ratio_(max_ratio)
   {
   }
 
@@ -93,10 +117,64 @@ private:
   }
 
   Next next_;
+  optional<std::uint64_t> max_size_;
+  optional<std::uint64_t> max_ratio_;
 };
 
+/// @verbatim embed:rst:leading-slashes
+///
+/// Middleware for decompressing the request body.
+///
+/// DESCRIPTION
+///   Middleware for decompressing the request body according to its
+///   ``Content-Encoding``, ``deflate``, ``gzip``, ``brotli`` and ``zstd`` are
+///   supported. The body is decompressed as the handler reads it. Since
+///   ``request_body_limit`` only applies to the compressed body, the size of
+///   the decompressed body and its expansion ratio are able to be limited as
+///   well; reading beyond either limit fails with ``std::errc::message_size``
+///   without buffering the excess, and the request is answered with ``413
+///   Payload Too Large``.
+///
+/// @endverbatim
 class decompress {
 public:
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Set the maximum size of the decompressed body of each content coding.
+  /// By default the size is unlimited.
+  ///
+  /// @endverbatim
+  auto set_max_size(std::uint64_t max_size) & noexcept -> decompress&
+  {
+    max_size_ = max_size;
+    return *this;
+  }
+
+  auto set_max_size(std::uint64_t max_size) && noexcept -> decompress&&
+  {
+    set_max_size(max_size);
+    return std::move(*this);
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Set the maximum ratio of the decompressed size to the compressed size
+  /// read so far, of each content coding, e.g. ``100``. By default the ratio
+  /// is unlimited.
+  ///
+  /// @endverbatim
+  auto set_max_ratio(std::uint64_t max_ratio) & noexcept -> decompress&
+  {
+    max_ratio_ = max_ratio;
+    return *this;
+  }
+
+  auto set_max_ratio(std::uint64_t max_ratio) && noexcept -> decompress&&
+  {
+    set_max_ratio(max_ratio);
+    return std::move(*this);
+  }
+
   template <typename Request,
             typename Response,
             decay_to<decompress> Self,
@@ -114,8 +192,11 @@ private:
   auto to_middleware_impl(Next&& next) const
   {
     return decompress_middleware<Request, Response, std::decay_t<Next>>(
-        std::forward<Next>(next));
+        std::forward<Next>(next), max_size_, max_ratio_);
   }
+
+  optional<std::uint64_t> max_size_;
+  optional<std::uint64_t> max_ratio_;
 };
 
 }
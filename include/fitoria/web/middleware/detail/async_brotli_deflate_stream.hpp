@@ -13,15 +13,28 @@
 
 #if defined(FITORIA_HAS_BROTLI)
 
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/dynamic_buffer.hpp>
+#include <fitoria/core/expected.hpp>
 #include <fitoria/core/net.hpp>
 
 #include <fitoria/web/middleware/detail/brotli_error.hpp>
 #include <fitoria/web/middleware/detail/brotli_params.hpp>
+#include <fitoria/web/middleware/detail/offload.hpp>
 
 #include <fitoria/web/async_readable_stream_concept.hpp>
 
 #include <brotli/encode.h>
 
+// shared dictionaries are supported since brotli 1.1.0
+#if __has_include(<brotli/shared_dictionary.h>)
+#define FITORIA_HAS_BROTLI_SHARED_DICTIONARY
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+
 FITORIA_NAMESPACE_BEGIN
 
 namespace web::middleware::detail {
@@ -35,13 +48,18 @@ enum class brotli_encoder_operation {
 
 class brotli_encoder {
 public:
-  brotli_encoder()
+  brotli_encoder(std::uint32_t quality = BROTLI_DEFAULT_QUALITY)
       : handle_(BrotliEncoderCreateInstance(nullptr, nullptr, nullptr))
   {
     if (handle_ == nullptr) {
       FITORIA_THROW_OR(std::system_error(make_error_code(brotli_error::init)),
                        std::terminate());
     }
+
+    BrotliEncoderSetParameter(
+        handle_,
+        BROTLI_PARAM_QUALITY,
+        std::min<std::uint32_t>(quality, BROTLI_MAX_QUALITY));
   }
 
   ~brotli_encoder()
@@ -86,6 +104,69 @@ public:
     return BrotliEncoderIsFinished(handle_) == BROTLI_TRUE;
   }
 
+  auto has_more_output() const noexcept -> bool
+  {
+    return BrotliEncoderHasMoreOutput(handle_) == BROTLI_TRUE;
+  }
+
+#if defined(FITORIA_HAS_BROTLI_SHARED_DICTIONARY)
+  // Uses `dictionary`, which must outlive the encoder, as a shared dictionary.
+  auto attach(const BrotliEncoderPreparedDictionary* dictionary) noexcept
+      -> bool
+  {
+    return BrotliEncoderAttachPreparedDictionary(handle_, dictionary)
+        == BROTLI_TRUE;
+  }
+#endif
+
+  // Compresses `input` as a whole with the parameters of this encoder, e.g. an
+  // attached dictionary, appending the result to `out`.
+  auto compress(std::span<const std::byte> input, bytes out = {})
+      -> expected<bytes, std::error_code>
+  {
+    auto buffer = dynamic_buffer<bytes>(std::move(out));
+    auto p = broti_params(input.data(), input.size(), nullptr, 0);
+    while (!is_done()) {
+      auto writable = buffer.prepare(std::max(
+          BrotliEncoderMaxCompressedSize(p.avail_in), std::size_t(1024)));
+      p.next_out = static_cast<std::uint8_t*>(writable.data());
+      p.avail_out = writable.size();
+      if (auto ec = write(p, brotli_encoder_operation::finish); ec) {
+        return unexpected { ec };
+      }
+      buffer.commit(writable.size() - p.avail_out);
+    }
+
+    return buffer.release();
+  }
+
+  // Compresses `input` as a whole in a single call, into an output allocated
+  // once with the size given by `BrotliEncoderMaxCompressedSize()`.
+  static auto compress(std::span<const std::byte> input, std::uint32_t quality)
+      -> expected<bytes, std::error_code>
+  {
+    auto size = BrotliEncoderMaxCompressedSize(input.size());
+    if (size == 0) {
+      return unexpected { make_error_code(brotli_error::error) };
+    }
+
+    auto out = bytes(size);
+    if (!BrotliEncoderCompress(
+            static_cast<int>(std::min<std::uint32_t>(quality,
+                                                     BROTLI_MAX_QUALITY)),
+            BROTLI_DEFAULT_WINDOW,
+            BROTLI_DEFAULT_MODE,
+            input.size(),
+            reinterpret_cast<const std::uint8_t*>(input.data()),
+            &size,
+            reinterpret_cast<std::uint8_t*>(out.data()))) {
+      return unexpected { make_error_code(brotli_error::error) };
+    }
+
+    out.resize(size);
+    return out;
+  }
+
 private:
   auto from_native_error(BROTLI_BOOL result) -> std::error_code
   {
@@ -128,6 +209,24 @@ public:
   {
   }
 
+  template <async_readable_stream NextLayer2>
+  async_brotli_deflate_stream(NextLayer2&& next, std::uint32_t quality)
+      : next_(std::forward<NextLayer2>(next))
+      , deflater_(quality)
+  {
+  }
+
+  // Blocks are compressed on `executor` if there is one.
+  template <async_readable_stream NextLayer2>
+  async_brotli_deflate_stream(NextLayer2&& next,
+                              std::uint32_t quality,
+                              optional<net::any_io_executor> executor)
+      : next_(std::forward<NextLayer2>(next))
+      , deflater_(quality)
+      , executor_(std::move(executor))
+  {
+  }
+
   auto
   async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
   {
@@ -138,21 +237,9 @@ public:
       }
 
       finish_ = true;
-
-      auto buffer = dynamic_buffer<bytes>();
-      auto writable = buffer.prepare(65536);
-
-      auto p = broti_params(nullptr, 0, writable.data(), writable.size());
-
-      auto ec = deflater_.write(p, brotli_encoder_operation::finish);
-
-      FITORIA_ASSERT(ec != brotli_error::need_more_output);
-      if (ec) {
-        co_return unexpected { ec };
-      }
-
-      buffer.commit(writable.size() - p.avail_out);
-      co_return buffer.release();
+      co_return co_await offload(executor_, [this] {
+        return write({}, brotli_encoder_operation::finish);
+      });
     }
 
     auto& readable = *data;
@@ -163,27 +250,48 @@ public:
       co_return bytes();
     }
 
+    co_return co_await offload(executor_, [&] {
+      return write(*readable, brotli_encoder_operation::process);
+    });
+  }
+
+private:
+  // Compresses until the input is consumed, or until the stream is finished
+  // for `brotli_encoder_operation::finish`, growing the output as needed.
+  auto write(std::span<const std::byte> input, brotli_encoder_operation op)
+      -> expected<bytes, std::error_code>
+  {
     auto buffer = dynamic_buffer<bytes>();
-    auto writable
-        = buffer.prepare(std::max(readable->size(), std::size_t(65536)));
 
-    auto p = broti_params(
-        readable->data(), readable->size(), writable.data(), writable.size());
+    auto next_in = input.data();
+    auto avail_in = input.size();
+    for (;;) {
+      auto writable = buffer.prepare(std::max(avail_in, std::size_t(65536)));
+      auto p = broti_params(
+          next_in, avail_in, writable.data(), writable.size());
 
-    auto ec = deflater_.write(p, brotli_encoder_operation::process);
+      auto ec = deflater_.write(p, op);
+      buffer.commit(writable.size() - p.avail_out);
+      if (ec) {
+        return unexpected { ec };
+      }
 
-    FITORIA_ASSERT(ec != brotli_error::need_more_output);
-    if (ec) {
-      co_return unexpected { ec };
+      next_in = reinterpret_cast<const std::byte*>(p.next_in);
+      avail_in = p.avail_in;
+      const auto done = op == brotli_encoder_operation::finish
+          ? deflater_.is_done()
+          : avail_in == 0 && !deflater_.has_more_output();
+      if (done) {
+        break;
+      }
     }
 
-    buffer.commit(writable.size() - p.avail_out);
-    co_return buffer.release();
+    return buffer.release();
   }
 
-private:
   NextLayer next_;
   brotli_encoder deflater_;
+  optional<net::any_io_executor> executor_;
   bool finish_ = false;
 };
 
@@ -191,6 +299,16 @@ template <typename NextLayer>
 async_brotli_deflate_stream(NextLayer&&)
     -> async_brotli_deflate_stream<std::decay_t<NextLayer>>;
 
+template <typename NextLayer>
+async_brotli_deflate_stream(NextLayer&&, std::uint32_t)
+    -> async_brotli_deflate_stream<std::decay_t<NextLayer>>;
+
+template <typename NextLayer>
+async_brotli_deflate_stream(NextLayer&&,
+                            std::uint32_t,
+                            optional<net::any_io_executor>)
+    -> async_brotli_deflate_stream<std::decay_t<NextLayer>>;
+
 }
 
 FITORIA_NAMESPACE_END
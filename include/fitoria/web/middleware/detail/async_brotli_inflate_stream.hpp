@@ -17,6 +17,7 @@
 
 #include <fitoria/web/middleware/detail/brotli_error.hpp>
 #include <fitoria/web/middleware/detail/brotli_params.hpp>
+#include <fitoria/web/middleware/detail/inflate_limit.hpp>
 
 #include <fitoria/web/async_readable_stream_concept.hpp>
 
@@ -101,6 +102,13 @@ public:
   {
   }
 
+  template <async_readable_stream NextLayer2>
+  async_brotli_inflate_stream(NextLayer2&& next, inflate_limit limit)
+      : next_(std::forward<NextLayer2>(next))
+      , limit_(std::move(limit))
+  {
+  }
+
   auto
   async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
   {
@@ -116,13 +124,14 @@ public:
       co_return bytes();
     }
 
+    limit_.consume((*data)->size());
     auto readable = dynamic_buffer<bytes>(std::move(**data));
 
     auto buffer = dynamic_buffer<bytes>();
 
     for (;;) {
-      auto writable
-          = buffer.prepare(std::max(readable.size(), std::size_t(65536)));
+      auto writable = buffer.prepare(
+          limit_.prepare(std::max(readable.size(), std::size_t(65536))));
 
       auto p = broti_params(readable.cdata().data(),
                             readable.cdata().size(),
@@ -140,6 +149,9 @@ public:
 
       readable.consume(readable.size() - p.avail_in);
       buffer.commit(writable.size() - p.avail_out);
+      if (!limit_.commit(writable.size() - p.avail_out)) {
+        co_return unexpected { make_error_code(std::errc::message_size) };
+      }
 
       if (readable.size() == 0 && p.avail_out > 0) {
         break;
@@ -152,12 +164,17 @@ public:
 private:
   NextLayer next_;
   brotli_decoder inflater_;
+  inflate_limit limit_;
 };
 
 template <typename NextLayer>
 async_brotli_inflate_stream(NextLayer&&)
     -> async_brotli_inflate_stream<std::decay_t<NextLayer>>;
 
+template <typename NextLayer>
+async_brotli_inflate_stream(NextLayer&&, inflate_limit)
+    -> async_brotli_inflate_stream<std::decay_t<NextLayer>>;
+
 }
 
 FITORIA_NAMESPACE_END
@@ -16,6 +16,9 @@
 
 #include <fitoria/web/async_readable_stream_concept.hpp>
 
+#include <algorithm>
+#include <span>
+
 FITORIA_NAMESPACE_BEGIN
 
 namespace web::middleware::detail {
@@ -34,9 +37,7 @@ public:
   auto
   async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
   {
-    using boost::beast::zlib::error;
     using boost::beast::zlib::Flush;
-    using boost::beast::zlib::z_params;
 
     auto data = co_await next_.async_read_some();
     if (!data) {
@@ -45,29 +46,7 @@ public:
       }
 
       finish_ = true;
-
-      auto buffer = dynamic_buffer<bytes>();
-      auto writable = buffer.prepare(65536);
-
-      auto p = z_params();
-      p.next_in = nullptr;
-      p.avail_in = 0;
-      p.next_out = writable.data();
-      p.avail_out = writable.size();
-
-      boost::system::error_code ec;
-      deflater_.write(p, Flush::finish, ec);
-
-      FITORIA_ASSERT(ec != error::need_buffers);
-      if (ec == error::end_of_stream) {
-        ec = {};
-      }
-      if (ec) {
-        co_return unexpected { ec };
-      }
-
-      buffer.commit(writable.size() - p.avail_out);
-      co_return buffer.release();
+      co_return write({}, Flush::finish);
     }
 
     auto& readable = *data;
@@ -78,28 +57,53 @@ public:
       co_return bytes();
     }
 
+    co_return write(*readable, Flush::none);
+  }
+
+private:
+  // Deflates until the input is consumed, or until the stream is finished for
+  // `Flush::finish`, growing the output as needed.
+  auto write(std::span<const std::byte> input, boost::beast::zlib::Flush flush)
+      -> expected<bytes, std::error_code>
+  {
+    using boost::beast::zlib::error;
+    using boost::beast::zlib::Flush;
+    using boost::beast::zlib::z_params;
+
     auto buffer = dynamic_buffer<bytes>();
-    auto writable
-        = buffer.prepare(std::max(readable->size(), std::size_t(65536)));
 
     auto p = z_params();
-    p.next_in = readable->data();
-    p.avail_in = readable->size();
-    p.next_out = writable.data();
-    p.avail_out = writable.size();
+    p.next_in = input.data();
+    p.avail_in = input.size();
+
+    for (;;) {
+      auto writable
+          = buffer.prepare(std::max(p.avail_in, std::size_t(65536)));
+      p.next_out = writable.data();
+      p.avail_out = writable.size();
 
-    boost::system::error_code ec;
-    deflater_.write(p, Flush::none, ec);
+      boost::system::error_code ec;
+      deflater_.write(p, flush, ec);
+      buffer.commit(writable.size() - p.avail_out);
 
-    if (ec) {
-      co_return unexpected { ec };
+      if (ec == error::end_of_stream) {
+        break;
+      }
+      if (ec == error::need_buffers && flush != Flush::finish) {
+        // no progress is possible without more input
+        break;
+      }
+      if (ec) {
+        return unexpected { ec };
+      }
+      if (flush != Flush::finish && p.avail_in == 0 && p.avail_out > 0) {
+        break;
+      }
     }
 
-    buffer.commit(writable.size() - p.avail_out);
-    co_return buffer.release();
+    return buffer.release();
   }
 
-private:
   NextLayer next_;
   boost::beast::zlib::deflate_stream deflater_;
   bool finish_ = false;
@@ -15,10 +15,15 @@
 
 #include <fitoria/core/dynamic_buffer.hpp>
 
+#include <fitoria/web/middleware/detail/context_pool.hpp>
 #include <fitoria/web/middleware/detail/gzip_stream.hpp>
+#include <fitoria/web/middleware/detail/offload.hpp>
 
 #include <fitoria/web/async_readable_stream_concept.hpp>
 
+#include <algorithm>
+#include <span>
+
 FITORIA_NAMESPACE_BEGIN
 
 namespace web::middleware::detail {
@@ -34,12 +39,28 @@ public:
   {
   }
 
+  template <async_readable_stream NextLayer2>
+  async_gzip_deflate_stream(NextLayer2&& next, int level)
+      : next_(std::forward<NextLayer2>(next))
+      , deflater_(context_pool<gzip_deflate_stream>::acquire(level))
+  {
+  }
+
+  // Blocks are deflated on `executor` if there is one.
+  template <async_readable_stream NextLayer2>
+  async_gzip_deflate_stream(NextLayer2&& next,
+                            int level,
+                            optional<net::any_io_executor> executor)
+      : next_(std::forward<NextLayer2>(next))
+      , deflater_(context_pool<gzip_deflate_stream>::acquire(level))
+      , executor_(std::move(executor))
+  {
+  }
+
   auto
   async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
   {
-    using boost::beast::zlib::error;
     using boost::beast::zlib::Flush;
-    using boost::beast::zlib::z_params;
 
     auto data = co_await next_.async_read_some();
     if (!data) {
@@ -48,29 +69,8 @@ public:
       }
 
       finish_ = true;
-
-      auto buffer = dynamic_buffer<bytes>();
-      auto writable = buffer.prepare(65536);
-
-      auto p = z_params();
-      p.next_in = nullptr;
-      p.avail_in = 0;
-      p.next_out = writable.data();
-      p.avail_out = writable.size();
-
-      boost::system::error_code ec;
-      deflater_.write(p, Flush::finish, ec);
-
-      FITORIA_ASSERT(ec != error::need_buffers);
-      if (ec == error::end_of_stream) {
-        ec = {};
-      }
-      if (ec) {
-        co_return unexpected { ec };
-      }
-
-      buffer.commit(writable.size() - p.avail_out);
-      co_return buffer.release();
+      co_return co_await offload(executor_,
+                                 [this] { return write({}, Flush::finish); });
     }
 
     auto& readable = *data;
@@ -81,35 +81,73 @@ public:
       co_return bytes();
     }
 
+    co_return co_await offload(
+        executor_, [&] { return write(*readable, Flush::none); });
+  }
+
+private:
+  // Deflates until the input is consumed, or until the stream is finished for
+  // `Flush::finish`, growing the output as needed.
+  auto write(std::span<const std::byte> input, boost::beast::zlib::Flush flush)
+      -> expected<bytes, std::error_code>
+  {
+    using boost::beast::zlib::error;
+    using boost::beast::zlib::Flush;
+    using boost::beast::zlib::z_params;
+
     auto buffer = dynamic_buffer<bytes>();
-    auto writable
-        = buffer.prepare(std::max(readable->size(), std::size_t(65536)));
 
     auto p = z_params();
-    p.next_in = readable->data();
-    p.avail_in = readable->size();
-    p.next_out = writable.data();
-    p.avail_out = writable.size();
+    p.next_in = input.data();
+    p.avail_in = input.size();
+
+    for (;;) {
+      auto writable
+          = buffer.prepare(std::max(p.avail_in, std::size_t(65536)));
+      p.next_out = writable.data();
+      p.avail_out = writable.size();
 
-    boost::system::error_code ec;
-    deflater_.write(p, Flush::none, ec);
+      boost::system::error_code ec;
+      deflater_->write(p, flush, ec);
+      buffer.commit(writable.size() - p.avail_out);
 
-    if (ec) {
-      co_return unexpected { ec };
+      if (ec == error::end_of_stream) {
+        break;
+      }
+      if (ec == error::need_buffers && flush != Flush::finish) {
+        // no progress is possible without more input
+        break;
+      }
+      if (ec) {
+        return unexpected { ec };
+      }
+      if (flush != Flush::finish && p.avail_in == 0 && p.avail_out > 0) {
+        break;
+      }
     }
 
-    buffer.commit(writable.size() - p.avail_out);
-    co_return buffer.release();
+    return buffer.release();
   }
 
   NextLayer next_;
-  gzip_deflate_stream deflater_;
+  context_pool<gzip_deflate_stream>::pointer deflater_
+      = context_pool<gzip_deflate_stream>::acquire(
+          gzip_deflate_stream::default_level);
+  optional<net::any_io_executor> executor_;
   bool finish_ = false;
 };
 
 template <typename NextLayer>
 async_gzip_deflate_stream(NextLayer&&)
     -> async_gzip_deflate_stream<std::decay_t<NextLayer>>;
+
+template <typename NextLayer>
+async_gzip_deflate_stream(NextLayer&&, int)
+    -> async_gzip_deflate_stream<std::decay_t<NextLayer>>;
+
+template <typename NextLayer>
+async_gzip_deflate_stream(NextLayer&&, int, optional<net::any_io_executor>)
+    -> async_gzip_deflate_stream<std::decay_t<NextLayer>>;
 }
 
 FITORIA_NAMESPACE_END
@@ -15,7 +15,9 @@
 
 #include <fitoria/core/dynamic_buffer.hpp>
 
+#include <fitoria/web/middleware/detail/context_pool.hpp>
 #include <fitoria/web/middleware/detail/gzip_stream.hpp>
+#include <fitoria/web/middleware/detail/inflate_limit.hpp>
 
 #include <fitoria/web/async_readable_stream_concept.hpp>
 
@@ -34,6 +36,13 @@ public:
   {
   }
 
+  template <async_readable_stream NextLayer2>
+  async_gzip_inflate_stream(NextLayer2&& next, inflate_limit limit)
+      : next_(std::forward<NextLayer2>(next))
+      , limit_(std::move(limit))
+  {
+  }
+
   auto
   async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
   {
@@ -53,13 +62,14 @@ public:
       co_return bytes();
     }
 
+    limit_.consume((*data)->size());
     auto readable = dynamic_buffer<bytes>(std::move(**data));
 
     auto buffer = dynamic_buffer<bytes>();
 
     for (;;) {
-      auto writable
-          = buffer.prepare(std::max(readable.size(), std::size_t(65536)));
+      auto writable = buffer.prepare(
+          limit_.prepare(std::max(readable.size(), std::size_t(65536))));
 
       auto p = z_params();
       p.next_in = readable.cdata().data();
@@ -68,17 +78,24 @@ public:
       p.avail_out = writable.size();
 
       boost::system::error_code ec;
-      inflater_.write(p, Flush::sync, ec);
+      inflater_->write(p, Flush::sync, ec);
 
       if (ec == error::end_of_stream) {
         ec = {};
       }
+      // the input is consumed and the last output filled the buffer exactly
+      if (ec == error::need_buffers && readable.size() == 0) {
+        break;
+      }
       if (ec) {
         co_return unexpected { ec };
       }
 
       readable.consume(readable.size() - p.avail_in);
       buffer.commit(writable.size() - p.avail_out);
+      if (!limit_.commit(writable.size() - p.avail_out)) {
+        co_return unexpected { make_error_code(std::errc::message_size) };
+      }
 
       if (readable.size() == 0 && p.avail_out > 0) {
         break;
@@ -90,12 +107,18 @@ public:
 
 private:
   NextLayer next_;
-  gzip_inflate_stream inflater_;
+  context_pool<gzip_inflate_stream>::pointer inflater_
+      = context_pool<gzip_inflate_stream>::acquire();
+  inflate_limit limit_;
 };
 
 template <typename NextLayer>
 async_gzip_inflate_stream(NextLayer&&)
     -> async_gzip_inflate_stream<std::decay_t<NextLayer>>;
+
+template <typename NextLayer>
+async_gzip_inflate_stream(NextLayer&&, inflate_limit)
+    -> async_gzip_inflate_stream<std::decay_t<NextLayer>>;
 }
 
 FITORIA_NAMESPACE_END
@@ -0,0 +1,256 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_MIDDLEWARE_DETAIL_ASYNC_ZSTD_DEFLATE_STREAM_HPP
+#define FITORIA_WEB_MIDDLEWARE_DETAIL_ASYNC_ZSTD_DEFLATE_STREAM_HPP
+
+#include <fitoria/core/config.hpp>
+
+#if defined(FITORIA_HAS_ZSTD)
+
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/dynamic_buffer.hpp>
+#include <fitoria/core/net.hpp>
+
+#include <fitoria/web/middleware/detail/context_pool.hpp>
+#include <fitoria/web/middleware/detail/offload.hpp>
+#include <fitoria/web/middleware/detail/zstd_error.hpp>
+
+#include <fitoria/web/async_readable_stream_concept.hpp>
+
+#include <zstd.h>
+
+#include <algorithm>
+#include <span>
+#include <tuple>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::middleware::detail {
+
+class zstd_encoder {
+public:
+  zstd_encoder(int level = ZSTD_CLEVEL_DEFAULT)
+      : handle_(ZSTD_createCCtx())
+      , level_(level)
+  {
+    if (handle_ == nullptr) {
+      FITORIA_THROW_OR(std::system_error(make_error_code(zstd_error::init)),
+                       std::terminate());
+    }
+
+    ZSTD_CCtx_setParameter(
+        handle_,
+        ZSTD_c_compressionLevel,
+        std::clamp(level, ZSTD_minCLevel(), ZSTD_maxCLevel()));
+  }
+
+  ~zstd_encoder()
+  {
+    if (handle_) {
+      ZSTD_freeCCtx(handle_);
+    }
+  }
+
+  zstd_encoder(const zstd_encoder&) = delete;
+
+  zstd_encoder& operator=(const zstd_encoder&) = delete;
+
+  zstd_encoder(zstd_encoder&& other)
+      : handle_(std::exchange(other.handle_, nullptr))
+      , level_(other.level_)
+  {
+  }
+
+  zstd_encoder& operator=(zstd_encoder&& other)
+  {
+    if (this != &other) {
+      std::swap(handle_, other.handle_);
+      std::swap(level_, other.level_);
+    }
+
+    return *this;
+  }
+
+  auto options() const noexcept -> std::tuple<int>
+  {
+    return { level_ };
+  }
+
+  // Abandons the current frame but keeps the parameters.
+  auto reset() noexcept -> bool
+  {
+    return !ZSTD_isError(ZSTD_CCtx_reset(handle_, ZSTD_reset_session_only));
+  }
+
+  // Returns the number of bytes still to be flushed on success, which is 0
+  // once `ZSTD_e_end` completes the frame.
+  auto write(ZSTD_inBuffer& in, ZSTD_outBuffer& out, ZSTD_EndDirective op)
+      -> expected<std::size_t, std::error_code>
+  {
+    const auto remaining = ZSTD_compressStream2(handle_, &out, &in, op);
+    if (ZSTD_isError(remaining)) {
+      return unexpected { make_error_code(zstd_error::error) };
+    }
+
+    return remaining;
+  }
+
+  // Compresses `input` as a whole into a single frame, with an output
+  // allocated once with the size given by `ZSTD_compressBound()`.
+  auto compress(std::span<const std::byte> input)
+      -> expected<bytes, std::error_code>
+  {
+    auto out = bytes(ZSTD_compressBound(input.size()));
+    const auto size = ZSTD_compress2(
+        handle_, out.data(), out.size(), input.data(), input.size());
+    if (ZSTD_isError(size)) {
+      return unexpected { make_error_code(zstd_error::error) };
+    }
+
+    out.resize(size);
+    return out;
+  }
+
+  // Compresses `input` as a whole with `dictionary`, appending the result to
+  // `out`. The dictionary only applies to this call.
+  auto compress(std::span<const std::byte> input,
+                const ZSTD_CDict* dictionary,
+                bytes out = {}) -> expected<bytes, std::error_code>
+  {
+    const auto offset = out.size();
+    out.resize(offset + ZSTD_compressBound(input.size()));
+    const auto size = ZSTD_compress_usingCDict(handle_,
+                                               out.data() + offset,
+                                               out.size() - offset,
+                                               input.data(),
+                                               input.size(),
+                                               dictionary);
+    if (ZSTD_isError(size)) {
+      return unexpected { make_error_code(zstd_error::error) };
+    }
+
+    out.resize(offset + size);
+    return out;
+  }
+
+private:
+  ZSTD_CCtx* handle_ = nullptr;
+  int level_;
+};
+
+template <async_readable_stream NextLayer>
+class async_zstd_deflate_stream {
+public:
+  using is_async_readable_stream = void;
+
+  template <async_readable_stream NextLayer2>
+  async_zstd_deflate_stream(NextLayer2&& next)
+      : next_(std::forward<NextLayer2>(next))
+  {
+  }
+
+  template <async_readable_stream NextLayer2>
+  async_zstd_deflate_stream(NextLayer2&& next, int level)
+      : next_(std::forward<NextLayer2>(next))
+      , deflater_(context_pool<zstd_encoder>::acquire(level))
+  {
+  }
+
+  // Blocks are compressed on `executor` if there is one.
+  template <async_readable_stream NextLayer2>
+  async_zstd_deflate_stream(NextLayer2&& next,
+                            int level,
+                            optional<net::any_io_executor> executor)
+      : next_(std::forward<NextLayer2>(next))
+      , deflater_(context_pool<zstd_encoder>::acquire(level))
+      , executor_(std::move(executor))
+  {
+  }
+
+  auto
+  async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
+  {
+    auto data = co_await next_.async_read_some();
+    if (!data) {
+      if (finish_) {
+        co_return nullopt;
+      }
+
+      finish_ = true;
+      co_return co_await offload(executor_,
+                                 [this] { return write({}, ZSTD_e_end); });
+    }
+
+    auto& readable = *data;
+    if (!readable) {
+      co_return unexpected { readable.error() };
+    }
+    if (readable->empty()) {
+      co_return bytes();
+    }
+
+    co_return co_await offload(
+        executor_, [&] { return write(*readable, ZSTD_e_continue); });
+  }
+
+private:
+  // Compresses until the input is consumed, or until the frame is completed
+  // for `ZSTD_e_end`, growing the output as needed.
+  auto write(std::span<const std::byte> input, ZSTD_EndDirective op)
+      -> expected<bytes, std::error_code>
+  {
+    auto buffer = dynamic_buffer<bytes>();
+
+    auto in = ZSTD_inBuffer { input.data(), input.size(), 0 };
+    for (;;) {
+      auto writable = buffer.prepare(
+          std::max(in.size - in.pos, ZSTD_CStreamOutSize()));
+      auto out = ZSTD_outBuffer { writable.data(), writable.size(), 0 };
+
+      auto remaining = deflater_->write(in, out, op);
+      buffer.commit(out.pos);
+      if (!remaining) {
+        return unexpected { remaining.error() };
+      }
+
+      const auto done = op == ZSTD_e_end ? *remaining == 0 : in.pos == in.size;
+      if (done) {
+        break;
+      }
+    }
+
+    return buffer.release();
+  }
+
+  NextLayer next_;
+  context_pool<zstd_encoder>::pointer deflater_
+      = context_pool<zstd_encoder>::acquire(ZSTD_CLEVEL_DEFAULT);
+  optional<net::any_io_executor> executor_;
+  bool finish_ = false;
+};
+
+template <typename NextLayer>
+async_zstd_deflate_stream(NextLayer&&)
+    -> async_zstd_deflate_stream<std::decay_t<NextLayer>>;
+
+template <typename NextLayer>
+async_zstd_deflate_stream(NextLayer&&, int)
+    -> async_zstd_deflate_stream<std::decay_t<NextLayer>>;
+
+template <typename NextLayer>
+async_zstd_deflate_stream(NextLayer&&, int, optional<net::any_io_executor>)
+    -> async_zstd_deflate_stream<std::decay_t<NextLayer>>;
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
+
+#endif
@@ -0,0 +1,177 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_MIDDLEWARE_DETAIL_ASYNC_ZSTD_INFLATE_STREAM_HPP
+#define FITORIA_WEB_MIDDLEWARE_DETAIL_ASYNC_ZSTD_INFLATE_STREAM_HPP
+
+#include <fitoria/core/config.hpp>
+
+#if defined(FITORIA_HAS_ZSTD)
+
+#include <fitoria/core/dynamic_buffer.hpp>
+#include <fitoria/core/net.hpp>
+
+#include <fitoria/web/middleware/detail/context_pool.hpp>
+#include <fitoria/web/middleware/detail/inflate_limit.hpp>
+#include <fitoria/web/middleware/detail/zstd_error.hpp>
+
+#include <fitoria/web/async_readable_stream_concept.hpp>
+
+#include <zstd.h>
+
+#include <algorithm>
+#include <tuple>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::middleware::detail {
+
+class zstd_decoder {
+public:
+  zstd_decoder()
+      : handle_(ZSTD_createDCtx())
+  {
+    if (handle_ == nullptr) {
+      FITORIA_THROW_OR(std::system_error(make_error_code(zstd_error::init)),
+                       std::terminate());
+    }
+  }
+
+  ~zstd_decoder()
+  {
+    if (handle_) {
+      ZSTD_freeDCtx(handle_);
+    }
+  }
+
+  zstd_decoder(const zstd_decoder&) = delete;
+
+  zstd_decoder& operator=(const zstd_decoder&) = delete;
+
+  zstd_decoder(zstd_decoder&& other)
+      : handle_(std::exchange(other.handle_, nullptr))
+  {
+  }
+
+  zstd_decoder& operator=(zstd_decoder&& other)
+  {
+    if (this != &other) {
+      std::swap(handle_, other.handle_);
+    }
+
+    return *this;
+  }
+
+  auto options() const noexcept -> std::tuple<>
+  {
+    return {};
+  }
+
+  auto reset() noexcept -> bool
+  {
+    return !ZSTD_isError(ZSTD_DCtx_reset(handle_, ZSTD_reset_session_only));
+  }
+
+  auto write(ZSTD_inBuffer& in, ZSTD_outBuffer& out) noexcept
+      -> std::error_code
+  {
+    if (ZSTD_isError(ZSTD_decompressStream(handle_, &out, &in))) {
+      return make_error_code(zstd_error::error);
+    }
+
+    return {};
+  }
+
+private:
+  ZSTD_DCtx* handle_ = nullptr;
+};
+
+template <async_readable_stream NextLayer>
+class async_zstd_inflate_stream {
+public:
+  using is_async_readable_stream = void;
+
+  template <async_readable_stream NextLayer2>
+  async_zstd_inflate_stream(NextLayer2&& next)
+      : next_(std::forward<NextLayer2>(next))
+  {
+  }
+
+  template <async_readable_stream NextLayer2>
+  async_zstd_inflate_stream(NextLayer2&& next, inflate_limit limit)
+      : next_(std::forward<NextLayer2>(next))
+      , limit_(std::move(limit))
+  {
+  }
+
+  auto
+  async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
+  {
+    auto data = co_await next_.async_read_some();
+    if (!data) {
+      co_return nullopt;
+    }
+
+    if (!*data) {
+      co_return unexpected { data->error() };
+    }
+    if ((*data)->empty()) {
+      co_return bytes();
+    }
+
+    limit_.consume((*data)->size());
+    auto in = ZSTD_inBuffer { (*data)->data(), (*data)->size(), 0 };
+
+    auto buffer = dynamic_buffer<bytes>();
+
+    for (;;) {
+      auto writable = buffer.prepare(
+          limit_.prepare(std::max(in.size - in.pos, ZSTD_DStreamOutSize())));
+      auto out = ZSTD_outBuffer { writable.data(), writable.size(), 0 };
+
+      auto ec = inflater_->write(in, out);
+      if (ec) {
+        co_return unexpected { ec };
+      }
+
+      buffer.commit(out.pos);
+      if (!limit_.commit(out.pos)) {
+        co_return unexpected { make_error_code(std::errc::message_size) };
+      }
+
+      // the decoder may hold data which does not fit into a full output
+      if (in.pos == in.size && out.pos < out.size) {
+        break;
+      }
+    }
+
+    co_return buffer.release();
+  }
+
+private:
+  NextLayer next_;
+  context_pool<zstd_decoder>::pointer inflater_
+      = context_pool<zstd_decoder>::acquire();
+  inflate_limit limit_;
+};
+
+template <typename NextLayer>
+async_zstd_inflate_stream(NextLayer&&)
+    -> async_zstd_inflate_stream<std::decay_t<NextLayer>>;
+
+template <typename NextLayer>
+async_zstd_inflate_stream(NextLayer&&, inflate_limit)
+    -> async_zstd_inflate_stream<std::decay_t<NextLayer>>;
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
+
+#endif
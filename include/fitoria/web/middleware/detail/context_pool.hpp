@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_MIDDLEWARE_DETAIL_CONTEXT_POOL_HPP
+#define FITORIA_WEB_MIDDLEWARE_DETAIL_CONTEXT_POOL_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::middleware::detail {
+
+// A per-thread free list of (de)compression contexts, which are expensive to
+// set up. `acquire(args...)` borrows a context whose `options()` equals
+// `std::tuple(args...)`, or constructs a new one from `args...`. The context is
+// `reset()` and returned to the free list of the thread releasing it, unless
+// the reset fails or the list is full.
+template <typename Context, std::size_t MaxSize = 16>
+class context_pool {
+  struct releaser {
+    void operator()(Context* ctx) const noexcept
+    {
+      context_pool::release(std::unique_ptr<Context>(ctx));
+    }
+  };
+
+  using free_list_t = std::vector<std::unique_ptr<Context>>;
+
+public:
+  using pointer = std::unique_ptr<Context, releaser>;
+
+  template <typename... Args>
+  static auto acquire(Args... args) -> pointer
+  {
+    auto& free = free_list();
+    const auto options = std::tuple(args...);
+    for (auto it = free.rbegin(); it != free.rend(); ++it) {
+      if ((*it)->options() == options) {
+        auto ctx = std::move(*it);
+        free.erase(std::next(it).base());
+        return pointer(ctx.release());
+      }
+    }
+
+    return pointer(new Context(args...));
+  }
+
+  static auto size() -> std::size_t
+  {
+    return free_list().size();
+  }
+
+private:
+  static void release(std::unique_ptr<Context> ctx) noexcept
+  {
+    auto& free = free_list();
+    // capacity is reserved up front, so `push_back` never allocates
+    if (free.size() < MaxSize && ctx->reset()) {
+      free.push_back(std::move(ctx));
+    }
+  }
+
+  static auto free_list() -> free_list_t&
+  {
+    thread_local auto free = [] {
+      auto free = free_list_t();
+      free.reserve(MaxSize);
+      return free;
+    }();
+    return free;
+  }
+};
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
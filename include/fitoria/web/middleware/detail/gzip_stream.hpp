@@ -13,9 +13,14 @@
 
 #if defined(FITORIA_HAS_ZLIB)
 
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/expected.hpp>
 #include <fitoria/core/net.hpp>
 
+#include <limits>
+#include <span>
 #include <system_error>
+#include <tuple>
 
 #include <zlib.h>
 
@@ -137,6 +142,16 @@ public:
 
   gzip_inflate_stream& operator=(gzip_inflate_stream&&) = default;
 
+  auto options() const noexcept -> std::tuple<>
+  {
+    return {};
+  }
+
+  auto reset() noexcept -> bool
+  {
+    return ::inflateReset(&*stream_) == Z_OK;
+  }
+
   void write(boost::beast::zlib::z_params& p,
              boost::beast::zlib::Flush flush,
              boost::system::error_code& ec)
@@ -149,14 +164,17 @@ public:
 
 class gzip_deflate_stream : public gzip_stream_base {
 public:
-  gzip_deflate_stream()
+  static constexpr int default_level = Z_BEST_COMPRESSION;
+
+  gzip_deflate_stream(int level = default_level)
+      : level_(level)
   {
     auto s = std::make_unique<z_stream>();
     s->zalloc = Z_NULL;
     s->zfree = Z_NULL;
     s->opaque = Z_NULL;
     if (auto e = ::deflateInit2(&*s,
-                                Z_BEST_COMPRESSION,
+                                level,
                                 Z_DEFLATED,
                                 max_wbits | gzip_header,
                                 9,
@@ -184,6 +202,17 @@ public:
 
   gzip_deflate_stream& operator=(gzip_deflate_stream&&) = default;
 
+  auto options() const noexcept -> std::tuple<int>
+  {
+    return { level_ };
+  }
+
+  // Keeps the allocated state and the compression level.
+  auto reset() noexcept -> bool
+  {
+    return ::deflateReset(&*stream_) == Z_OK;
+  }
+
   void write(boost::beast::zlib::z_params& p,
              boost::beast::zlib::Flush flush,
              boost::system::error_code& ec)
@@ -192,6 +221,33 @@ public:
     ec = from_native_error(::deflate(&*stream_, to_native(flush)));
     from_native(p);
   }
+
+  // Deflates `input` as a whole in a single call, into an output allocated
+  // once with the size given by `deflateBound()`.
+  auto compress(std::span<const std::byte> input)
+      -> expected<bytes, std::error_code>
+  {
+    if (input.size() > std::numeric_limits<uInt>::max()) {
+      return unexpected { make_error_code(std::errc::value_too_large) };
+    }
+
+    auto out = bytes(
+        ::deflateBound(&*stream_, static_cast<uLong>(input.size())));
+    stream_->next_in = reinterpret_cast<unsigned char*>(
+        const_cast<std::byte*>(input.data()));
+    stream_->avail_in = static_cast<uInt>(input.size());
+    stream_->next_out = reinterpret_cast<unsigned char*>(out.data());
+    stream_->avail_out = static_cast<uInt>(out.size());
+    if (auto e = ::deflate(&*stream_, Z_FINISH); e != Z_STREAM_END) {
+      return unexpected { from_native_error(e) };
+    }
+
+    out.resize(out.size() - stream_->avail_out);
+    return out;
+  }
+
+private:
+  int level_;
 };
 
 }
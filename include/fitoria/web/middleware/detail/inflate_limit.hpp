@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_MIDDLEWARE_DETAIL_INFLATE_LIMIT_HPP
+#define FITORIA_WEB_MIDDLEWARE_DETAIL_INFLATE_LIMIT_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/optional.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::middleware::detail {
+
+// Limits the output of an inflate stream to a maximum size and to a maximum
+// ratio of the output to the input read so far. Output buffers are sized so
+// that at most one byte beyond the limit is ever produced, and `exceeded` is
+// set once the limit is exceeded to tell it apart from other errors.
+class inflate_limit {
+public:
+  inflate_limit() = default;
+
+  inflate_limit(optional<std::uint64_t> max_size,
+                optional<std::uint64_t> max_ratio,
+                std::shared_ptr<bool> exceeded = nullptr)
+      : max_size_(max_size)
+      , max_ratio_(max_ratio)
+      , exceeded_(std::move(exceeded))
+  {
+  }
+
+  void consume(std::size_t size) noexcept
+  {
+    in_ += size;
+  }
+
+  // the size of the next output buffer, which is at least one byte so that
+  // output beyond the limit is detected
+  auto prepare(std::size_t size) const noexcept -> std::size_t
+  {
+    const auto max = max_output();
+    const auto left = max > out_ ? max - out_ : 0;
+    return static_cast<std::size_t>(
+        std::max<std::uint64_t>(std::min<std::uint64_t>(size, left), 1));
+  }
+
+  auto commit(std::size_t size) noexcept -> bool
+  {
+    out_ += size;
+    if (out_ <= max_output()) {
+      return true;
+    }
+
+    if (exceeded_) {
+      *exceeded_ = true;
+    }
+    return false;
+  }
+
+private:
+  auto max_output() const noexcept -> std::uint64_t
+  {
+    auto max = max_size_.value_or(UINT64_MAX);
+    if (max_ratio_) {
+      if (*max_ratio_ == 0) {
+        max = 0;
+      } else if (in_ <= max / *max_ratio_) {
+        max = in_ * *max_ratio_;
+      }
+    }
+
+    return max;
+  }
+
+  optional<std::uint64_t> max_size_;
+  optional<std::uint64_t> max_ratio_;
+  std::shared_ptr<bool> exceeded_;
+  std::uint64_t in_ = 0;
+  std::uint64_t out_ = 0;
+};
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_MIDDLEWARE_DETAIL_OFFLOAD_HPP
+#define FITORIA_WEB_MIDDLEWARE_DETAIL_OFFLOAD_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/net.hpp>
+#include <fitoria/core/optional.hpp>
+
+#include <type_traits>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::middleware::detail {
+
+// Invokes `f` on `ex` if there is one, otherwise inline, and resumes the
+// calling coroutine on its own executor with the result. The caller awaits the
+// result before doing anything else, hence at most one block of a stream is in
+// flight and the order of the blocks is kept.
+template <typename F>
+auto offload(const optional<net::any_io_executor>& ex, F f)
+    -> awaitable<std::invoke_result_t<F&>>
+{
+  using result_type = std::invoke_result_t<F&>;
+
+  if (!ex) {
+    co_return f();
+  }
+
+  co_return co_await net::co_spawn(
+      *ex,
+      [&]() -> net::awaitable<result_type, net::any_io_executor> {
+        co_return f();
+      },
+      net::use_awaitable_t<executor_type>());
+}
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_MIDDLEWARE_DETAIL_SHA256_HPP
+#define FITORIA_WEB_MIDDLEWARE_DETAIL_SHA256_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::middleware::detail {
+
+// SHA-256 (FIPS 180-4) of data which is in memory as a whole, used to identify
+// compression dictionaries.
+inline auto sha256(std::span<const std::byte> data) noexcept
+    -> std::array<std::byte, 32>
+{
+  constexpr auto k = std::array<std::uint32_t, 64> {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+  };
+
+  auto h = std::array<std::uint32_t, 8> {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+  };
+
+  auto process = [&](const std::byte* block) {
+    auto w = std::array<std::uint32_t, 64>();
+    for (std::size_t i = 0; i < 16; ++i) {
+      w[i] = (std::uint32_t(block[i * 4]) << 24)
+          | (std::uint32_t(block[i * 4 + 1]) << 16)
+          | (std::uint32_t(block[i * 4 + 2]) << 8)
+          | std::uint32_t(block[i * 4 + 3]);
+    }
+    for (std::size_t i = 16; i < 64; ++i) {
+      const auto s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18)
+          ^ (w[i - 15] >> 3);
+      const auto s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19)
+          ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    auto v = h;
+    for (std::size_t i = 0; i < 64; ++i) {
+      const auto s1
+          = std::rotr(v[4], 6) ^ std::rotr(v[4], 11) ^ std::rotr(v[4], 25);
+      const auto ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+      const auto t1 = v[7] + s1 + ch + k[i] + w[i];
+      const auto s0
+          = std::rotr(v[0], 2) ^ std::rotr(v[0], 13) ^ std::rotr(v[0], 22);
+      const auto maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+      const auto t2 = s0 + maj;
+      std::shift_right(v.begin(), v.end(), 1);
+      v[4] += t1;
+      v[0] = t1 + t2;
+    }
+    for (std::size_t i = 0; i < 8; ++i) {
+      h[i] += v[i];
+    }
+  };
+
+  const auto full = data.size() - data.size() % 64;
+  for (std::size_t offset = 0; offset < full; offset += 64) {
+    process(data.data() + offset);
+  }
+
+  // the rest of the data, followed by a single set bit and the size of the
+  // data in bits, padded to one or two blocks
+  auto last = std::array<std::byte, 128>();
+  const auto rest = data.size() - full;
+  std::copy_n(data.data() + full, rest, last.data());
+  last[rest] = std::byte(0x80);
+  const auto size = rest < 56 ? std::size_t(64) : std::size_t(128);
+  const auto bits = std::uint64_t(data.size()) * 8;
+  for (std::size_t i = 0; i < 8; ++i) {
+    last[size - 1 - i] = std::byte(bits >> (i * 8));
+  }
+  for (std::size_t offset = 0; offset < size; offset += 64) {
+    process(last.data() + offset);
+  }
+
+  auto digest = std::array<std::byte, 32>();
+  for (std::size_t i = 0; i < 8; ++i) {
+    digest[i * 4] = std::byte(h[i] >> 24);
+    digest[i * 4 + 1] = std::byte(h[i] >> 16);
+    digest[i * 4 + 2] = std::byte(h[i] >> 8);
+    digest[i * 4 + 3] = std::byte(h[i]);
+  }
+
+  return digest;
+}
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_MIDDLEWARE_DETAIL_ZSTD_ERROR_HPP
+#define FITORIA_WEB_MIDDLEWARE_DETAIL_ZSTD_ERROR_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <system_error>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web::middleware::detail {
+
+enum class zstd_error {
+  error = 1,
+
+  init = 99,
+};
+
+class zstd_error_category : public std::error_category {
+public:
+  ~zstd_error_category() override = default;
+
+  const char* name() const noexcept override
+  {
+    return "fitoria.web.zstd_error";
+  }
+
+  std::string message(int condition) const override
+  {
+    switch (static_cast<zstd_error>(condition)) {
+    case zstd_error::error:
+      return "zstd error";
+    case zstd_error::init:
+      return "initialization error";
+    default:
+      break;
+    }
+
+    return {};
+  }
+};
+
+inline std::error_code make_error_code(zstd_error e)
+{
+  static const zstd_error_category c;
+  return { static_cast<int>(e), c };
+}
+}
+
+FITORIA_NAMESPACE_END
+
+template <>
+struct std::is_error_code_enum<
+    FITORIA_NAMESPACE::web::middleware::detail::zstd_error> : std::true_type {
+};
+
+#endif
@@ -0,0 +1,289 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_MULTIPART_OF_HPP
+#define FITORIA_WEB_MULTIPART_OF_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/optional.hpp>
+#include <fitoria/core/strings.hpp>
+
+#include <fitoria/http.hpp>
+#include <fitoria/mime.hpp>
+
+#include <fitoria/web/async_readable_vector_stream.hpp>
+#include <fitoria/web/detail/multipart_parser.hpp>
+#include <fitoria/web/from_request.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web {
+
+namespace detail {
+
+// Gets the value of parameter `name` of a header with parameters, e.g.
+// `form-data; name="field"; filename="a.txt"`.
+inline auto get_disposition_param(std::string_view header,
+                                  std::string_view name)
+    -> optional<std::string>
+{
+  auto pos = header.find(';');
+  while (pos != std::string_view::npos) {
+    header.remove_prefix(pos + 1);
+    header = ltrim(header);
+
+    const auto eq = header.find('=');
+    if (eq == std::string_view::npos) {
+      break;
+    }
+    const auto key = trim(header.substr(0, eq));
+    header.remove_prefix(eq + 1);
+    header = ltrim(header);
+
+    auto value = std::string();
+    if (header.starts_with('"')) {
+      std::size_t i = 1;
+      for (; i < header.size() && header[i] != '"'; ++i) {
+        if (header[i] == '\\' && i + 1 < header.size()) {
+          ++i;
+        }
+        value.push_back(header[i]);
+      }
+      header.remove_prefix(std::min(i + 1, header.size()));
+    } else {
+      value = rtrim(header.substr(0, header.find(';')));
+    }
+
+    if (cmp_eq_ci(key, name)) {
+      return value;
+    }
+    pos = header.find(';');
+  }
+
+  return nullopt;
+}
+
+// Gets the boundary of a `multipart/form-data` `Content-Type`. The boundary is
+// read from the raw header since it may be quoted and may start with `-`, e.g.
+// `----WebKitFormBoundary...`, and is checked against the `bchars` of RFC 2046.
+inline auto get_multipart_boundary(std::string_view content_type)
+    -> optional<std::string>
+{
+  auto boundary = get_disposition_param(content_type, "boundary");
+  if (!boundary || boundary->empty() || boundary->size() > 70
+      || boundary->ends_with(' ')) {
+    return nullopt;
+  }
+
+  constexpr auto bchars = std::string_view("'()+_,-./:=? ");
+  const auto is_bchar = [&](char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z')
+        || (c >= 'A' && c <= 'Z') || bchars.find(c) != std::string_view::npos;
+  };
+  if (!std::all_of(boundary->begin(), boundary->end(), is_bchar)) {
+    return nullopt;
+  }
+
+  return boundary;
+}
+
+}
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// A part of a ``multipart/form-data`` body.
+///
+/// DESCRIPTION
+///   A part of a ``multipart/form-data`` body, which is an async readable
+///   stream of the part's data. The data is read directly from the request
+///   body, thus a part must be read before moving on to the next part, e.g.
+///   write a file part into a ``stream_file`` with
+///   ``async_read_into_stream_file``. Reading fails with
+///   ``std::errc::message_size`` once the part exceeds its size limit.
+///
+/// @endverbatim
+class multipart_part {
+  template <std::uint64_t PartLimit>
+  friend class multipart_of;
+
+  multipart_part(std::shared_ptr<detail::multipart_parser> parser,
+                 http::header_map headers,
+                 std::uint64_t limit)
+      : parser_(std::move(parser))
+      , generation_(parser_->generation())
+      , headers_(std::move(headers))
+      , limit_(limit)
+  {
+    if (auto disposition = headers_.get(http::field::content_disposition);
+        disposition) {
+      name_ = detail::get_disposition_param(*disposition, "name");
+      filename_ = detail::get_disposition_param(*disposition, "filename");
+    }
+  }
+
+public:
+  using is_async_readable_stream = void;
+
+  multipart_part(const multipart_part&) = delete;
+
+  multipart_part& operator=(const multipart_part&) = delete;
+
+  multipart_part(multipart_part&&) = default;
+
+  multipart_part& operator=(multipart_part&&) = default;
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the headers of the part.
+  ///
+  /// @endverbatim
+  auto headers() const noexcept -> const http::header_map&
+  {
+    return headers_;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the field name from the ``Content-Disposition`` header.
+  ///
+  /// @endverbatim
+  auto name() const noexcept -> optional<std::string_view>
+  {
+    return name_.transform([](auto& s) { return std::string_view(s); });
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the file name from the ``Content-Disposition`` header.
+  ///
+  /// @endverbatim
+  auto filename() const noexcept -> optional<std::string_view>
+  {
+    return filename_.transform([](auto& s) { return std::string_view(s); });
+  }
+
+  auto
+  async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
+  {
+    // the parser has already moved on to the next part
+    if (parser_->generation() != generation_) {
+      co_return nullopt;
+    }
+
+    auto data = co_await parser_->async_read_body();
+    if (data && *data) {
+      size_ += (*data)->size();
+      if (size_ > limit_) {
+        co_return unexpected { make_error_code(std::errc::message_size) };
+      }
+    }
+
+    co_return data;
+  }
+
+private:
+  std::shared_ptr<detail::multipart_parser> parser_;
+  std::uint64_t generation_;
+  http::header_map headers_;
+  optional<std::string> name_;
+  optional<std::string> filename_;
+  std::uint64_t limit_;
+  std::uint64_t size_ = 0;
+};
+
+#if !defined(FITORIA_DOC)
+
+template <std::uint64_t PartLimit = 8 * 1024 * 1024>
+class multipart_of {
+public:
+  multipart_of(any_async_readable_stream body, std::string_view boundary)
+      : parser_(std::make_shared<detail::multipart_parser>(std::move(body),
+                                                           boundary))
+  {
+  }
+
+  auto async_next_part()
+      -> awaitable<optional<expected<multipart_part, std::error_code>>>
+  {
+    auto headers = co_await parser_->async_next_part();
+    if (!headers) {
+      co_return nullopt;
+    }
+    if (!*headers) {
+      co_return unexpected { headers->error() };
+    }
+
+    co_return multipart_part(parser_, std::move(**headers), PartLimit);
+  }
+
+  friend auto tag_invoke(from_request_t<multipart_of<PartLimit>>, request& req)
+      -> awaitable<expected<multipart_of<PartLimit>, response>>
+  {
+    auto content_type = req.headers().get(http::field::content_type);
+    if (!content_type
+        || !cmp_eq_ci(trim(content_type->substr(0, content_type->find(';'))),
+                      mime::multipart_form_data())) {
+      co_return unexpected {
+        response::bad_request()
+            .set_header(http::field::content_type, mime::text_plain())
+            .set_body(fmt::format(R"("Content-Type: {}" is expected.)",
+                                  mime::multipart_form_data()))
+      };
+    }
+
+    auto boundary = detail::get_multipart_boundary(*content_type);
+    if (!boundary) {
+      co_return unexpected {
+        response::bad_request()
+            .set_header(http::field::content_type, mime::text_plain())
+            .set_body("invalid boundary of multipart body.")
+      };
+    }
+
+    // the parts are read from the body after the extraction, take it over
+    co_return multipart_of<PartLimit>(
+        std::exchange(req.body(), async_readable_vector_stream()), *boundary);
+  }
+
+private:
+  std::shared_ptr<detail::multipart_parser> parser_;
+};
+
+#else
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// Extractor for streaming the parts of a ``multipart/form-data`` body.
+///
+/// DESCRIPTION
+///   Extractor for streaming the parts of a ``multipart/form-data`` body. The
+///   body is parsed incrementally while calling ``async_next_part()``, which
+///   yields each part as a ``multipart_part`` stream without buffering the
+///   whole body in memory. The data of a part is limited to ``PartLimit``
+///   bytes. Any unread data of the current part is skipped when moving on to
+///   the next part.
+///
+/// @endverbatim
+template <std::uint64_t PartLimit = 8 * 1024 * 1024>
+class multipart_of;
+
+#endif
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
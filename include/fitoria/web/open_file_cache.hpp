@@ -0,0 +1,373 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_OPEN_FILE_CACHE_HPP
+#define FITORIA_WEB_OPEN_FILE_CACHE_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/net.hpp>
+
+#include <fitoria/web/async_readable_random_access_file_stream.hpp>
+#include <fitoria/web/detail/static_file_metadata.hpp>
+#include <fitoria/web/request.hpp>
+#include <fitoria/web/response.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#if defined(BOOST_ASIO_HAS_FILE) && !defined(BOOST_ASIO_WINDOWS)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web {
+
+#if defined(BOOST_ASIO_HAS_FILE)
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// A cache of open static files.
+///
+/// DESCRIPTION
+///   A cache of open static files, similar to nginx's ``open_file_cache``. The
+///   descriptor of a recently used file is kept open together with its size,
+///   last write time and pre-rendered headers. The cached descriptor is not
+///   bound to any executor. Each response duplicates it into a
+///   ``random_access_file`` of its own on the executor passed to ``open()``,
+///   thus no Asio I/O object is shared between requests, and reads its range
+///   of the file with positional reads, thus no request moves the position of
+///   another. On Windows, where a handle is bound to a single I/O completion
+///   port, each response opens the file by path instead. A cached file is
+///   compared against the file system again once ``valid`` has elapsed since
+///   the last comparison, and is reopened if its size or last write time has
+///   changed. The least recently used file is closed once more than
+///   ``max_files`` files are open.
+///
+/// @endverbatim
+class open_file_cache {
+#if !defined(BOOST_ASIO_WINDOWS)
+  // An open descriptor which is not bound to any executor.
+  class descriptor {
+  public:
+    explicit descriptor(int fd) noexcept
+        : fd_(fd)
+    {
+    }
+
+    descriptor(descriptor&& other) noexcept
+        : fd_(std::exchange(other.fd_, -1))
+    {
+    }
+
+    descriptor& operator=(descriptor&&) = delete;
+
+    ~descriptor()
+    {
+      if (fd_ >= 0) {
+        ::close(fd_);
+      }
+    }
+
+    auto get() const noexcept -> int
+    {
+      return fd_;
+    }
+
+  private:
+    int fd_;
+  };
+#endif
+
+  struct entry {
+    detail::static_file_metadata meta;
+    std::string path;
+#if !defined(BOOST_ASIO_WINDOWS)
+    descriptor fd;
+#endif
+
+    // Opens a `random_access_file` of the cached file on `ex`.
+    auto open(const executor_type& ex) const
+        -> expected<random_access_file, std::error_code>
+    {
+#if defined(BOOST_ASIO_WINDOWS)
+      return detail::open_file<random_access_file>(ex, path);
+#else
+      const auto dup = ::fcntl(fd.get(), F_DUPFD_CLOEXEC, 0);
+      if (dup < 0) {
+        return unexpected { std::error_code(errno, std::system_category()) };
+      }
+
+      auto file = random_access_file(ex);
+      boost::system::error_code ec;
+      file.assign(dup, ec); // NOLINT
+      if (ec) {
+        ::close(dup);
+        return unexpected { ec };
+      }
+
+      return file;
+#endif
+    }
+  };
+
+  struct node {
+    std::shared_ptr<const entry> value;
+    std::chrono::steady_clock::time_point checked_at;
+    std::list<std::string>::iterator lru;
+  };
+
+public:
+  class builder {
+    friend class open_file_cache;
+
+    std::size_t max_files_ = 1024;
+    std::chrono::steady_clock::duration valid_ = std::chrono::seconds(60);
+
+  public:
+    builder() = default;
+
+    std::shared_ptr<open_file_cache> build() const
+    {
+      return std::make_shared<open_file_cache>(*this);
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the maximum number of open files. Default is 1024.
+    ///
+    /// @endverbatim
+    builder& set_max_files(std::size_t max_files)
+    {
+      max_files_ = std::max<std::size_t>(max_files, 1);
+      return *this;
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the interval between comparisons of a cached file against the file
+    /// system. Pass zero to compare on every hit. Default is 60 seconds.
+    ///
+    /// @endverbatim
+    builder& set_valid(std::chrono::steady_clock::duration valid)
+    {
+      valid_ = valid;
+      return *this;
+    }
+  };
+
+  open_file_cache(builder builder)
+      : max_files_(builder.max_files_)
+      , valid_(builder.valid_)
+  {
+  }
+
+  open_file_cache(const open_file_cache&) = delete;
+
+  open_file_cache& operator=(const open_file_cache&) = delete;
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the number of open files.
+  ///
+  /// @endverbatim
+  auto size() const -> std::size_t
+  {
+    auto lock = std::scoped_lock(mutex_);
+    return entries_.size();
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Close the file if it is open.
+  ///
+  /// DESCRIPTION
+  ///   Close the file if it is open. Responses which are still being sent keep
+  ///   the file open until they are done.
+  ///
+  /// @endverbatim
+  void erase(const std::string& path)
+  {
+    auto lock = std::scoped_lock(mutex_);
+    if (auto it = entries_.find(path); it != entries_.end()) {
+      erase(it);
+    }
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Close all open files.
+  ///
+  /// @endverbatim
+  void clear()
+  {
+    auto lock = std::scoped_lock(mutex_);
+    entries_.clear();
+    lru_.clear();
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Create the ``response`` for the file.
+  ///
+  /// DESCRIPTION
+  ///   Create the ``response`` for the file, opening it on a miss. ``Range`` /
+  ///   ``If-None-Match`` / ``If-Modified-Since`` headers from the ``request``
+  ///   are handled the same way as ``static_file`` does, except that a request
+  ///   for several ranges is answered with the whole file. The body is read on
+  ///   ``ex``.
+  ///
+  /// @endverbatim
+  auto open(const executor_type& ex,
+            const std::string& path,
+            const request& req) -> expected<response, std::error_code>
+  {
+    auto e = lookup(path);
+    if (!e) {
+      auto opened = load(ex, path);
+      if (!opened) {
+        return unexpected { opened.error() };
+      }
+      e = std::move(*opened);
+    }
+
+    auto ec = std::error_code();
+    auto res = detail::make_static_file_response(
+        e->meta,
+        req,
+        [&](response_builder&& builder,
+            std::uint64_t offset,
+            std::uint64_t length) -> response {
+          auto file = e->open(ex);
+          if (!file) {
+            ec = file.error();
+            return response();
+          }
+          return builder.set_body(async_readable_random_access_file_stream(
+                                      std::move(*file), offset, length),
+                                  length);
+        });
+    if (ec) {
+      return unexpected { ec };
+    }
+
+    return res;
+  }
+
+private:
+  auto lookup(const std::string& path) -> std::shared_ptr<const entry>
+  {
+    const auto now = std::chrono::steady_clock::now();
+    auto e = std::shared_ptr<const entry>();
+    {
+      auto lock = std::scoped_lock(mutex_);
+      auto it = entries_.find(path);
+      if (it == entries_.end()) {
+        return nullptr;
+      }
+
+      lru_.splice(lru_.begin(), lru_, it->second.lru);
+      if (now - it->second.checked_at < valid_) {
+        return it->second.value;
+      }
+      e = it->second.value;
+    }
+
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    const auto lwt = ec ? detail::file_time_point()
+                        : std::filesystem::last_write_time(path, ec);
+
+    auto lock = std::scoped_lock(mutex_);
+    auto it = entries_.find(path);
+    const auto current = it != entries_.end() && it->second.value == e;
+    if (ec || size != e->meta.size || lwt != e->meta.last_write_time) {
+      if (current) {
+        erase(it);
+      }
+      return nullptr;
+    }
+    if (current) {
+      it->second.checked_at = now;
+    }
+
+    return e;
+  }
+
+  auto load(const executor_type& ex, const std::string& path)
+      -> expected<std::shared_ptr<const entry>, std::error_code>
+  {
+    auto file = detail::open_file<random_access_file>(ex, path);
+    if (!file) {
+      return unexpected { file.error() };
+    }
+
+    auto lwt = detail::get_last_modified_time(path);
+    if (!lwt) {
+      return unexpected { lwt.error() };
+    }
+
+    const auto size = file->size();
+#if defined(BOOST_ASIO_WINDOWS)
+    auto e = std::make_shared<const entry>(
+        entry { detail::static_file_metadata::make(path, size, *lwt), path });
+#else
+    // keep a duplicate which outlives `file` and the executor it is bound to
+    const auto fd = ::fcntl(file->native_handle(), F_DUPFD_CLOEXEC, 0);
+    if (fd < 0) {
+      return unexpected { std::error_code(errno, std::system_category()) };
+    }
+    auto e = std::make_shared<const entry>(
+        entry { detail::static_file_metadata::make(path, size, *lwt),
+                path,
+                descriptor(fd) });
+#endif
+
+    auto lock = std::scoped_lock(mutex_);
+    if (auto it = entries_.find(path); it != entries_.end()) {
+      erase(it);
+    }
+    while (entries_.size() >= max_files_) {
+      erase(entries_.find(lru_.back()));
+    }
+    lru_.push_front(path);
+    entries_.emplace(
+        path, node { e, std::chrono::steady_clock::now(), lru_.begin() });
+
+    return e;
+  }
+
+  void erase(std::unordered_map<std::string, node>::iterator it)
+  {
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+  }
+
+  std::size_t max_files_;
+  std::chrono::steady_clock::duration valid_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, node> entries_;
+  std::list<std::string> lru_;
+};
+
+#endif
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
@@ -19,6 +19,7 @@
 #include <fitoria/web/any_async_readable_stream.hpp>
 #include <fitoria/web/any_body.hpp>
 #include <fitoria/web/async_readable_vector_stream.hpp>
+#include <fitoria/web/detail/json_codec.hpp>
 
 #include <memory>
 #include <span>
@@ -601,6 +602,14 @@ class response_builder {
   {
   }
 
+  auto set_json_body(bytes buffer) -> response
+  {
+    set_header(http::field::content_type, mime::application_json());
+    body_ = any_body(any_body::sized { buffer.size() },
+                     async_readable_vector_stream(std::move(buffer)));
+    return build();
+  }
+
 public:
   /// @verbatim embed:rst:leading-slashes
   ///
@@ -701,6 +710,16 @@ public:
     return std::move(*this);
   }
 
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get HTTP headers map.
+  ///
+  /// @endverbatim
+  auto headers() noexcept -> http::header_map&
+  {
+    return header_;
+  }
+
   /// @verbatim embed:rst:leading-slashes
   ///
   /// Insert HTTP headers.
@@ -812,6 +831,26 @@ public:
     return build();
   }
 
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Set a stream body of known size and create the ``response``.
+  ///
+  /// DESCRIPTION
+  ///   Set a stream body of known size and create the ``response``. The body is
+  ///   sent with ``Content-Length: size`` and written chunk by chunk as it is
+  ///   read from the stream, without being buffered. The connection is closed
+  ///   if the stream yields more or less than ``size`` bytes. Note that current
+  ///   object is no longer usable after calling this function.
+  ///
+  /// @endverbatim
+  template <async_readable_stream AsyncReadableStream>
+  auto set_body(AsyncReadableStream&& stream, std::size_t size) -> response
+  {
+    body_ = any_body(any_body::sized { size },
+                     std::forward<AsyncReadableStream>(stream));
+    return build();
+  }
+
   /// @verbatim embed:rst:leading-slashes
   ///
   /// Set a json object as the body and create the ``response``.
@@ -824,9 +863,9 @@ public:
   /// @endverbatim
   auto set_json(const boost::json::value& jv) -> response
   {
-    auto str = boost::json::serialize(jv);
-    set_header(http::field::content_type, mime::application_json());
-    return set_body(std::as_bytes(std::span(str.begin(), str.end())));
+    auto buffer = bytes();
+    detail::json_encode(jv, buffer);
+    return set_json_body(std::move(buffer));
   }
 
   /// @verbatim embed:rst:leading-slashes
@@ -842,10 +881,17 @@ public:
   ///
   /// @endverbatim
   template <typename T>
-    requires(boost::json::has_value_from<T>::value)
+    requires(boost::json::has_value_from<T>::value
+             || detail::json_direct_encodable<T>)
   auto set_json(const T& obj) -> response
   {
-    return set_json(boost::json::value_from(obj));
+    if constexpr (boost::json::has_value_from<T>::value) {
+      return set_json(boost::json::value_from(obj));
+    } else {
+      auto buffer = bytes();
+      detail::json_encode(obj, buffer);
+      return set_json_body(std::move(buffer));
+    }
   }
 
   /// @verbatim embed:rst:leading-slashes
@@ -0,0 +1,434 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_SSE_HPP
+#define FITORIA_WEB_SSE_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/net.hpp>
+#include <fitoria/core/optional.hpp>
+
+#include <fitoria/http.hpp>
+#include <fitoria/mime.hpp>
+
+#include <fitoria/web/async_readable_stream_concept.hpp>
+#include <fitoria/web/to_response.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web {
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// An event of ``text/event-stream``.
+///
+/// @endverbatim
+struct sse_event {
+  optional<std::string> id;
+  optional<std::string> event;
+  std::string data;
+  optional<std::chrono::milliseconds> retry;
+};
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// What to do with a subscriber whose queue is full.
+///
+/// @endverbatim
+enum class sse_overflow_policy {
+  drop_oldest,
+  disconnect,
+};
+
+namespace detail {
+
+using sse_buffer = std::shared_ptr<const bytes>;
+
+using sse_channel_t = net::experimental::concurrent_channel<
+    executor_type,
+    void(boost::system::error_code, sse_buffer)>;
+
+inline void sse_append(bytes& out, std::string_view sv)
+{
+  const auto size = out.size();
+  out.resize(size + sv.size());
+  std::memcpy(out.data() + size, sv.data(), sv.size());
+}
+
+// Appends a single line field, a line break in the value would end the field
+// early and inject another field, thus CR and LF are stripped.
+inline void sse_append_field(bytes& out,
+                             std::string_view name,
+                             std::string_view value)
+{
+  sse_append(out, name);
+  sse_append(out, ": ");
+  for (auto pos = value.find_first_of("\r\n"); pos != std::string_view::npos;
+       pos = value.find_first_of("\r\n")) {
+    sse_append(out, value.substr(0, pos));
+    value.remove_prefix(pos + 1);
+  }
+  sse_append(out, value);
+  sse_append(out, "\n");
+}
+
+inline auto format_sse_event(const sse_event& ev) -> bytes
+{
+  auto out = bytes();
+  out.reserve(ev.data.size() + 64);
+  if (ev.id) {
+    sse_append_field(out, "id", *ev.id);
+  }
+  if (ev.event) {
+    sse_append_field(out, "event", *ev.event);
+  }
+  if (ev.retry) {
+    sse_append_field(out, "retry", std::to_string(ev.retry->count()));
+  }
+
+  // every line of the payload needs its own "data:" field, lines end with
+  // CRLF, CR or LF
+  auto data = std::string_view(ev.data);
+  for (;;) {
+    const auto pos = data.find_first_of("\r\n");
+    sse_append(out, "data: ");
+    sse_append(out, data.substr(0, pos));
+    sse_append(out, "\n");
+    if (pos == std::string_view::npos) {
+      break;
+    }
+    data.remove_prefix(data.substr(pos, 2) == "\r\n" ? pos + 2 : pos + 1);
+  }
+  sse_append(out, "\n");
+
+  return out;
+}
+
+}
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// An async readable stream of ``text/event-stream`` for one subscriber of a
+/// ``sse_broadcaster``.
+///
+/// DESCRIPTION
+///   An async readable stream of ``text/event-stream`` for one subscriber of a
+///   ``sse_broadcaster``. Returning it from a handler responds with
+///   ``Content-Type: text/event-stream``. A keep-alive comment is sent whenever
+///   no event is published for the keep-alive interval, and an explicit flush
+///   is requested before waiting for the next event so that events are never
+///   held back by chunk coalescing.
+///
+/// @endverbatim
+class sse_stream {
+  friend class sse_broadcaster;
+
+  sse_stream(std::shared_ptr<detail::sse_channel_t> channel,
+             std::chrono::steady_clock::duration keep_alive_interval)
+      : channel_(std::move(channel))
+      , keep_alive_interval_(keep_alive_interval)
+  {
+  }
+
+public:
+  using is_async_readable_stream = void;
+
+  sse_stream(const sse_stream&) = delete;
+
+  sse_stream& operator=(const sse_stream&) = delete;
+
+  sse_stream(sse_stream&&) = default;
+
+  sse_stream& operator=(sse_stream&&) = default;
+
+  auto
+  async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
+  {
+    auto ec = boost::system::error_code();
+    auto buffer = detail::sse_buffer();
+    if (channel_->try_receive(
+            [&](boost::system::error_code e, detail::sse_buffer b) {
+              ec = e;
+              buffer = std::move(b);
+            })) {
+      co_return on_receive(ec, std::move(buffer));
+    }
+
+    if (std::exchange(pending_flush_, false)) {
+      co_return bytes();
+    }
+
+    // the channel is empty, instead of racing the receive against a timer,
+    // which may drop an event received right when the timer expires, the
+    // timer queues a null buffer standing for a keep-alive
+    auto timer = net::steady_timer(co_await net::this_coro::executor);
+    if (keep_alive_interval_ > std::chrono::steady_clock::duration::zero()) {
+      timer.expires_after(keep_alive_interval_);
+      timer.async_wait(
+          [channel = std::weak_ptr(channel_)](boost::system::error_code e) {
+            if (auto c = channel.lock(); c && !e) {
+              c->try_send(boost::system::error_code(), nullptr);
+            }
+          });
+    }
+
+    auto result = co_await channel_->async_receive(use_awaitable);
+    timer.cancel();
+    co_return result ? on_receive({}, std::move(*result))
+                     : on_receive(result.error(), nullptr);
+  }
+
+  template <decay_to<sse_stream> Self>
+  friend auto tag_invoke(to_response_t, Self&& self) -> response
+  {
+    return response::ok()
+        .set_header(http::field::content_type, mime::text_event_stream())
+        .set_header(http::field::cache_control, "no-cache")
+        .set_stream_body(std::move(self));
+  }
+
+private:
+  static auto to_bytes(std::string_view sv) -> bytes
+  {
+    auto out = bytes();
+    detail::sse_append(out, sv);
+    return out;
+  }
+
+  auto on_receive(boost::system::error_code ec, detail::sse_buffer buffer)
+      -> optional<expected<bytes, std::error_code>>
+  {
+    if (ec) {
+      if (ec == make_error_code(net::experimental::error::channel_closed)) {
+        return nullopt;
+      }
+      return unexpected { ec };
+    }
+
+    pending_flush_ = true;
+    if (!buffer) {
+      return to_bytes(": keep-alive\n\n");
+    }
+    return bytes(buffer->begin(), buffer->end());
+  }
+
+  std::shared_ptr<detail::sse_channel_t> channel_;
+  std::chrono::steady_clock::duration keep_alive_interval_;
+  bool pending_flush_ = false;
+};
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// Fan-out of server-sent events to many subscribers.
+///
+/// DESCRIPTION
+///   Fan-out of server-sent events to many subscribers. An event is formatted
+///   once into an immutable ref-counted buffer which is queued to every
+///   subscriber. A subscriber whose queue is full is handled according to the
+///   ``sse_overflow_policy``. Recently published events are kept so that a
+///   reconnecting client sending ``Last-Event-ID`` receives the events it
+///   missed. Events without an id are assigned an increasing numeric id.
+///   ``publish`` can be called from any thread.
+///
+/// @endverbatim
+class sse_broadcaster {
+public:
+  class builder {
+    friend class sse_broadcaster;
+
+    std::size_t max_queue_size_ = 64;
+    std::size_t history_size_ = 128;
+    std::chrono::steady_clock::duration keep_alive_interval_
+        = std::chrono::seconds(15);
+    sse_overflow_policy overflow_policy_ = sse_overflow_policy::drop_oldest;
+
+  public:
+    builder() = default;
+
+    std::shared_ptr<sse_broadcaster> build() const
+    {
+      return std::make_shared<sse_broadcaster>(*this);
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the maximum number of events queued for a subscriber. Default is
+    /// 64.
+    ///
+    /// @endverbatim
+    builder& set_max_queue_size(std::size_t size)
+    {
+      max_queue_size_ = std::max<std::size_t>(size, 1);
+      return *this;
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the number of recent events kept for ``Last-Event-ID``. Default is
+    /// 128.
+    ///
+    /// @endverbatim
+    builder& set_history_size(std::size_t size)
+    {
+      history_size_ = size;
+      return *this;
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the interval of keep-alive comments. Pass zero to disable them.
+    /// Default is 15 seconds.
+    ///
+    /// @endverbatim
+    builder&
+    set_keep_alive_interval(std::chrono::steady_clock::duration interval)
+    {
+      keep_alive_interval_ = interval;
+      return *this;
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the policy for subscribers whose queue is full. Default is
+    /// ``sse_overflow_policy::drop_oldest``.
+    ///
+    /// @endverbatim
+    builder& set_overflow_policy(sse_overflow_policy policy)
+    {
+      overflow_policy_ = policy;
+      return *this;
+    }
+  };
+
+  sse_broadcaster(builder builder)
+      : max_queue_size_(builder.max_queue_size_)
+      , history_size_(builder.history_size_)
+      , keep_alive_interval_(builder.keep_alive_interval_)
+      , overflow_policy_(builder.overflow_policy_)
+  {
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Create a stream for a new subscriber.
+  ///
+  /// DESCRIPTION
+  ///   Create a stream for a new subscriber. If ``last_event_id`` names an
+  ///   event which is still in the history, the events published after it are
+  ///   replayed first.
+  ///
+  /// @endverbatim
+  auto subscribe(const executor_type& ex,
+                 optional<std::string_view> last_event_id = nullopt)
+      -> sse_stream
+  {
+    auto channel
+        = std::make_shared<detail::sse_channel_t>(ex, max_queue_size_);
+
+    auto lock = std::scoped_lock(mutex_);
+    if (last_event_id) {
+      auto it = history_.end();
+      for (auto i = history_.begin(); i != history_.end(); ++i) {
+        if (i->first == *last_event_id) {
+          it = std::next(i);
+        }
+      }
+      if (static_cast<std::size_t>(std::distance(it, history_.end()))
+          > max_queue_size_) {
+        it = history_.end() - static_cast<std::ptrdiff_t>(max_queue_size_);
+      }
+      for (; it != history_.end(); ++it) {
+        channel->try_send(boost::system::error_code(), it->second);
+      }
+    }
+    subscribers_.push_back(channel);
+
+    return sse_stream(std::move(channel), keep_alive_interval_);
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Publish an event to all subscribers.
+  ///
+  /// @endverbatim
+  void publish(sse_event ev)
+  {
+    auto lock = std::scoped_lock(mutex_);
+    if (!ev.id) {
+      ev.id = std::to_string(++last_id_);
+    }
+    auto buffer = std::make_shared<const bytes>(detail::format_sse_event(ev));
+
+    if (history_size_ > 0) {
+      if (history_.size() == history_size_) {
+        history_.pop_front();
+      }
+      history_.emplace_back(std::move(*ev.id), buffer);
+    }
+
+    std::erase_if(subscribers_, [&](auto& weak) {
+      auto channel = weak.lock();
+      if (!channel) {
+        return true;
+      }
+      if (channel->try_send(boost::system::error_code(), buffer)) {
+        return false;
+      }
+      if (overflow_policy_ == sse_overflow_policy::drop_oldest) {
+        channel->try_receive([](auto, auto) { });
+        return !channel->try_send(boost::system::error_code(), buffer);
+      }
+
+      channel->close();
+      return true;
+    });
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the number of subscribers.
+  ///
+  /// @endverbatim
+  auto subscriber_count() -> std::size_t
+  {
+    auto lock = std::scoped_lock(mutex_);
+    std::erase_if(subscribers_, [](auto& weak) { return weak.expired(); });
+    return subscribers_.size();
+  }
+
+private:
+  std::size_t max_queue_size_;
+  std::size_t history_size_;
+  std::chrono::steady_clock::duration keep_alive_interval_;
+  sse_overflow_policy overflow_policy_;
+
+  std::mutex mutex_;
+  std::uint64_t last_id_ = 0;
+  std::deque<std::pair<std::string, detail::sse_buffer>> history_;
+  std::vector<std::weak_ptr<detail::sse_channel_t>> subscribers_;
+};
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
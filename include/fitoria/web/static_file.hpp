@@ -18,10 +18,16 @@
 #include <fitoria/http.hpp>
 
 #include <fitoria/web/async_readable_file_stream.hpp>
+#include <fitoria/web/detail/async_readable_byteranges_stream.hpp>
+#include <fitoria/web/detail/static_file_metadata.hpp>
 #include <fitoria/web/request.hpp>
 #include <fitoria/web/to_response.hpp>
 
+#include <algorithm>
 #include <filesystem>
+#include <iterator>
+#include <string_view>
+#include <vector>
 
 FITORIA_NAMESPACE_BEGIN
 
@@ -35,19 +41,28 @@ namespace web {
 ///
 /// @endverbatim
 class static_file {
+  friend class static_files;
+
   struct full_range_only_t { };
   struct full_range_t { };
   struct range_not_satisfiable_t { };
   struct bad_request_t { };
   struct not_modified_t { };
+  struct multi_range_t {
+    std::vector<http::header::range::subrange_t> ranges;
+  };
 
   using state_t = std::variant<full_range_only_t,
                                full_range_t,
                                range_not_satisfiable_t,
                                http::header::range::subrange_t,
+                               multi_range_t,
                                bad_request_t,
                                not_modified_t>;
 
+  // Requests for more ranges than this are served with the whole file.
+  static constexpr std::size_t max_ranges = 64;
+
 public:
   /// @verbatim embed:rst:leading-slashes
   ///
@@ -91,6 +106,16 @@ public:
     return content_disposition_;
   }
 
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get ``Content-Encoding`` of the precompressed file being served, if any.
+  ///
+  /// @endverbatim
+  auto content_encoding() const noexcept -> optional<std::string_view>
+  {
+    return content_encoding_;
+  }
+
   /// @verbatim embed:rst:leading-slashes
   ///
   /// Get the reference to the underlying ``stream_file``.
@@ -134,20 +159,20 @@ public:
   static auto open(const executor_type& ex, const std::string& path)
       -> expected<static_file, std::error_code>
   {
-    auto file = open_file(ex, path);
+    auto file = detail::open_file<stream_file>(ex, path);
     if (!file) {
       return unexpected { file.error() };
     }
 
-    auto lmd = get_last_modified_time(path);
+    auto lmd = detail::get_last_modified_time(path);
     if (!lmd) {
       return unexpected { lmd.error() };
     }
 
-    auto etag = get_etag(file->size(), *lmd);
+    auto etag = detail::get_etag(file->size(), *lmd);
     auto ct = mime::mime_view::from_path(path).value_or(
         mime::application_octet_stream());
-    auto cd = get_content_disposition(path, ct);
+    auto cd = detail::get_content_disposition(path, ct);
 
     return static_file(std::move(*file),
                        ct,
@@ -166,71 +191,33 @@ public:
   ///   ``If-Modified-Since`` headers from the ``request`` will be handled
   ///   automatically, and ``Content-Type`` / ``Content-Disposition`` headers
   ///   for the ``response`` will be obtained from the provided file extension.
+  ///   If the ``request`` accepts ``br``, ``zstd`` or ``gzip``, a precompressed
+  ///   sibling of the file, i.e. ``path`` followed by ``.br``, ``.zst`` or
+  ///   ``.gz``, is served instead when it exists, along with the
+  ///   ``Content-Encoding`` and ``Vary`` headers. The ``ETag`` and ``Range``
+  ///   headers then refer to the precompressed content. Overlapping or
+  ///   adjacent ranges are coalesced, and a request for several ranges is
+  ///   answered with a ``multipart/byteranges`` body.
   ///
   /// @endverbatim
   static auto open(const executor_type& ex,
                    const std::string& path,
                    const request& req) -> expected<static_file, std::error_code>
   {
-    auto file = open_file(ex, path);
+    auto file
+        = open_preferred(path, req.headers(), [&](const std::string& p) {
+            return detail::open_file<stream_file>(ex, p);
+          });
     if (!file) {
       return unexpected { file.error() };
     }
 
-    auto lmd = get_last_modified_time(path);
+    auto lmd = detail::get_last_modified_time(file->path);
     if (!lmd) {
       return unexpected { lmd.error() };
     }
 
-    auto etag = get_etag(file->size(), *lmd);
-    auto not_modified = check_if_not_modified(etag, *lmd, req.headers());
-    auto ct = mime::mime_view::from_path(path).value_or(
-        mime::application_octet_stream());
-    auto cd = get_content_disposition(path, ct);
-
-    if (!not_modified) {
-      return static_file(std::move(*file),
-                         ct,
-                         cd,
-                         bad_request_t {},
-                         http::header::date(*lmd),
-                         std::move(etag));
-    }
-    if (*not_modified) {
-      return static_file(std::move(*file),
-                         ct,
-                         cd,
-                         not_modified_t {},
-                         http::header::date(*lmd),
-                         std::move(etag));
-    }
-
-    if (auto header = req.headers().get(http::field::range); header) {
-      if (auto range = http::header::range::parse(*header, file->size()); range
-          && cmp_eq_ci(range->unit(), "bytes")
-          && (*range)[0].offset + (*range)[0].length <= file->size()) {
-        return static_file(std::move(*file),
-                           ct,
-                           cd,
-                           (*range)[0],
-                           http::header::date(*lmd),
-                           std::move(etag));
-      }
-
-      return static_file(std::move(*file),
-                         ct,
-                         cd,
-                         range_not_satisfiable_t {},
-                         http::header::date(*lmd),
-                         std::move(etag));
-    }
-
-    return static_file(std::move(*file),
-                       ct,
-                       cd,
-                       full_range_t {},
-                       http::header::date(*lmd),
-                       std::move(etag));
+    return make(std::move(*file), path, *lmd, req);
   }
 
   template <decay_to<static_file> Self>
@@ -239,25 +226,31 @@ public:
     return std::visit(
         overloaded {
             [&](full_range_only_t) {
-              return response::ok()
+              auto builder = response::ok();
+              builder
                   .set_header(http::field::last_modified,
                               self.last_modified_time_.to_string())
                   .set_header(http::field::etag, self.etag().to_string())
                   .set_header(http::field::content_type, self.content_type())
                   .set_header(http::field::content_disposition,
-                              self.content_disposition())
-                  .set_stream_body(async_readable_file_stream(self.release()));
+                              self.content_disposition());
+              self.set_content_encoding(builder, true);
+              return builder.set_stream_body(
+                  async_readable_file_stream(self.release()));
             },
             [&](full_range_t) {
-              return response::ok()
+              auto builder = response::ok();
+              builder
                   .set_header(http::field::last_modified,
                               self.last_modified_time_.to_string())
                   .set_header(http::field::etag, self.etag().to_string())
                   .set_header(http::field::content_type, self.content_type())
                   .set_header(http::field::content_disposition,
                               self.content_disposition())
-                  .set_header(http::field::accept_ranges, "bytes")
-                  .set_stream_body(async_readable_file_stream(self.release()));
+                  .set_header(http::field::accept_ranges, "bytes");
+              self.set_content_encoding(builder, true);
+              return builder.set_stream_body(
+                  async_readable_file_stream(self.release()));
             },
             [&](range_not_satisfiable_t) {
               return response::range_not_satisfiable()
@@ -267,7 +260,8 @@ public:
                   .build();
             },
             [&](http::header::range::subrange_t range) {
-              return response::partial_content()
+              auto builder = response::partial_content();
+              builder
                   .set_header(http::field::last_modified,
                               self.last_modified_time_.to_string())
                   .set_header(http::field::etag, self.etag().to_string())
@@ -279,9 +273,32 @@ public:
                               fmt::format("bytes {}-{}/{}",
                                           range.offset,
                                           range.offset + range.length - 1,
-                                          range.length))
-                  .set_stream_body(async_readable_file_stream(
-                      self.release(), range.offset, range.length));
+                                          self.file().size()));
+              self.set_content_encoding(builder, true);
+              return builder.set_stream_body(async_readable_file_stream(
+                  self.release(), range.offset, range.length));
+            },
+            [&](const multi_range_t& multi) {
+              const auto boundary = detail::make_multipart_boundary();
+              auto stream = detail::async_readable_byteranges_stream(
+                  self.release(),
+                  boundary,
+                  self.content_type(),
+                  multi.ranges);
+              const auto length = stream.size();
+              auto builder = response::partial_content();
+              builder
+                  .set_header(http::field::last_modified,
+                              self.last_modified_time_.to_string())
+                  .set_header(http::field::etag, self.etag().to_string())
+                  .set_header(http::field::content_type,
+                              fmt::format("{}; boundary={}",
+                                          mime::multipart_byteranges(),
+                                          boundary))
+                  .set_header(http::field::content_disposition,
+                              self.content_disposition())
+                  .set_header(http::field::accept_ranges, "bytes");
+              return builder.set_body(std::move(stream), length);
             },
             [&](bad_request_t) {
               return response::bad_request()
@@ -291,11 +308,13 @@ public:
                   .build();
             },
             [&](not_modified_t) {
-              return response::not_modified()
+              auto builder = response::not_modified();
+              builder
                   .set_header(http::field::last_modified,
                               self.last_modified_time_.to_string())
-                  .set_header(http::field::etag, self.etag().to_string())
-                  .set_body("");
+                  .set_header(http::field::etag, self.etag().to_string());
+              self.set_content_encoding(builder, false);
+              return builder.set_body("");
             },
         },
         self.state_);
@@ -307,98 +326,134 @@ private:
               std::string content_disposition,
               state_t state,
               http::header::date last_modified_time,
-              http::header::entity_tag etag)
+              http::header::entity_tag etag,
+              optional<std::string_view> content_encoding = nullopt)
       : file_(std::move(file))
       , content_type_(std::move(content_type))
       , content_disposition_(std::move(content_disposition))
       , state_(state)
       , last_modified_time_(last_modified_time)
       , etag_(std::move(etag))
+      , content_encoding_(content_encoding)
   {
   }
 
-  static auto open_file(const executor_type& ex, const std::string& path)
-      -> expected<stream_file, std::error_code>
+  struct representation_t {
+    stream_file file;
+    std::string path;
+    optional<std::string_view> content_encoding;
+  };
+
+  // Opens the precompressed sibling of the file with the content coding most
+  // preferred by the request, ties are broken in the order of
+  // `detail::precompressed_encodings`. Falls back to the file itself. `open`
+  // opens a file by path.
+  template <typename Open>
+  static auto open_preferred(const std::string& path,
+                             const http::header_map& headers,
+                             Open&& open)
+      -> expected<representation_t, std::error_code>
   {
-    auto file = stream_file(ex);
-
-    boost::system::error_code ec;
-    file.open(path, net::file_base::read_only, ec); // NOLINT
-    if (ec) {
-      return unexpected { ec };
+    if (auto header = headers.get(http::field::accept_encoding); header) {
+      if (auto ae = http::header::accept_encoding::parse(*header); ae) {
+        auto candidates = detail::precompressed_encodings;
+        std::ranges::stable_sort(
+            candidates, std::ranges::greater(), [&](auto& candidate) {
+              return ae->quality(candidate.content_encoding);
+            });
+        for (auto& candidate : candidates) {
+          if (ae->quality(candidate.content_encoding) == 0) {
+            break;
+          }
+
+          auto sibling = path + std::string(candidate.extension);
+          if (auto file = open(sibling); file) {
+            return representation_t { std::move(*file),
+                                      std::move(sibling),
+                                      candidate.content_encoding };
+          }
+        }
+      }
     }
 
-    return file;
-  }
-
-  static auto get_last_modified_time(const std::string& path)
-      -> expected<std::chrono::time_point<std::chrono::file_clock>,
-                  std::error_code>
-  {
-    std::error_code ec;
-    if (auto time = std::filesystem::last_write_time(path, ec); !ec) {
-      return time;
+    auto file = open(path);
+    if (!file) {
+      return unexpected { file.error() };
     }
 
-    return unexpected { ec };
-  }
-
-  static auto get_etag(const std::uint64_t size,
-                       const std::chrono::time_point<std::chrono::file_clock>&
-                           last_modified_time) -> http::header::entity_tag
-  {
-    return http::header::entity_tag::make_strong(
-        fmt::format("{}-{:016x}",
-                    size,
-                    std::chrono::floor<std::chrono::seconds>(
-                        chrono::to_utc(last_modified_time))
-                        .time_since_epoch()
-                        .count()));
+    return representation_t { std::move(*file), path, nullopt };
   }
 
-  static auto get_content_disposition(const std::string& path,
-                                      const mime::mime_view& ct) -> std::string
+  // Creates the `static_file` for the opened representation of `path`,
+  // handling `Range` / `If-None-Match` / `If-Modified-Since` headers.
+  static auto make(representation_t file,
+                   const std::string& path,
+                   const detail::file_time_point& lmd,
+                   const request& req) -> static_file
   {
-    if (ct.type() == "audio" || ct.type() == "image" || ct.type() == "text"
-        || ct.type() == "video" || ct == mime::application_javascript()
-        || ct == mime::application_json() || ct == mime::application_wasm()) {
-      return fmt::format("inline");
-    }
+    const auto size = file.file.size();
+    auto etag
+        = detail::get_etag(size, lmd, file.content_encoding.value_or(""));
+    auto ct = mime::mime_view::from_path(path).value_or(
+        mime::application_octet_stream());
+    auto cd = detail::get_content_disposition(path, ct);
 
-    auto p = std::filesystem::path(path);
-    return fmt::format(R"(attachment; filename="{}")", p.filename().string());
-  }
+    auto state = [&]() -> state_t {
+      auto not_modified
+          = detail::check_if_not_modified(etag, lmd, req.headers());
+      if (!not_modified) {
+        return bad_request_t {};
+      }
+      if (*not_modified) {
+        return not_modified_t {};
+      }
 
-  static auto check_if_not_modified(
-      const http::header::entity_tag& etag,
-      [[maybe_unused]] const std::chrono::time_point<std::chrono::file_clock>&
-          last_modified_time,
-      const http::header_map& headers) -> optional<bool>
-  {
-    if (auto header = headers.get(http::field::if_none_match); header) {
-      if (auto m = http::header::if_none_match::parse(*header); m) {
-        return m->is_any()
-            || std::any_of(m->begin(), m->end(), [&](auto& element) {
-                 return etag.weakly_equal_to(element);
-               });
+      if (auto header = req.headers().get(http::field::range); header) {
+        auto ranges = std::vector<http::header::range::subrange_t>();
+        if (auto range = http::header::range::parse(*header, size);
+            range && cmp_eq_ci(range->unit(), "bytes")) {
+          std::ranges::copy_if(
+              *range, std::back_inserter(ranges), [&](auto& r) {
+                return r.length > 0 && r.offset + r.length <= size;
+              });
+        }
+        if (ranges.empty()) {
+          return range_not_satisfiable_t {};
+        }
+
+        ranges = detail::coalesce_ranges(std::move(ranges));
+        if (ranges.size() == 1) {
+          return ranges[0];
+        }
+        // the parts of a multipart body cannot carry the content coding of
+        // a precompressed file, serve it as a whole instead
+        if (ranges.size() > max_ranges || file.content_encoding) {
+          return full_range_t {};
+        }
+
+        return multi_range_t { std::move(ranges) };
       }
 
-      return nullopt;
-    }
+      return full_range_t {};
+    }();
 
-#if defined(FITORIA_HAS_STD_CHRONO_PARSE)
+    return static_file(std::move(file.file),
+                       ct,
+                       cd,
+                       state,
+                       http::header::date(lmd),
+                       std::move(etag),
+                       file.content_encoding);
+  }
 
-    if (auto header = headers.get(http::field::if_modified_since); header) {
-      if (auto d = http::header::date::parse(*header); d) {
-        return http::header::date(last_modified_time) <= *d;
+  void set_content_encoding(response_builder& builder, bool has_content) const
+  {
+    if (content_encoding_) {
+      if (has_content) {
+        builder.set_header(http::field::content_encoding, *content_encoding_);
       }
-
-      return nullopt;
+      builder.set_header(http::field::vary, "Accept-Encoding");
     }
-
-#endif
-
-    return false;
   }
 
   stream_file file_;
@@ -407,6 +462,7 @@ private:
   state_t state_;
   http::header::date last_modified_time_;
   http::header::entity_tag etag_;
+  optional<std::string_view> content_encoding_;
 };
 
 #endif
@@ -0,0 +1,367 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_STATIC_FILE_CACHE_HPP
+#define FITORIA_WEB_STATIC_FILE_CACHE_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/bytes.hpp>
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/net.hpp>
+
+#include <fitoria/http.hpp>
+#include <fitoria/mime.hpp>
+
+#include <fitoria/web/async_readable_shared_buffer_stream.hpp>
+#include <fitoria/web/detail/static_file_metadata.hpp>
+#include <fitoria/web/open_file_cache.hpp>
+#include <fitoria/web/request.hpp>
+#include <fitoria/web/response.hpp>
+#include <fitoria/web/static_file.hpp>
+#include <fitoria/web/to_response.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web {
+
+#if defined(BOOST_ASIO_HAS_FILE)
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// An in-memory cache of small static files.
+///
+/// DESCRIPTION
+///   An in-memory cache of small static files. The content of a file is kept
+///   in memory together with its pre-rendered ``Last-Modified``, ``ETag``,
+///   ``Content-Type`` and ``Content-Disposition`` headers, so that a hit is
+///   served without touching the file system. Files are evicted in least
+///   recently used order once the cached content exceeds ``max_size``. A
+///   cached file is compared against the file system again once
+///   ``check_interval`` has elapsed since the last comparison, and is reloaded
+///   if its size or last write time has changed. Files larger than
+///   ``max_file_size`` are served by the ``open_file_cache`` if there is one,
+///   or by ``static_file`` otherwise, without being cached in memory.
+///
+/// @endverbatim
+class static_file_cache {
+  struct entry {
+    detail::static_file_metadata meta;
+    std::shared_ptr<const bytes> data;
+  };
+
+  struct node {
+    std::shared_ptr<const entry> value;
+    std::chrono::steady_clock::time_point checked_at;
+    std::list<std::string>::iterator lru;
+  };
+
+public:
+  class builder {
+    friend class static_file_cache;
+
+    std::uint64_t max_size_ = 64 * 1024 * 1024;
+    std::uint64_t max_file_size_ = 1024 * 1024;
+    std::chrono::steady_clock::duration check_interval_
+        = std::chrono::seconds(1);
+    std::shared_ptr<open_file_cache> open_files_;
+
+  public:
+    builder() = default;
+
+    std::shared_ptr<static_file_cache> build() const
+    {
+      return std::make_shared<static_file_cache>(*this);
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the maximum number of bytes of cached content. Default is 64 MiB.
+    ///
+    /// @endverbatim
+    builder& set_max_size(std::uint64_t size)
+    {
+      max_size_ = size;
+      return *this;
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the maximum size of a file to be cached. Default is 1 MiB.
+    ///
+    /// @endverbatim
+    builder& set_max_file_size(std::uint64_t size)
+    {
+      max_file_size_ = size;
+      return *this;
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the interval between comparisons of a cached file against the file
+    /// system. Pass zero to compare on every hit. Default is 1 second.
+    ///
+    /// @endverbatim
+    builder& set_check_interval(std::chrono::steady_clock::duration interval)
+    {
+      check_interval_ = interval;
+      return *this;
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the ``open_file_cache`` serving files which are too large to be
+    /// cached. Files are opened by ``static_file`` on each request otherwise.
+    ///
+    /// @endverbatim
+    builder& set_open_file_cache(std::shared_ptr<open_file_cache> open_files)
+    {
+      open_files_ = std::move(open_files);
+      return *this;
+    }
+  };
+
+  static_file_cache(builder builder)
+      : max_size_(builder.max_size_)
+      , max_file_size_(builder.max_file_size_)
+      , check_interval_(builder.check_interval_)
+      , open_files_(std::move(builder.open_files_))
+  {
+  }
+
+  static_file_cache(const static_file_cache&) = delete;
+
+  static_file_cache& operator=(const static_file_cache&) = delete;
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the number of cached files.
+  ///
+  /// @endverbatim
+  auto size() const -> std::size_t
+  {
+    auto lock = std::scoped_lock(mutex_);
+    return entries_.size();
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the number of bytes of cached content.
+  ///
+  /// @endverbatim
+  auto total_size() const -> std::uint64_t
+  {
+    auto lock = std::scoped_lock(mutex_);
+    return total_size_;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Remove the file from the cache.
+  ///
+  /// @endverbatim
+  void erase(const std::string& path)
+  {
+    auto lock = std::scoped_lock(mutex_);
+    if (auto it = entries_.find(path); it != entries_.end()) {
+      erase(it);
+    }
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Remove all files from the cache.
+  ///
+  /// @endverbatim
+  void clear()
+  {
+    auto lock = std::scoped_lock(mutex_);
+    entries_.clear();
+    lru_.clear();
+    total_size_ = 0;
+  }
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Create the ``response`` for the file.
+  ///
+  /// DESCRIPTION
+  ///   Create the ``response`` for the file, loading it into the cache on a
+  ///   miss. A hit is served from the cached content without copying it.
+  ///   ``Range`` / ``If-None-Match`` / ``If-Modified-Since`` headers from
+  ///   the ``request`` are handled the same way as ``static_file`` does, except
+  ///   that a request for several ranges is answered with the whole file.
+  ///
+  /// @endverbatim
+  auto async_open(const executor_type& ex,
+                  const std::string& path,
+                  const request& req)
+      -> awaitable<expected<response, std::error_code>>
+  {
+    auto e = lookup(path);
+    if (!e) {
+      auto loaded = co_await async_load(ex, path);
+      if (!loaded) {
+        co_return unexpected { loaded.error() };
+      }
+      if (!*loaded) {
+        // too large to be cached
+        if (open_files_) {
+          co_return open_files_->open(ex, path, req);
+        }
+        auto file = static_file::open(ex, path, req);
+        if (!file) {
+          co_return unexpected { file.error() };
+        }
+        co_return to_response(std::move(*file));
+      }
+      e = std::move(*loaded);
+    }
+
+    co_return make_response(*e, req);
+  }
+
+private:
+  auto lookup(const std::string& path) -> std::shared_ptr<const entry>
+  {
+    const auto now = std::chrono::steady_clock::now();
+    auto e = std::shared_ptr<const entry>();
+    {
+      auto lock = std::scoped_lock(mutex_);
+      auto it = entries_.find(path);
+      if (it == entries_.end()) {
+        return nullptr;
+      }
+
+      lru_.splice(lru_.begin(), lru_, it->second.lru);
+      if (now - it->second.checked_at < check_interval_) {
+        return it->second.value;
+      }
+      e = it->second.value;
+    }
+
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    const auto lwt = ec ? detail::file_time_point()
+                        : std::filesystem::last_write_time(path, ec);
+
+    auto lock = std::scoped_lock(mutex_);
+    auto it = entries_.find(path);
+    const auto current = it != entries_.end() && it->second.value == e;
+    if (ec || size != e->meta.size || lwt != e->meta.last_write_time) {
+      if (current) {
+        erase(it);
+      }
+      return nullptr;
+    }
+    if (current) {
+      it->second.checked_at = now;
+    }
+
+    return e;
+  }
+
+  // Reads the file into a new entry. Returns `nullptr` if the file is too
+  // large to be cached.
+  auto async_load(const executor_type& ex, const std::string& path)
+      -> awaitable<expected<std::shared_ptr<const entry>, std::error_code>>
+  {
+    // look at the size first, large files are not to be opened twice
+    std::error_code size_ec;
+    if (auto size = std::filesystem::file_size(path, size_ec);
+        !size_ec && (size > max_file_size_ || size > max_size_)) {
+      co_return nullptr;
+    }
+
+    auto file = detail::open_file<stream_file>(ex, path);
+    if (!file) {
+      co_return unexpected { file.error() };
+    }
+
+    const auto size = file->size();
+    if (size > max_file_size_ || size > max_size_) {
+      co_return nullptr;
+    }
+
+    auto lwt = detail::get_last_modified_time(path);
+    if (!lwt) {
+      co_return unexpected { lwt.error() };
+    }
+
+    auto data = std::make_shared<bytes>(size);
+    if (auto result
+        = co_await net::async_read(*file, net::buffer(*data), use_awaitable);
+        !result) {
+      co_return unexpected { result.error() };
+    }
+
+    auto e = std::make_shared<const entry>(
+        entry { detail::static_file_metadata::make(path, size, *lwt),
+                std::move(data) });
+
+    auto lock = std::scoped_lock(mutex_);
+    if (auto it = entries_.find(path); it != entries_.end()) {
+      erase(it);
+    }
+    while (!lru_.empty() && total_size_ + size > max_size_) {
+      erase(entries_.find(lru_.back()));
+    }
+    lru_.push_front(path);
+    entries_.emplace(
+        path, node { e, std::chrono::steady_clock::now(), lru_.begin() });
+    total_size_ += size;
+
+    co_return e;
+  }
+
+  void erase(std::unordered_map<std::string, node>::iterator it)
+  {
+    total_size_ -= it->second.value->data->size();
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+  }
+
+  static auto make_response(const entry& e, const request& req) -> response
+  {
+    return detail::make_static_file_response(
+        e.meta,
+        req,
+        [&](response_builder&& builder,
+            std::uint64_t offset,
+            std::uint64_t length) {
+          return builder.set_body(
+              async_readable_shared_buffer_stream(e.data, offset, length),
+              length);
+        });
+  }
+
+  std::uint64_t max_size_;
+  std::uint64_t max_file_size_;
+  std::chrono::steady_clock::duration check_interval_;
+  std::shared_ptr<open_file_cache> open_files_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, node> entries_;
+  std::list<std::string> lru_;
+  std::uint64_t total_size_ = 0;
+};
+
+#endif
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
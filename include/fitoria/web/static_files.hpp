@@ -0,0 +1,280 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#ifndef FITORIA_WEB_STATIC_FILES_HPP
+#define FITORIA_WEB_STATIC_FILES_HPP
+
+#include <fitoria/core/config.hpp>
+
+#include <fitoria/core/expected.hpp>
+#include <fitoria/core/net.hpp>
+
+#include <fitoria/web/detail/directory_resolver.hpp>
+#include <fitoria/web/request.hpp>
+#include <fitoria/web/response.hpp>
+#include <fitoria/web/static_file.hpp>
+#include <fitoria/web/to_response.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+
+FITORIA_NAMESPACE_BEGIN
+
+namespace web {
+
+#if defined(BOOST_ASIO_HAS_FILE)
+
+/// @verbatim embed:rst:leading-slashes
+///
+/// A handler serving the files of a directory.
+///
+/// DESCRIPTION
+///   A handler serving the files of a directory, to be mounted on a route
+///   whose last path parameter is a wildcard, e.g.
+///   ``scope<"/assets">().serve(route::get<"/#path">(files))``. The wildcard
+///   is resolved relative to the root directory, which is opened once when
+///   the handler is built. On Linux files are opened with
+///   ``openat2(RESOLVE_BENEATH)`` relative to the descriptor of the root, so
+///   that neither ``..`` nor a symbolic link can escape it; elsewhere paths
+///   with ``..`` components are rejected. A path referring to a directory is
+///   served with its ``index_file``. Paths which are not found are remembered
+///   for ``negative_cache_ttl`` and answered with ``404 Not Found`` without
+///   touching the file system. Files are served the same way as
+///   ``static_file`` does.
+///
+/// @endverbatim
+class static_files {
+  struct impl {
+    impl(detail::directory_resolver root,
+         std::string index_file,
+         std::chrono::steady_clock::duration negative_cache_ttl,
+         std::size_t negative_cache_size)
+        : root(std::move(root))
+        , index_file(std::move(index_file))
+        , negative_cache_ttl(negative_cache_ttl)
+        , negative_cache_size(negative_cache_size)
+    {
+    }
+
+    detail::directory_resolver root;
+    std::string index_file;
+    std::chrono::steady_clock::duration negative_cache_ttl;
+    std::size_t negative_cache_size;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+        not_found;
+  };
+
+public:
+  class builder {
+    friend class static_files;
+
+    std::string root_;
+    std::string index_file_ = "index.html";
+    std::chrono::steady_clock::duration negative_cache_ttl_
+        = std::chrono::seconds(1);
+    std::size_t negative_cache_size_ = 4096;
+
+  public:
+    explicit builder(std::string root)
+        : root_(std::move(root))
+    {
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Open the root directory and build the handler.
+    ///
+    /// @endverbatim
+    auto build() const -> expected<static_files, std::error_code>
+    {
+      auto root = detail::directory_resolver::open(root_);
+      if (!root) {
+        return unexpected { root.error() };
+      }
+
+      return static_files(*this, std::move(*root));
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the file served for a path referring to a directory. Pass an empty
+    /// string to answer such paths with ``404 Not Found``. Default is
+    /// ``index.html``.
+    ///
+    /// @endverbatim
+    builder& set_index_file(std::string index_file)
+    {
+      index_file_ = std::move(index_file);
+      return *this;
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set how long a path which is not found is remembered. Pass zero to
+    /// disable the negative cache. Default is 1 second.
+    ///
+    /// @endverbatim
+    builder&
+    set_negative_cache_ttl(std::chrono::steady_clock::duration negative_ttl)
+    {
+      negative_cache_ttl_ = negative_ttl;
+      return *this;
+    }
+
+    /// @verbatim embed:rst:leading-slashes
+    ///
+    /// Set the maximum number of remembered paths which are not found.
+    /// Default is 4096.
+    ///
+    /// @endverbatim
+    builder& set_negative_cache_size(std::size_t negative_cache_size)
+    {
+      negative_cache_size_ = std::max<std::size_t>(negative_cache_size, 1);
+      return *this;
+    }
+  };
+
+  /// @verbatim embed:rst:leading-slashes
+  ///
+  /// Get the number of remembered paths which are not found.
+  ///
+  /// @endverbatim
+  auto negative_cache_size() const -> std::size_t
+  {
+    auto lock = std::scoped_lock(impl_->mutex);
+    return impl_->not_found.size();
+  }
+
+  auto operator()(const request& req) const -> awaitable<response>
+  {
+    auto path = std::string();
+    if (!req.path().empty()) {
+      path = *req.path().get(req.path().size() - 1);
+    }
+
+    if (is_known_not_found(path)) {
+      co_return response::not_found().build();
+    }
+
+    auto ex = co_await net::this_coro::executor;
+    auto file = open(ex, path, req);
+    if (!file && file.error() == std::errc::is_a_directory
+        && !impl_->index_file.empty()) {
+      auto index = path;
+      if (!index.empty() && !index.ends_with('/')) {
+        index += '/';
+      }
+      file = open(ex, index + impl_->index_file, req);
+    }
+
+    if (!file) {
+      if (is_not_found(file.error())) {
+        remember_not_found(std::move(path));
+      }
+      co_return response::not_found().build();
+    }
+
+    co_return to_response(std::move(*file));
+  }
+
+private:
+  static_files(const builder& builder, detail::directory_resolver root)
+      : impl_(std::make_shared<impl>(std::move(root),
+                                     builder.index_file_,
+                                     builder.negative_cache_ttl_,
+                                     builder.negative_cache_size_))
+  {
+  }
+
+  auto open(const executor_type& ex,
+            const std::string& path,
+            const request& req) const -> expected<static_file, std::error_code>
+  {
+    auto& root = impl_->root;
+    auto file = static_file::open_preferred(
+        path, req.headers(), [&](const std::string& p) {
+          return root.open_file<stream_file>(ex, p);
+        });
+    if (!file) {
+      return unexpected { file.error() };
+    }
+
+    auto lmd = root.get_last_modified_time(file->file, file->path);
+    if (!lmd) {
+      return unexpected { lmd.error() };
+    }
+
+    return static_file::make(std::move(*file), path, *lmd, req);
+  }
+
+  static auto is_not_found(const std::error_code& ec) -> bool
+  {
+    // `EXDEV` and `ELOOP` are reported by `openat2(RESOLVE_BENEATH)` for paths
+    // escaping the root
+    return ec == std::errc::no_such_file_or_directory
+        || ec == std::errc::not_a_directory || ec == std::errc::is_a_directory
+        || ec == std::errc::cross_device_link
+        || ec == std::errc::too_many_symbolic_link_levels
+        || ec == std::errc::filename_too_long
+        || ec == std::errc::invalid_argument;
+  }
+
+  auto is_known_not_found(const std::string& path) const -> bool
+  {
+    if (impl_->negative_cache_ttl <= std::chrono::steady_clock::duration()) {
+      return false;
+    }
+
+    auto lock = std::scoped_lock(impl_->mutex);
+    auto it = impl_->not_found.find(path);
+    if (it == impl_->not_found.end()) {
+      return false;
+    }
+    if (std::chrono::steady_clock::now() < it->second) {
+      return true;
+    }
+
+    impl_->not_found.erase(it);
+    return false;
+  }
+
+  void remember_not_found(std::string path) const
+  {
+    if (impl_->negative_cache_ttl <= std::chrono::steady_clock::duration()) {
+      return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    auto lock = std::scoped_lock(impl_->mutex);
+    if (impl_->not_found.size() >= impl_->negative_cache_size) {
+      std::erase_if(impl_->not_found,
+                    [&](auto& entry) { return entry.second <= now; });
+      if (impl_->not_found.size() >= impl_->negative_cache_size) {
+        impl_->not_found.clear();
+      }
+    }
+    impl_->not_found.insert_or_assign(std::move(path),
+                                      now + impl_->negative_cache_ttl);
+  }
+
+  std::shared_ptr<impl> impl_;
+};
+
+#endif
+
+}
+
+FITORIA_NAMESPACE_END
+
+#endif
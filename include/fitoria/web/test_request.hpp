@@ -20,6 +20,7 @@
 #include <fitoria/web/any_async_readable_stream.hpp>
 #include <fitoria/web/any_body.hpp>
 #include <fitoria/web/async_readable_vector_stream.hpp>
+#include <fitoria/web/detail/json_codec.hpp>
 #include <fitoria/web/query_map.hpp>
 
 #include <span>
@@ -210,6 +211,14 @@ class test_request_builder {
   {
   }
 
+  auto set_json_body(bytes buffer) -> test_request
+  {
+    set_header(http::field::content_type, mime::application_json());
+    body_ = any_body(any_body::sized { buffer.size() },
+                     async_readable_vector_stream(std::move(buffer)));
+    return build();
+  }
+
 public:
   explicit test_request_builder(http::verb method)
       : method_(method)
@@ -445,9 +454,9 @@ public:
   /// @endverbatim
   auto set_json(const boost::json::value& jv) -> test_request
   {
-    auto str = boost::json::serialize(jv);
-    set_header(http::field::content_type, mime::application_json());
-    return set_body(std::as_bytes(std::span(str.begin(), str.end())));
+    auto buffer = bytes();
+    detail::json_encode(jv, buffer);
+    return set_json_body(std::move(buffer));
   }
 
   /// @verbatim embed:rst:leading-slashes
@@ -463,10 +472,17 @@ public:
   ///
   /// @endverbatim
   template <typename T>
-    requires(boost::json::has_value_from<T>::value)
+    requires(boost::json::has_value_from<T>::value
+             || detail::json_direct_encodable<T>)
   auto set_json(const T& obj) -> test_request
   {
-    return set_json(boost::json::value_from(obj));
+    if constexpr (boost::json::has_value_from<T>::value) {
+      return set_json(boost::json::value_from(obj));
+    } else {
+      auto buffer = bytes();
+      detail::json_encode(obj, buffer);
+      return set_json_body(std::move(buffer));
+    }
   }
 
   /// @verbatim embed:rst:leading-slashes
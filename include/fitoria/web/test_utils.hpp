@@ -33,10 +33,11 @@ auto handle_expect_100_continue(Stream& stream)
 {
   using boost::beast::error;
   using boost::beast::http::response;
-  using boost::beast::http::vector_body;
+  using bytes_body = boost::beast::http::vector_body<bytes::value_type,
+                                                     bytes::allocator_type>;
 
   flat_buffer buffer;
-  response<vector_body<std::byte>> res;
+  response<bytes_body> res;
   auto bytes_read = co_await async_read(stream, buffer, res, use_awaitable);
   if (!bytes_read && bytes_read.error() != error::timeout) {
     co_return unexpected { bytes_read.error() };
@@ -58,9 +59,10 @@ auto do_sized_request(Stream& stream, std::string path, test_request& tr)
 {
   using boost::beast::http::request;
   using boost::beast::http::request_serializer;
-  using boost::beast::http::vector_body;
+  using bytes_body = boost::beast::http::vector_body<bytes::value_type,
+                                                     bytes::allocator_type>;
 
-  auto req = request<vector_body<std::byte>>(
+  auto req = request<bytes_body>(
       tr.method(), encoded_target(path, tr.query().to_string()), 11);
   tr.headers().to_impl(req);
   if (auto data = co_await async_read_until_eof<bytes>(tr.body().stream());
@@ -71,7 +73,7 @@ auto do_sized_request(Stream& stream, std::string path, test_request& tr)
   }
   req.prepare_payload();
 
-  auto ser = request_serializer<vector_body<std::byte>>(req);
+  auto ser = request_serializer<bytes_body>(req);
   if (auto bytes_written
       = co_await async_write_header(stream, ser, use_awaitable);
       !bytes_written) {
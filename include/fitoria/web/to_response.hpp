@@ -11,8 +11,10 @@
 
 #include <fitoria/core/config.hpp>
 
+#include <fitoria/core/bytes.hpp>
 #include <fitoria/core/tag_invoke.hpp>
 
+#include <fitoria/web/async_readable_vector_stream.hpp>
 #include <fitoria/web/response.hpp>
 
 FITORIA_NAMESPACE_BEGIN
@@ -45,13 +47,20 @@ namespace to_response_ns {
           .set_body(str);
     }
 
-    template <typename T>
-    auto operator()(std::vector<T> vec) const -> response
+    template <typename T, typename Allocator>
+    auto operator()(std::vector<T, Allocator> vec) const -> response
     {
-      return response::ok()
-          .set_header(http::field::content_type,
-                      mime::application_octet_stream())
-          .set_body(std::as_bytes(std::span(vec.begin(), vec.end())));
+      auto builder = response::ok().set_header(
+          http::field::content_type, mime::application_octet_stream());
+      if constexpr (std::same_as<std::vector<T, Allocator>, bytes>) {
+        // already the body's buffer type, move it in instead of copying
+        const auto size = vec.size();
+        return std::move(builder).set_body(
+            async_readable_vector_stream(std::move(vec)), size);
+      } else {
+        return std::move(builder).set_body(
+            std::as_bytes(std::span(vec.begin(), vec.end())));
+      }
     }
 
     template <typename... Ts>
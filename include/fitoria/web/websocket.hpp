@@ -16,6 +16,7 @@
 
 #include <fitoria/web/error.hpp>
 #include <fitoria/web/from_request.hpp>
+#include <fitoria/web/memory_budget.hpp>
 #include <fitoria/web/response.hpp>
 
 #include <functional>
@@ -176,8 +177,19 @@ public:
           stream_);
     }
 
+    void set_memory_account(std::shared_ptr<memory_budget::account> account)
+    {
+      account_ = std::move(account);
+    }
+
     auto async_read() -> awaitable<expected<message_type, std::error_code>>
     {
+      // the previous message is released by now, pause while over budget
+      if (account_) {
+        account_->credit(std::exchange(message_size_, 0));
+        co_await account_->async_wait_available();
+      }
+
       auto buffer = dynamic_buffer<bytes>();
       auto result = co_await std::visit(
           [&](auto& stream)
@@ -187,6 +199,10 @@ public:
           stream_);
 
       if (result) {
+        if (account_) {
+          message_size_ = buffer.cdata().size();
+          account_->charge(message_size_);
+        }
         if (is_text()) {
           co_return message_type(text_t { std::string(
               (char*)buffer.cdata().data(),
@@ -272,6 +288,8 @@ public:
     stream_type stream_;
     callback_type callback_;
     optional<response> response_;
+    std::shared_ptr<memory_budget::account> account_;
+    std::uint64_t message_size_ = 0;
     boost::beast::websocket::stream_base::timeout timeout_
         = boost::beast::websocket::stream_base::timeout::suggested(
             boost::beast::role_type::server);
@@ -435,6 +453,11 @@ public:
   }
 
 private:
+  void set_memory_account(std::shared_ptr<memory_budget::account> account)
+  {
+    impl_->set_memory_account(std::move(account));
+  }
+
   template <typename Body>
   auto run(boost::beast::http::request<Body>& req)
       -> awaitable<expected<void, std::error_code>>
@@ -7,8 +7,10 @@
 
 #include <fitoria/test/test.hpp>
 
+#include <fitoria/core/bytes.hpp>
 #include <fitoria/core/dynamic_buffer.hpp>
 
+#include <cstring>
 #include <numeric>
 #include <string>
 #include <vector>
@@ -22,6 +24,7 @@ TEST_CASE("is_dynamic_buffer")
   static_assert(net::is_dynamic_buffer<dynamic_buffer<std::string>>::value);
   static_assert(
       net::is_dynamic_buffer<dynamic_buffer<std::vector<std::uint8_t>>>::value);
+  static_assert(net::is_dynamic_buffer<dynamic_buffer<bytes>>::value);
 }
 
 TEST_CASE("basic")
@@ -82,6 +85,30 @@ TEST_CASE("with limit: required size too large")
   CHECK_THROWS_AS(buffer.prepare(129), std::length_error);
 }
 
+TEST_CASE("default-init growth")
+{
+  auto buffer = dynamic_buffer<bytes>();
+  {
+    auto w = buffer.prepare(65536);
+    CHECK_EQ(w.size(), 65536);
+    std::memset(w.data(), 0x61, 3);
+    buffer.commit(3);
+  }
+  CHECK_GE(buffer.capacity(), 65536);
+  {
+    auto w = buffer.prepare(65536);
+    CHECK_EQ(w.size(), 65536);
+    std::memset(w.data(), 0x62, 2);
+    buffer.commit(2);
+  }
+  CHECK_EQ(buffer.release(),
+           bytes { std::byte(0x61),
+                   std::byte(0x61),
+                   std::byte(0x61),
+                   std::byte(0x62),
+                   std::byte(0x62) });
+}
+
 TEST_CASE("with existing container")
 {
   auto buffer = dynamic_buffer<std::string>(std::string("hello world!"));
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <fitoria/test/test.hpp>
+
+#include <fitoria/http/header/accept_encoding.hpp>
+
+using namespace fitoria;
+
+using http::header::accept_encoding;
+
+TEST_SUITE_BEGIN("[fitoria.http.header.accept_encoding]");
+
+TEST_CASE("parse")
+{
+  using coding_t = accept_encoding::coding_t;
+
+  {
+    auto ae = accept_encoding::parse("");
+    CHECK_EQ(ae->codings(), std::vector<coding_t> {});
+  }
+  {
+    auto ae = accept_encoding::parse("gzip, deflate, br");
+    CHECK_EQ(ae->codings(),
+             std::vector<coding_t> {
+                 { "gzip", 1000 },
+                 { "deflate", 1000 },
+                 { "br", 1000 },
+             });
+  }
+  {
+    auto ae = accept_encoding::parse("br;q=1.0, gzip;q=0.8, *;q=0.1, ");
+    CHECK_EQ(ae->codings(),
+             std::vector<coding_t> {
+                 { "br", 1000 },
+                 { "gzip", 800 },
+                 { "*", 100 },
+             });
+  }
+  {
+    auto ae = accept_encoding::parse("gzip ; Q=0.125, identity;q=0");
+    CHECK_EQ(ae->codings(),
+             std::vector<coding_t> {
+                 { "gzip", 125 },
+                 { "identity", 0 },
+             });
+  }
+  {
+    CHECK(!accept_encoding::parse(";q=1"));
+    CHECK(!accept_encoding::parse("gzip;q"));
+    CHECK(!accept_encoding::parse("gzip;q=2"));
+    CHECK(!accept_encoding::parse("gzip;q=1.5"));
+    CHECK(!accept_encoding::parse("gzip;q=0.1234"));
+    CHECK(!accept_encoding::parse("gzip;q=0.x"));
+  }
+}
+
+TEST_CASE("quality")
+{
+  {
+    auto ae = accept_encoding::parse("");
+    CHECK_EQ(ae->quality("identity"), 1000);
+    CHECK_EQ(ae->quality("gzip"), 0);
+  }
+  {
+    auto ae = accept_encoding::parse("GZIP;q=0.5, br");
+    CHECK_EQ(ae->quality("gzip"), 500);
+    CHECK_EQ(ae->quality("br"), 1000);
+    CHECK_EQ(ae->quality("zstd"), 0);
+    CHECK_EQ(ae->quality("identity"), 1000);
+  }
+  {
+    auto ae = accept_encoding::parse("br;q=0, *;q=0.3");
+    CHECK_EQ(ae->quality("br"), 0);
+    CHECK_EQ(ae->quality("gzip"), 300);
+    CHECK_EQ(ae->quality("identity"), 300);
+  }
+}
+
+TEST_SUITE_END();
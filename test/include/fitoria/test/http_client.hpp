@@ -622,9 +622,10 @@ private:
   {
     using boost::beast::http::request;
     using boost::beast::http::request_serializer;
-    using boost::beast::http::vector_body;
+    using bytes_body = boost::beast::http::vector_body<bytes::value_type,
+                                                       bytes::allocator_type>;
 
-    auto req = request<vector_body<std::byte>>(
+    auto req = request<bytes_body>(
         method_, encoded_target(resource_->path, query_.to_string()), 11);
     headers_.to_impl(req);
     req.set(http::field::host, resource_->host);
@@ -636,7 +637,7 @@ private:
     }
     req.prepare_payload();
 
-    auto ser = request_serializer<vector_body<std::byte>>(req);
+    auto ser = request_serializer<bytes_body>(req);
     if (auto bytes_written
         = co_await async_write_header(stream, ser, use_awaitable);
         !bytes_written) {
@@ -702,10 +703,11 @@ private:
   {
     using boost::beast::error;
     using boost::beast::http::response;
-    using boost::beast::http::vector_body;
+    using bytes_body = boost::beast::http::vector_body<bytes::value_type,
+                                                       bytes::allocator_type>;
 
     flat_buffer buffer;
-    response<vector_body<std::byte>> res;
+    response<bytes_body> res;
     auto bytes_read = co_await async_read(stream, buffer, res, use_awaitable);
     if (!bytes_read && bytes_read.error() != error::timeout) {
       co_return unexpected { bytes_read.error() };
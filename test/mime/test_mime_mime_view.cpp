@@ -241,6 +241,14 @@ TEST_CASE("contants")
     CHECK_EQ(m.suffix(), nullopt);
     CHECK_EQ(m.params(), params_view {});
   }
+  {
+    auto m = multipart_byteranges();
+    CHECK_EQ(m.essence(), "multipart/byteranges");
+    CHECK_EQ(m.type(), "multipart");
+    CHECK_EQ(m.subtype(), "byteranges");
+    CHECK_EQ(m.suffix(), nullopt);
+    CHECK_EQ(m.params(), params_view {});
+  }
   {
     auto m = multipart_form_data();
     CHECK_EQ(m.essence(), "multipart/form-data");
@@ -0,0 +1,574 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <fitoria/test/test.hpp>
+
+#include <fitoria/test/async_readable_chunk_stream.hpp>
+#include <fitoria/test/http_server_utils.hpp>
+#include <fitoria/test/utility.hpp>
+
+#include <fitoria/web.hpp>
+
+#include <random>
+
+#if defined(FITORIA_HAS_BROTLI_SHARED_DICTIONARY)
+#include <brotli/decode.h>
+#endif
+
+using namespace fitoria;
+using namespace fitoria::web;
+using namespace fitoria::test;
+using fitoria::test::async_readable_chunk_stream;
+
+TEST_SUITE_BEGIN("[fitoria.web.middleware.compress]");
+
+namespace {
+
+const auto text = get_random_string(4096);
+
+auto get_incompressible_string(std::size_t size) -> std::string
+{
+  auto eng = std::mt19937(size);
+  auto s = std::string(size, '\0');
+  std::ranges::generate(s, [&]() { return static_cast<char>(eng()); });
+  return s;
+}
+
+#if defined(FITORIA_HAS_ZSTD)
+
+// Decodes a `dcz` body: the header, followed by a zstd frame compressed with
+// the raw content dictionary.
+auto decode_dcz(std::string_view body,
+                const middleware::compress_dictionary& dict)
+    -> optional<std::string>
+{
+  if (body.size() < 40) {
+    return nullopt;
+  }
+  const auto header = std::as_bytes(std::span(body)).first(40);
+  if (!std::ranges::equal(
+          header.first(8),
+          std::as_bytes(std::span("\x5e\x2a\x4d\x18\x20\x00\x00\x00", 8)))
+      || !std::ranges::equal(header.subspan(8), dict.hash())) {
+    return nullopt;
+  }
+
+  auto plain = std::string(1048576, '\0');
+  auto* dctx = ZSTD_createDCtx();
+  ZSTD_DCtx_loadDictionary_advanced(dctx,
+                                    dict.data().data(),
+                                    dict.data().size(),
+                                    ZSTD_dlm_byRef,
+                                    ZSTD_dct_rawContent);
+  const auto size = ZSTD_decompressDCtx(
+      dctx, plain.data(), plain.size(), body.data() + 40, body.size() - 40);
+  ZSTD_freeDCtx(dctx);
+  if (ZSTD_isError(size)) {
+    return nullopt;
+  }
+
+  plain.resize(size);
+  return plain;
+}
+
+#endif
+
+#if defined(FITORIA_HAS_BROTLI_SHARED_DICTIONARY)
+
+// Decodes a `dcb` body: the header, followed by a brotli stream compressed
+// with the raw dictionary.
+auto decode_dcb(std::string_view body,
+                const middleware::compress_dictionary& dict)
+    -> optional<std::string>
+{
+  if (body.size() < 36) {
+    return nullopt;
+  }
+  const auto header = std::as_bytes(std::span(body)).first(36);
+  if (!std::ranges::equal(header.first(4),
+                          std::as_bytes(std::span("\xff\x44\x43\x42", 4)))
+      || !std::ranges::equal(header.subspan(4), dict.hash())) {
+    return nullopt;
+  }
+
+  auto plain = std::string(1048576, '\0');
+  auto* state = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+  BrotliDecoderAttachDictionary(
+      state,
+      BROTLI_SHARED_DICTIONARY_RAW,
+      dict.data().size(),
+      reinterpret_cast<const std::uint8_t*>(dict.data().data()));
+  auto avail_in = body.size() - 36;
+  auto next_in = reinterpret_cast<const std::uint8_t*>(body.data() + 36);
+  auto avail_out = plain.size();
+  auto next_out = reinterpret_cast<std::uint8_t*>(plain.data());
+  const auto result = BrotliDecoderDecompressStream(
+      state, &avail_in, &next_in, &avail_out, &next_out, nullptr);
+  BrotliDecoderDestroyInstance(state);
+  if (result != BROTLI_DECODER_RESULT_SUCCESS) {
+    return nullopt;
+  }
+
+  plain.resize(plain.size() - avail_out);
+  return plain;
+}
+
+#endif
+
+auto make_server(net::io_context& ioc)
+{
+  return http_server::builder(ioc)
+      .serve(scope<>()
+                 .use(middleware::compress().set_threshold(1024))
+                 .serve(route::get<"/text">(
+                     [](const request&) -> awaitable<response> {
+                       co_return response::ok()
+                           .set_header(http::field::content_type,
+                                       mime::text_plain())
+                           .set_header(http::field::etag, R"("tag")")
+                           .set_header(http::field::vary, "Origin")
+                           .set_body(text);
+                     }))
+                 .serve(route::get<"/stream">(
+                     [](const request&) -> awaitable<response> {
+                       co_return response::ok()
+                           .set_header(http::field::content_type,
+                                       mime::text_plain())
+                           .set_body(async_readable_chunk_stream<1000>(
+                                         std::span(text.begin(), text.size())),
+                                     text.size());
+                     }))
+                 .serve(route::get<"/incompressible">(
+                     [](const request&) -> awaitable<response> {
+                       co_return response::ok()
+                           .set_header(http::field::content_type,
+                                       mime::text_plain())
+                           .set_body(get_incompressible_string(4096));
+                     }))
+                 .serve(route::get<"/small">(
+                     [](const request&) -> awaitable<response> {
+                       co_return response::ok()
+                           .set_header(http::field::content_type,
+                                       mime::text_plain())
+                           .set_body(std::string_view(text).substr(0, 1023));
+                     }))
+                 .serve(route::get<"/image">(
+                     [](const request&) -> awaitable<response> {
+                       co_return response::ok()
+                           .set_header(http::field::content_type,
+                                       mime::image_png())
+                           .set_body(text);
+                     }))
+                 .serve(route::get<"/no-transform">(
+                     [](const request&) -> awaitable<response> {
+                       co_return response::ok()
+                           .set_header(http::field::content_type,
+                                       mime::text_plain())
+                           .set_header(http::field::cache_control,
+                                       "public, no-transform")
+                           .set_body(text);
+                     })))
+      .build();
+}
+
+}
+
+TEST_CASE("negotiate content coding")
+{
+  auto ioc = net::io_context();
+  auto server = make_server(ioc);
+
+#if defined(FITORIA_HAS_ZLIB)
+  server.serve_request(
+      "/text",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "br;q=0.5, gzip")
+          .build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::content_encoding), "gzip");
+        CHECK_EQ(res.headers().get(http::field::vary),
+                 "Origin, Accept-Encoding");
+        CHECK_EQ(res.headers().get(http::field::etag), R"(W/"tag")");
+        // the body in memory is compressed as a whole
+        auto compressed = co_await res.as_string();
+        REQUIRE(compressed);
+        CHECK_LT(compressed->size(), text.size());
+        CHECK_EQ(res.headers().get(http::field::content_length),
+                 std::to_string(compressed->size()));
+        CHECK_EQ(co_await async_read_until_eof<std::string>(
+                     middleware::detail::async_gzip_inflate_stream(
+                         async_readable_vector_stream(std::span(
+                             compressed->begin(), compressed->size())))),
+                 text);
+      });
+#endif
+#if defined(FITORIA_HAS_BROTLI)
+  server.serve_request(
+      "/text",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "gzip;q=0.8, br")
+          .build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::content_encoding), "br");
+        CHECK_EQ(co_await async_read_until_eof<std::string>(
+                     middleware::detail::async_brotli_inflate_stream(
+                         std::move(res.body()))),
+                 text);
+      });
+#endif
+#if defined(FITORIA_HAS_ZSTD)
+  server.serve_request(
+      "/text",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "gzip;q=0.8, zstd")
+          .build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::content_encoding), "zstd");
+        CHECK_EQ(co_await async_read_until_eof<std::string>(
+                     middleware::detail::async_zstd_inflate_stream(
+                         std::move(res.body()))),
+                 text);
+      });
+#endif
+  server.serve_request(
+      "/text",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "identity, *;q=0")
+          .build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK(!res.headers().get(http::field::content_encoding));
+        CHECK_EQ(res.headers().get(http::field::vary),
+                 "Origin, Accept-Encoding");
+        CHECK_EQ(res.headers().get(http::field::etag), R"("tag")");
+        CHECK_EQ(co_await res.as_string(), text);
+      });
+  server.serve_request(
+      "/text",
+      test_request::get().build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK(!res.headers().get(http::field::content_encoding));
+        CHECK_EQ(co_await res.as_string(), text);
+      });
+  ioc.run();
+}
+
+#if defined(FITORIA_HAS_ZLIB)
+
+TEST_CASE("stream bodies are compressed as they are read")
+{
+  auto ioc = net::io_context();
+  auto server = make_server(ioc);
+
+  server.serve_request(
+      "/stream",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "gzip")
+          .build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::content_encoding), "gzip");
+        CHECK(!res.headers().get(http::field::content_length));
+        CHECK_EQ(co_await async_read_until_eof<std::string>(
+                     middleware::detail::async_gzip_inflate_stream(
+                         std::move(res.body()))),
+                 text);
+      });
+  ioc.run();
+}
+
+TEST_CASE("bodies which do not shrink are sent as is")
+{
+  auto ioc = net::io_context();
+  auto server = make_server(ioc);
+
+  server.serve_request(
+      "/incompressible",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "gzip")
+          .build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK(!res.headers().get(http::field::content_encoding));
+        CHECK_EQ(res.headers().get(http::field::vary), "Accept-Encoding");
+        CHECK_EQ(res.headers().get(http::field::content_length), "4096");
+        CHECK_EQ(co_await res.as_string(), get_incompressible_string(4096));
+      });
+  ioc.run();
+}
+
+#endif
+
+TEST_CASE("skip responses which are not worth compressing")
+{
+  auto ioc = net::io_context();
+  auto server = make_server(ioc);
+
+  for (auto path : { "/small", "/image", "/no-transform" }) {
+    server.serve_request(
+        path,
+        test_request::get()
+            .set_header(http::field::accept_encoding, "gzip, br")
+            .build(),
+        [](test_response res) -> awaitable<void> {
+          CHECK_EQ(res.status(), http::status::ok);
+          CHECK(!res.headers().get(http::field::content_encoding));
+          CHECK(!res.headers().get(http::field::vary));
+          auto body = co_await res.as_string();
+          CHECK(body);
+          CHECK(text.starts_with(*body));
+        });
+  }
+  ioc.run();
+}
+
+#if defined(FITORIA_HAS_ZLIB)
+
+TEST_CASE("cache compressed bodies by etag")
+{
+  auto handler = [](const request&) -> awaitable<response> {
+    co_return response::ok()
+        .set_header(http::field::content_type, mime::text_plain())
+        .set_header(http::field::etag, R"("tag")")
+        .set_body(text);
+  };
+
+  auto cache = middleware::compress_cache::builder().build();
+  auto ioc = net::io_context();
+  auto server = http_server::builder(ioc)
+                    .serve(scope<>()
+                               .use(middleware::compress().set_cache(cache))
+                               .serve(route::get<"/">(handler))
+                               .serve(route::post<"/">(handler)))
+                    .build();
+
+  auto compressed = std::make_shared<std::string>();
+  for (int i = 0; i < 2; ++i) {
+    server.serve_request(
+        "/",
+        test_request::get()
+            .set_header(http::field::accept_encoding, "gzip")
+            .build(),
+        [compressed](test_response res) -> awaitable<void> {
+          CHECK_EQ(res.status(), http::status::ok);
+          CHECK_EQ(res.headers().get(http::field::content_encoding), "gzip");
+          CHECK_EQ(res.headers().get(http::field::etag), R"(W/"tag")");
+          auto body = co_await res.as_string();
+          REQUIRE(body);
+          CHECK_EQ(res.headers().get(http::field::content_length),
+                   std::to_string(body->size()));
+          if (compressed->empty()) {
+            *compressed = *body;
+          } else {
+            CHECK_EQ(*body, *compressed);
+          }
+        });
+  }
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "gzip")
+          .set_header(http::field::if_none_match, R"(W/"tag")")
+          .build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::not_modified);
+        CHECK_EQ(res.headers().get(http::field::etag), R"(W/"tag")");
+        CHECK_EQ(res.headers().get(http::field::vary), "Accept-Encoding");
+        CHECK_EQ(co_await res.as_string(), "");
+      });
+  // only GET and HEAD are answered with 304
+  server.serve_request(
+      "/",
+      test_request::post()
+          .set_header(http::field::accept_encoding, "gzip")
+          .set_header(http::field::if_none_match, R"(W/"tag")")
+          .set_body(),
+      [compressed](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::content_encoding), "gzip");
+        CHECK_EQ(co_await res.as_string(), *compressed);
+      });
+  ioc.run();
+
+  CHECK_EQ(cache->size(), 1);
+  CHECK_EQ(cache->total_size(), compressed->size());
+}
+
+#endif
+
+#if defined(FITORIA_HAS_ZLIB) && defined(FITORIA_HAS_ZSTD)
+
+TEST_CASE("compress with a dictionary")
+{
+  auto data = std::as_bytes(std::span(text).first(2048));
+  auto dict = middleware::compress_dictionary::builder(
+                  bytes(data.begin(), data.end()))
+                  .set_url("/dictionary")
+                  .build();
+  REQUIRE(dict);
+
+  auto ioc = net::io_context();
+  auto server
+      = http_server::builder(ioc)
+            .serve(scope<>()
+                       .use(middleware::compress().set_dictionary(*dict))
+                       .serve(route::get<"/">(
+                           [](const request&) -> awaitable<response> {
+                             co_return response::ok()
+                                 .set_header(http::field::content_type,
+                                             mime::text_plain())
+                                 .set_body(text);
+                           })))
+            .build();
+
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "gzip, dcz")
+          .set_header("Available-Dictionary", dict->available_dictionary())
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::content_encoding), "dcz");
+        CHECK_EQ(res.headers().get(http::field::vary),
+                 "Accept-Encoding, Available-Dictionary");
+        CHECK(!res.headers().get(http::field::link));
+        auto body = co_await res.as_string();
+        REQUIRE(body);
+        CHECK_EQ(res.headers().get(http::field::content_length),
+                 std::to_string(body->size()));
+        CHECK_LT(body->size(), text.size());
+        CHECK_EQ(decode_dcz(*body, *dict), text);
+      });
+#if defined(FITORIA_HAS_BROTLI_SHARED_DICTIONARY)
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "gzip, dcb")
+          .set_header("Available-Dictionary", dict->available_dictionary())
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::content_encoding), "dcb");
+        auto body = co_await res.as_string();
+        REQUIRE(body);
+        CHECK_LT(body->size(), text.size());
+        CHECK_EQ(decode_dcb(*body, *dict), text);
+      });
+#endif
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "gzip, dcz")
+          .build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::content_encoding), "gzip");
+        CHECK_EQ(res.headers().get(http::field::vary),
+                 "Accept-Encoding, Available-Dictionary");
+        CHECK_EQ(res.headers().get(http::field::link),
+                 R"(</dictionary>; rel="compression-dictionary")");
+        co_return;
+      });
+  ioc.run();
+}
+
+TEST_CASE("cache bodies compressed with a dictionary")
+{
+  auto cache = middleware::compress_cache::builder().build();
+
+  // the same target and `ETag` compressed with different dictionaries
+  for (auto first : { std::size_t(0), std::size_t(2048) }) {
+    auto data = std::as_bytes(std::span(text).subspan(first, 2048));
+    auto dict = middleware::compress_dictionary::builder(
+                    bytes(data.begin(), data.end()))
+                    .build();
+    REQUIRE(dict);
+
+    auto ioc = net::io_context();
+    auto server
+        = http_server::builder(ioc)
+              .serve(scope<>()
+                         .use(middleware::compress()
+                                  .set_cache(cache)
+                                  .set_dictionary(*dict))
+                         .serve(route::get<"/">(
+                             [](const request&) -> awaitable<response> {
+                               co_return response::ok()
+                                   .set_header(http::field::content_type,
+                                               mime::text_plain())
+                                   .set_header(http::field::etag, R"("tag")")
+                                   .set_body(text);
+                             })))
+              .build();
+
+    for (int i = 0; i < 2; ++i) {
+      server.serve_request(
+          "/",
+          test_request::get()
+              .set_header(http::field::accept_encoding, "dcz")
+              .set_header("Available-Dictionary", dict->available_dictionary())
+              .build(),
+          [&](test_response res) -> awaitable<void> {
+            CHECK_EQ(res.status(), http::status::ok);
+            CHECK_EQ(res.headers().get(http::field::content_encoding), "dcz");
+            auto body = co_await res.as_string();
+            REQUIRE(body);
+            CHECK_EQ(decode_dcz(*body, *dict), text);
+          });
+    }
+    ioc.run();
+  }
+
+  CHECK_EQ(cache->size(), 2);
+}
+
+#endif
+
+TEST_CASE("compress on a separate executor")
+{
+  auto pool = net::thread_pool(1);
+  auto ioc = net::io_context();
+  auto server = http_server::builder(ioc)
+                    .serve(scope<>()
+                               .use(middleware::compress().set_executor(
+                                   pool.get_executor()))
+                               .serve(route::get<"/">(
+                                   [](const request&) -> awaitable<response> {
+                                     co_return response::ok()
+                                         .set_header(http::field::content_type,
+                                                     mime::text_plain())
+                                         .set_stream_body(
+                                             async_readable_chunk_stream<1000>(
+                                                 std::span(text.begin(),
+                                                           text.size())));
+                                   })))
+                    .build();
+
+#if defined(FITORIA_HAS_ZLIB)
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "gzip")
+          .build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::content_encoding), "gzip");
+        CHECK_EQ(co_await async_read_until_eof<std::string>(
+                     middleware::detail::async_gzip_inflate_stream(
+                         std::move(res.body()))),
+                 text);
+      });
+#endif
+  ioc.run();
+  pool.join();
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <fitoria/test/test.hpp>
+
+#include <fitoria/web/middleware/compress_cache.hpp>
+
+using namespace fitoria;
+using namespace fitoria::web;
+
+TEST_SUITE_BEGIN("[fitoria.web.middleware.compress_cache]");
+
+namespace {
+
+auto make_bytes(std::size_t size) -> std::shared_ptr<const bytes>
+{
+  return std::make_shared<const bytes>(size, std::byte('a'));
+}
+
+}
+
+TEST_CASE("find")
+{
+  auto cache = middleware::compress_cache::builder().build();
+
+  auto data = make_bytes(10);
+  cache->insert("/a", "tag", "gzip", data);
+  CHECK_EQ(cache->find("/a", "tag", "gzip"), data);
+  CHECK(!cache->find("/a", "tag", "br"));
+  CHECK(!cache->find("/a", "other", "gzip"));
+  CHECK(!cache->find("/b", "tag", "gzip"));
+  CHECK_EQ(cache->size(), 1);
+  CHECK_EQ(cache->total_size(), 10);
+
+  auto replaced = make_bytes(20);
+  cache->insert("/a", "tag", "gzip", replaced);
+  CHECK_EQ(cache->find("/a", "tag", "gzip"), replaced);
+  CHECK_EQ(cache->size(), 1);
+  CHECK_EQ(cache->total_size(), 20);
+
+  cache->clear();
+  CHECK(!cache->find("/a", "tag", "gzip"));
+  CHECK_EQ(cache->size(), 0);
+  CHECK_EQ(cache->total_size(), 0);
+}
+
+TEST_CASE("least recently used bodies are evicted")
+{
+  auto cache = middleware::compress_cache::builder()
+                   .set_max_size(30)
+                   .set_max_entry_size(15)
+                   .build();
+
+  cache->insert("/a", "tag", "gzip", make_bytes(10));
+  cache->insert("/b", "tag", "gzip", make_bytes(10));
+  cache->insert("/c", "tag", "gzip", make_bytes(10));
+  CHECK(cache->find("/a", "tag", "gzip"));
+
+  cache->insert("/d", "tag", "gzip", make_bytes(10));
+  CHECK(cache->find("/a", "tag", "gzip"));
+  CHECK(!cache->find("/b", "tag", "gzip"));
+  CHECK(cache->find("/c", "tag", "gzip"));
+  CHECK(cache->find("/d", "tag", "gzip"));
+  CHECK_EQ(cache->total_size(), 30);
+
+  cache->insert("/e", "tag", "gzip", make_bytes(16));
+  CHECK(!cache->find("/e", "tag", "gzip"));
+  CHECK_EQ(cache->size(), 3);
+}
+
+TEST_SUITE_END();
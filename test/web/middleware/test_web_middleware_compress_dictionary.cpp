@@ -0,0 +1,187 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <fitoria/test/test.hpp>
+
+#include <fitoria/test/http_server_utils.hpp>
+
+#include <fitoria/web.hpp>
+
+#if defined(FITORIA_HAS_BROTLI_SHARED_DICTIONARY)
+#include <brotli/decode.h>
+#endif
+
+using namespace fitoria;
+using namespace fitoria::web;
+using namespace fitoria::test;
+
+TEST_SUITE_BEGIN("[fitoria.web.middleware.compress_dictionary]");
+
+namespace {
+
+const auto dictionary
+    = std::string(R"({"id":0,"name":"name","email":"user@example.com"})");
+
+const auto text = std::string(R"({"id":1,"name":"fitoria","email":")"
+                              R"(fitoria@example.com"})");
+
+auto to_bytes(std::string_view s) -> bytes
+{
+  auto b = std::as_bytes(std::span(s));
+  return bytes(b.begin(), b.end());
+}
+
+}
+
+TEST_CASE("build")
+{
+  CHECK(!middleware::compress_dictionary::builder(bytes()).build());
+
+  auto dict = middleware::compress_dictionary::builder(to_bytes("abc")).build();
+  REQUIRE(dict);
+  CHECK_EQ(dict->available_dictionary(),
+           ":ungWv48Bz+pBQUDeXa4iI7ADYaOWF3qctBD/YfIAFa0=:");
+  CHECK(std::ranges::equal(dict->data(), std::as_bytes(std::span("abc", 3))));
+}
+
+TEST_CASE("serve the dictionary")
+{
+  auto dict = middleware::compress_dictionary::builder(to_bytes(dictionary))
+                  .set_match("/api/*")
+                  .set_id("v1")
+                  .set_max_age(std::chrono::hours(1))
+                  .build();
+  REQUIRE(dict);
+
+  auto ioc = net::io_context();
+  auto server = http_server::builder(ioc)
+                    .serve(route::get<"/dictionary">(*dict))
+                    .build();
+  auto etag_str = std::string();
+  server.serve_request(
+      "/dictionary",
+      test_request::get().build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get("Use-As-Dictionary"),
+                 R"(match="/api/*", id="v1")");
+        CHECK_EQ(res.headers().get(http::field::cache_control),
+                 "public, max-age=3600");
+        CHECK_EQ(res.headers().get(http::field::content_length),
+                 std::to_string(dictionary.size()));
+        etag_str = res.headers().get(http::field::etag).value_or("");
+        CHECK_EQ(co_await res.as_string(), dictionary);
+      });
+  ioc.run();
+  REQUIRE(!etag_str.empty());
+
+  ioc.restart();
+  server.serve_request(
+      "/dictionary",
+      test_request::get()
+          .set_header(http::field::if_none_match, etag_str)
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::not_modified);
+        CHECK_EQ(res.headers().get(http::field::etag), etag_str);
+        CHECK_EQ(res.headers().get(http::field::cache_control),
+                 "public, max-age=3600");
+        co_return;
+      });
+  server.serve_request(
+      "/dictionary",
+      test_request::get()
+          .set_header(http::field::if_none_match, R"("other")")
+          .build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(co_await res.as_string(), dictionary);
+      });
+  ioc.run();
+}
+
+#if defined(FITORIA_HAS_ZSTD)
+
+TEST_CASE("dcz")
+{
+  auto dict = middleware::compress_dictionary::builder(to_bytes(dictionary))
+                  .build();
+  REQUIRE(dict);
+
+  auto compressed = dict->compress(std::as_bytes(std::span(text)), "dcz");
+  REQUIRE(compressed);
+  REQUIRE_GT(compressed->size(), 40);
+  CHECK(std::ranges::equal(
+      std::span(*compressed).first(8),
+      std::as_bytes(std::span("\x5e\x2a\x4d\x18\x20\x00\x00\x00", 8))));
+  CHECK(std::ranges::equal(std::span(*compressed).subspan(8, 32),
+                           dict->hash()));
+
+  auto plain = std::string(text.size(), '\0');
+  auto* dctx = ZSTD_createDCtx();
+  auto size = ZSTD_decompress_usingDict(dctx,
+                                        plain.data(),
+                                        plain.size(),
+                                        compressed->data() + 40,
+                                        compressed->size() - 40,
+                                        dictionary.data(),
+                                        dictionary.size());
+  ZSTD_freeDCtx(dctx);
+  REQUIRE(!ZSTD_isError(size));
+  plain.resize(size);
+  CHECK_EQ(plain, text);
+}
+
+#endif
+
+#if defined(FITORIA_HAS_BROTLI_SHARED_DICTIONARY)
+
+TEST_CASE("dcb")
+{
+  auto dict = middleware::compress_dictionary::builder(to_bytes(dictionary))
+                  .build();
+  REQUIRE(dict);
+
+  auto compressed = dict->compress(std::as_bytes(std::span(text)), "dcb");
+  REQUIRE(compressed);
+  REQUIRE_GT(compressed->size(), 36);
+  CHECK(std::ranges::equal(std::span(*compressed).first(4),
+                           std::as_bytes(std::span("\xff\x44\x43\x42", 4))));
+  CHECK(std::ranges::equal(std::span(*compressed).subspan(4, 32),
+                           dict->hash()));
+
+  auto plain = std::string(text.size(), '\0');
+  auto* state = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+  REQUIRE(BrotliDecoderAttachDictionary(
+      state,
+      BROTLI_SHARED_DICTIONARY_RAW,
+      dictionary.size(),
+      reinterpret_cast<const std::uint8_t*>(dictionary.data())));
+  auto avail_in = compressed->size() - 36;
+  auto next_in
+      = reinterpret_cast<const std::uint8_t*>(compressed->data() + 36);
+  auto avail_out = plain.size();
+  auto next_out = reinterpret_cast<std::uint8_t*>(plain.data());
+  CHECK_EQ(BrotliDecoderDecompressStream(
+               state, &avail_in, &next_in, &avail_out, &next_out, nullptr),
+           BROTLI_DECODER_RESULT_SUCCESS);
+  BrotliDecoderDestroyInstance(state);
+  CHECK_EQ(plain, text);
+}
+
+#endif
+
+TEST_CASE("unsupported coding")
+{
+  auto dict = middleware::compress_dictionary::builder(to_bytes(dictionary))
+                  .build();
+  REQUIRE(dict);
+  CHECK_EQ(dict->compress(std::as_bytes(std::span(text)), "gzip").error(),
+           std::errc::not_supported);
+}
+
+TEST_SUITE_END();
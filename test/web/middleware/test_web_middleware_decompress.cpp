@@ -238,9 +238,105 @@ TEST_CASE("decompress")
           co_return;
         });
 #endif
+
+#if defined(FITORIA_HAS_ZSTD)
+    server.serve_request(
+        "/",
+        test_request::post()
+            .set_header(http::field::content_encoding,
+                        "deflate, identity, zstd")
+            .set_stream_body(get_stream(
+                test_case.chunked,
+                std::vector<std::uint8_t> {
+                    0x28, 0xb5, 0x2f, 0xfd, 0x04, 0x58, 0x01, 0x02, 0x00, 0x4b,
+                    0x4c, 0x4a, 0x4e, 0x49, 0x4d, 0x4b, 0xcf, 0xc8, 0xcc, 0xca,
+                    0xce, 0xc9, 0xcd, 0xcb, 0x2f, 0x28, 0x2c, 0x2a, 0x2e, 0x29,
+                    0x2d, 0x2b, 0xaf, 0xa8, 0xac, 0x32, 0x30, 0x34, 0x32, 0x36,
+                    0x31, 0x35, 0x33, 0xb7, 0xb0, 0x74, 0x74, 0x72, 0x76, 0x71,
+                    0x75, 0x73, 0xf7, 0xf0, 0xf4, 0xf2, 0xf6, 0xf1, 0xf5, 0xf3,
+                    0x0f, 0x08, 0x0c, 0x0a, 0x0e, 0x09, 0x0d, 0x0b, 0x8f, 0x88,
+                    0x8c, 0x02, 0x00, 0x36, 0x41, 0xe1, 0x26 })),
+        [](test_response res) -> awaitable<void> {
+          CHECK_EQ(res.status(), http::status::ok);
+          co_return;
+        });
+    server.serve_request(
+        "/",
+        test_request::post()
+            .set_header(http::field::content_encoding, "zstd")
+            .set_stream_body(get_stream(
+                test_case.chunked,
+                std::vector<std::uint8_t> {
+                    0x28, 0xb5, 0x2f, 0xfd, 0x04, 0x58, 0xf1, 0x01, 0x00, 0x61,
+                    0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b,
+                    0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71, 0x72, 0x73, 0x74, 0x75,
+                    0x76, 0x77, 0x78, 0x79, 0x7a, 0x30, 0x31, 0x32, 0x33, 0x34,
+                    0x35, 0x36, 0x37, 0x38, 0x39, 0x41, 0x42, 0x43, 0x44, 0x45,
+                    0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
+                    0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+                    0x5a, 0xa0, 0x14, 0x3d, 0xc5 })),
+        [](test_response res) -> awaitable<void> {
+          CHECK_EQ(res.status(), http::status::ok);
+          co_return;
+        });
+#endif
+  }
+
+  ioc.run();
+}
+
+#if defined(FITORIA_HAS_ZLIB)
+
+TEST_CASE("limit the decompressed body")
+{
+  const auto plain = std::string(65536, 'a');
+  const auto compressed = middleware::detail::gzip_deflate_stream().compress(
+      std::as_bytes(std::span(plain)));
+  REQUIRE(compressed);
+
+  auto handler = [&](std::string body) -> awaitable<response> {
+    CHECK_EQ(body, plain);
+    co_return response::ok().build();
+  };
+
+  auto ioc = net::io_context();
+  auto server
+      = http_server::builder(ioc)
+            .serve(route::post<"/">(handler).use(
+                middleware::decompress().set_max_size(65536).set_max_ratio(
+                    1000)))
+            .serve(route::post<"/size">(handler).use(
+                middleware::decompress().set_max_size(65535)))
+            .serve(route::post<"/ratio">(handler).use(
+                middleware::decompress().set_max_ratio(10)))
+            .build();
+
+  struct test_case_t {
+    std::string path;
+    http::status status;
+  };
+
+  const auto test_cases = std::vector<test_case_t> {
+    { "/", http::status::ok },
+    { "/size", http::status::payload_too_large },
+    { "/ratio", http::status::payload_too_large },
+  };
+
+  for (auto& test_case : test_cases) {
+    server.serve_request(
+        test_case.path,
+        test_request::post()
+            .set_header(http::field::content_encoding, "gzip")
+            .set_stream_body(get_stream(false, *compressed)),
+        [status = test_case.status](test_response res) -> awaitable<void> {
+          CHECK_EQ(res.status(), status);
+          co_return;
+        });
   }
 
   ioc.run();
 }
 
+#endif
+
 TEST_SUITE_END();
@@ -0,0 +1,94 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <fitoria/test/test.hpp>
+
+#include <fitoria/web/middleware/detail/context_pool.hpp>
+
+#include <thread>
+
+using namespace fitoria;
+using namespace fitoria::web::middleware::detail;
+
+TEST_SUITE_BEGIN("[fitoria.web.middleware.detail.context_pool]");
+
+namespace {
+
+struct context {
+  explicit context(int level)
+      : level(level)
+  {
+  }
+
+  auto options() const -> std::tuple<int>
+  {
+    return { level };
+  }
+
+  auto reset() -> bool
+  {
+    ++resets;
+    return !broken;
+  }
+
+  int level;
+  int resets = 0;
+  bool broken = false;
+};
+
+using pool = context_pool<context, 2>;
+
+}
+
+TEST_CASE("contexts are reset and reused")
+{
+  const context* addr = nullptr;
+  {
+    auto ctx = pool::acquire(1);
+    CHECK_EQ(ctx->level, 1);
+    CHECK_EQ(ctx->resets, 0);
+    addr = ctx.get();
+  }
+  CHECK_EQ(pool::size(), 1);
+
+  {
+    auto ctx = pool::acquire(2);
+    CHECK_NE(ctx.get(), addr);
+    CHECK_EQ(pool::size(), 1);
+
+    auto reused = pool::acquire(1);
+    CHECK_EQ(reused.get(), addr);
+    CHECK_EQ(reused->resets, 1);
+    CHECK_EQ(pool::size(), 0);
+  }
+  CHECK_EQ(pool::size(), 2);
+
+  std::thread([] { CHECK_EQ(pool::size(), 0); }).join();
+
+  {
+    auto a = pool::acquire(1);
+    auto b = pool::acquire(2);
+    auto c = pool::acquire(3);
+    CHECK_EQ(pool::size(), 0);
+  }
+  CHECK_EQ(pool::size(), 2);
+}
+
+TEST_CASE("contexts failed to reset are dropped")
+{
+  using pool = context_pool<context, 1>;
+
+  auto ctx = pool::acquire(1);
+  ctx->broken = true;
+  ctx.reset();
+  CHECK_EQ(pool::size(), 0);
+
+  pool::acquire(1).reset();
+  CHECK_EQ(pool::size(), 1);
+}
+
+TEST_SUITE_END();
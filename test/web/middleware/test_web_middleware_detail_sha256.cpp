@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <fitoria/test/test.hpp>
+
+#include <fitoria/web/middleware/detail/sha256.hpp>
+
+#include <string>
+
+using namespace fitoria;
+using namespace fitoria::web::middleware::detail;
+
+TEST_SUITE_BEGIN("[fitoria.web.middleware.detail.sha256]");
+
+namespace {
+
+auto to_hex(const std::array<std::byte, 32>& digest) -> std::string
+{
+  auto hex = std::string();
+  for (auto b : digest) {
+    hex += "0123456789abcdef"[std::to_integer<int>(b) >> 4];
+    hex += "0123456789abcdef"[std::to_integer<int>(b) & 0x0f];
+  }
+  return hex;
+}
+
+}
+
+TEST_CASE("sha256")
+{
+  struct test_case_t {
+    std::string in;
+    std::string_view expected;
+  };
+
+  const auto test_cases = std::vector<test_case_t> {
+    { "",
+      "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+    { "abc",
+      "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+    { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+    { std::string(64, 'a'),
+      "ffe054fe7ae0cb6dc65c3af9b61d5209f439851db43d0ba5997337df154668eb" },
+    { std::string(1000000, 'a'),
+      "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+  };
+
+  for (auto& test_case : test_cases) {
+    CHECK_EQ(to_hex(sha256(std::as_bytes(std::span(test_case.in)))),
+             test_case.expected);
+  }
+}
+
+TEST_SUITE_END();
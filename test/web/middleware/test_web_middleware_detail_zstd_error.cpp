@@ -0,0 +1,31 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <fitoria/test/test.hpp>
+
+#include <fitoria/web/middleware/detail/zstd_error.hpp>
+
+using namespace fitoria;
+using namespace fitoria::web::middleware::detail;
+
+TEST_SUITE_BEGIN("[fitoria.web.zstd_error]");
+
+TEST_CASE("message")
+{
+  CHECK_EQ(make_error_code(zstd_error::error).message(), "zstd error");
+  CHECK_EQ(make_error_code(zstd_error::init).message(),
+           "initialization error");
+  CHECK_EQ(make_error_code(static_cast<zstd_error>(-1)).message(), "");
+}
+
+TEST_CASE("category")
+{
+  CHECK_EQ(make_error_code(zstd_error::error).category().name(),
+           std::string_view("fitoria.web.zstd_error"));
+}
+
+TEST_SUITE_END();
@@ -30,6 +30,7 @@ TEST_CASE("builder")
                     .set_request_timeout(std::chrono::seconds(10))
                     .set_request_header_limit(nullopt)
                     .set_request_body_limit(nullopt)
+                    .set_request_body_spill_threshold(65536)
 #if !FITORIA_NO_EXCEPTIONS
                     .set_exception_handler([](std::exception_ptr ptr) {
                       if (ptr) {
@@ -52,6 +53,7 @@ TEST_CASE("builder")
   REQUIRE_EQ(server.request_timeout(), std::chrono::seconds(10));
   REQUIRE_EQ(server.request_header_limit(), nullopt);
   REQUIRE_EQ(server.request_body_limit(), nullopt);
+  REQUIRE_EQ(server.request_body_spill_threshold(), 65536);
 
   auto worker = std::thread([&]() { ioc.run(); });
   auto guard = boost::scope::make_scope_exit([&]() {
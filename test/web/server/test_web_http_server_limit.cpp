@@ -7,10 +7,13 @@
 
 #include <fitoria/test/test.hpp>
 
+#include <fitoria/test/utility.hpp>
+
 #include <fitoria/web.hpp>
 
 using namespace fitoria;
 using namespace fitoria::web;
+using namespace fitoria::test;
 
 TEST_SUITE_BEGIN("[fitoria.web.http_server.limit]");
 
@@ -39,4 +42,131 @@ TEST_CASE("header_limit")
   ioc.run();
 }
 
+#if defined(BOOST_ASIO_HAS_FILE)
+
+TEST_CASE("request_body_spill_threshold")
+{
+  const auto small = get_random_string(1024);
+  const auto large = get_random_string(65536);
+
+  auto ioc = net::io_context();
+  auto server
+      = http_server::builder(ioc)
+            .set_request_body_limit(65536)
+            .set_request_body_spill_threshold(4096)
+            .serve(route::post<"/">([&](request& req) -> awaitable<response> {
+              const bool spilled
+                  = req.body().target<async_readable_file_stream>() != nullptr;
+              REQUIRE_NE(spilled,
+                         req.body().target<async_readable_vector_stream>()
+                             != nullptr);
+              if (spilled) {
+                REQUIRE_EQ(req.body()
+                               .target<async_readable_file_stream>()
+                               ->file()
+                               .size(),
+                           large.size());
+              }
+
+              auto body = co_await async_read_until_eof<std::string>(
+                  req.body());
+              REQUIRE(body);
+              REQUIRE_EQ(*body, spilled ? large : small);
+              co_return response::ok().build();
+            }))
+            .build();
+
+  server.serve_request("/",
+                       test_request::post().set_body(small),
+                       [](test_response res) -> awaitable<void> {
+                         REQUIRE_EQ(res.status(), http::status::ok);
+                         co_return;
+                       });
+  server.serve_request("/",
+                       test_request::post().set_body(large),
+                       [](test_response res) -> awaitable<void> {
+                         REQUIRE_EQ(res.status(), http::status::ok);
+                         co_return;
+                       });
+  server.serve_request("/",
+                       test_request::post().set_body(large + "!"),
+                       [](test_response res) -> awaitable<void> {
+                         REQUIRE_EQ(res.status(),
+                                    http::status::payload_too_large);
+                         REQUIRE_EQ(co_await res.as_string(),
+                                    "request body size exceeds limit");
+                       });
+
+  ioc.run();
+}
+
+namespace {
+
+class chunk_size_recorder {
+public:
+  using is_async_readable_stream = void;
+
+  chunk_size_recorder(any_async_readable_stream& stream,
+                      std::vector<std::size_t>& sizes)
+      : stream_(stream)
+      , sizes_(sizes)
+  {
+  }
+
+  auto
+  async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
+  {
+    auto data = co_await stream_.async_read_some();
+    if (data && *data) {
+      sizes_.push_back((*data)->size());
+    }
+    co_return data;
+  }
+
+private:
+  any_async_readable_stream& stream_;
+  std::vector<std::size_t>& sizes_;
+};
+
+}
+
+TEST_CASE("request_body_spill_threshold: spill the body as it arrives")
+{
+  const auto large = get_random_string(1048576);
+
+  auto ioc = net::io_context();
+  auto server = http_server::builder(ioc)
+                    .serve(route::get<"/">([&]() -> awaitable<response> {
+                      co_return response::ok().set_body(large);
+                    }))
+                    .build();
+
+  server.serve_request(
+      "/",
+      test_request::get().build(),
+      [&](test_response res) -> awaitable<void> {
+        REQUIRE_EQ(res.status(), http::status::ok);
+
+        // the message parser stream yields one bounded buffer at a time, so
+        // only a single buffer is held in memory before spilling
+        auto sizes = std::vector<std::size_t>();
+        auto spilled = co_await detail::async_spill_body(
+            chunk_size_recorder(res.body(), sizes), 4096);
+        REQUIRE(spilled);
+        REQUIRE_GT(sizes.size(), 1);
+        for (auto size : sizes) {
+          REQUIRE_LE(size, 65536);
+        }
+
+        REQUIRE(spilled->target<async_readable_file_stream>());
+        auto body = co_await async_read_until_eof<std::string>(*spilled);
+        REQUIRE(body);
+        REQUIRE_EQ(*body, large);
+      });
+
+  ioc.run();
+}
+
+#endif
+
 TEST_SUITE_END();
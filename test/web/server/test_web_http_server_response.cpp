@@ -10,11 +10,14 @@
 #include <fitoria/test/async_readable_chunk_stream.hpp>
 #include <fitoria/test/http_client.hpp>
 #include <fitoria/test/http_server_utils.hpp>
+#include <fitoria/test/utility.hpp>
 
 #include <fitoria/web.hpp>
 
 #include <boost/scope/scope_exit.hpp>
 
+#include <fstream>
+
 using namespace fitoria;
 using namespace fitoria::web;
 using namespace fitoria::test;
@@ -103,6 +106,150 @@ TEST_CASE("response with plain text")
       .get();
 }
 
+TEST_CASE("response with stream of known size")
+{
+  const auto text = std::string_view("abcdefghijklmnopqrstuvwxyz");
+
+  const auto port = generate_port();
+  auto ioc = net::io_context();
+  auto server
+      = http_server::builder(ioc)
+            .serve(route::get<"/">([text]() -> awaitable<response> {
+              co_return response::ok()
+                  .set_header(http::field::content_type, mime::text_plain())
+                  .set_body(async_readable_chunk_stream<5>(text), text.size());
+            }))
+            .serve(route::get<"/short">([text]() -> awaitable<response> {
+              co_return response::ok()
+                  .set_header(http::field::content_type, mime::text_plain())
+                  .set_body(async_readable_chunk_stream<5>(text),
+                            text.size() + 1);
+            }))
+            .serve(route::get<"/long">([text]() -> awaitable<response> {
+              co_return response::ok()
+                  .set_header(http::field::content_type, mime::text_plain())
+                  .set_body(async_readable_chunk_stream<5>(text),
+                            text.size() - 1);
+            }))
+            .build();
+  REQUIRE(server.bind(localhost, port));
+
+  auto worker = std::thread([&]() { ioc.run(); });
+  auto guard = boost::scope::make_scope_exit([&]() {
+    ioc.stop();
+    worker.join();
+  });
+  std::this_thread::sleep_for(server_start_wait_time);
+
+  net::co_spawn(
+      ioc,
+      [&]() -> awaitable<void> {
+        auto res
+            = co_await http_client()
+                  .set_method(http::verb::get)
+                  .set_url(to_local_url(boost::urls::scheme::http, port, "/"))
+                  .set_header(http::field::connection, "close")
+                  .async_send();
+        REQUIRE_EQ(res->status(), http::status::ok);
+        REQUIRE_EQ(res->headers().get(http::field::content_type),
+                   mime::text_plain());
+        REQUIRE_EQ(res->headers().get(http::field::content_length),
+                   std::to_string(text.size()));
+        REQUIRE(!res->headers().get(http::field::transfer_encoding));
+        REQUIRE_EQ(co_await res->as_string(), text);
+      },
+      net::use_future)
+      .get();
+
+  for (auto path : { "/short", "/long" }) {
+    net::co_spawn(
+        ioc,
+        [&]() -> awaitable<void> {
+          auto res = co_await http_client()
+                         .set_method(http::verb::get)
+                         .set_url(to_local_url(
+                             boost::urls::scheme::http, port, path))
+                         .set_header(http::field::connection, "close")
+                         .async_send();
+          REQUIRE_EQ(res->status(), http::status::ok);
+          REQUIRE_NE(co_await res->as_string(), text);
+        },
+        net::use_future)
+        .get();
+  }
+}
+
+TEST_CASE("response with mapped file")
+{
+  const auto file_path = get_temp_file_path();
+  const auto data = get_random_string(1048576);
+  {
+    std::ofstream(file_path, std::ios::binary) << data;
+  }
+  auto file = mapped_file::open(file_path);
+  REQUIRE(file);
+
+  const auto port = generate_port();
+  auto ioc = net::io_context();
+  auto server
+      = http_server::builder(ioc)
+            .serve(route::get<"/">([&]() -> awaitable<response> {
+              co_return response::ok()
+                  .set_header(http::field::content_type,
+                              mime::application_octet_stream())
+                  .set_body(async_readable_mmap_stream(*file, 1000, 500000),
+                            500000);
+            }))
+            .serve(route::get<"/short">([&]() -> awaitable<response> {
+              co_return response::ok()
+                  .set_header(http::field::content_type,
+                              mime::application_octet_stream())
+                  .set_body(async_readable_mmap_stream(*file, 1000, 500000),
+                            500001);
+            }))
+            .build();
+  REQUIRE(server.bind(localhost, port));
+
+  auto worker = std::thread([&]() { ioc.run(); });
+  auto guard = boost::scope::make_scope_exit([&]() {
+    ioc.stop();
+    worker.join();
+  });
+  std::this_thread::sleep_for(server_start_wait_time);
+
+  net::co_spawn(
+      ioc,
+      [&]() -> awaitable<void> {
+        auto res
+            = co_await http_client()
+                  .set_method(http::verb::get)
+                  .set_url(to_local_url(boost::urls::scheme::http, port, "/"))
+                  .set_header(http::field::connection, "close")
+                  .async_send();
+        REQUIRE_EQ(res->status(), http::status::ok);
+        REQUIRE_EQ(res->headers().get(http::field::content_length), "500000");
+        REQUIRE_EQ(co_await res->as_string(),
+                   std::string_view(data).substr(1000, 500000));
+      },
+      net::use_future)
+      .get();
+
+  net::co_spawn(
+      ioc,
+      [&]() -> awaitable<void> {
+        // the connection is closed instead of sending a short body
+        auto res = co_await http_client()
+                       .set_method(http::verb::get)
+                       .set_url(to_local_url(
+                           boost::urls::scheme::http, port, "/short"))
+                       .set_header(http::field::connection, "close")
+                       .async_send();
+        REQUIRE(!res);
+      },
+      net::use_future)
+      .get();
+}
+
 TEST_CASE("response with with stream (chunked transfer-encoding)")
 {
   const auto text = std::string_view("abcdefghijklmnopqrstuvwxyz");
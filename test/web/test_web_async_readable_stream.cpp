@@ -14,8 +14,11 @@
 #include <fitoria/test/http_server_utils.hpp>
 #include <fitoria/test/utility.hpp>
 
+#include <fitoria/web/any_async_readable_stream.hpp>
+#include <fitoria/web/async_channel_stream.hpp>
 #include <fitoria/web/async_read_until_eof.hpp>
 #include <fitoria/web/async_readable_file_stream.hpp>
+#include <fitoria/web/async_readable_mmap_stream.hpp>
 #include <fitoria/web/async_readable_stream_concept.hpp>
 #include <fitoria/web/async_readable_vector_stream.hpp>
 
@@ -45,8 +48,213 @@ TEST_CASE("async_readable_vector_stream: read chunk by chunk")
   });
 }
 
+TEST_CASE("async_readable_vector_stream: size_hint")
+{
+  sync_wait([&]() -> awaitable<void> {
+    auto stream = async_readable_vector_stream(bytes(9, std::byte(0x40)));
+    CHECK_EQ(get_size_hint(stream), 9);
+    CHECK_EQ(any_async_readable_stream(async_readable_vector_stream(
+                                           bytes(9, std::byte(0x40))))
+                 .size_hint(),
+             9);
+    co_await stream.async_read_some();
+    CHECK_EQ(get_size_hint(stream), 0);
+  });
+}
+
+TEST_CASE("async_readable_shared_buffer_stream: read chunk by chunk")
+{
+  sync_wait([&]() -> awaitable<void> {
+    auto data = std::make_shared<const bytes>(100000, std::byte(0x40));
+    auto stream = async_readable_shared_buffer_stream(data);
+    CHECK_EQ(get_size_hint(stream), 100000);
+    CHECK_EQ(stream.remaining().data(), data->data());
+
+    CHECK_EQ(co_await stream.async_read_some(), bytes(65536, std::byte(0x40)));
+    CHECK_EQ(get_size_hint(stream), 100000 - 65536);
+    CHECK_EQ(stream.remaining().data(), data->data() + 65536);
+    CHECK_EQ(co_await stream.async_read_some(),
+             bytes(100000 - 65536, std::byte(0x40)));
+    CHECK(stream.remaining().empty());
+    CHECK(!(co_await stream.async_read_some()));
+
+    auto range = async_readable_shared_buffer_stream(data, 99990, 100);
+    CHECK_EQ(get_size_hint(range), 10);
+    CHECK_EQ(range.remaining().data(), data->data() + 99990);
+    CHECK_EQ(co_await range.async_read_some(), bytes(10, std::byte(0x40)));
+    CHECK(!(co_await range.async_read_some()));
+
+    // the buffer is shared, not consumed
+    CHECK_EQ(co_await async_read_until_eof<bytes>(
+                 async_readable_shared_buffer_stream(data)),
+             *data);
+  });
+}
+
+TEST_CASE("async_read_until_eof: take over the single chunk")
+{
+  sync_wait([&]() -> awaitable<void> {
+    auto data = bytes(1048576, std::byte(0x40));
+    const auto* ptr = data.data();
+    auto result = co_await async_read_until_eof<bytes>(
+        async_readable_vector_stream(std::move(data)));
+    CHECK(result);
+    CHECK_EQ(result->size(), 1048576);
+    CHECK_EQ(result->data(), ptr);
+  });
+}
+
+TEST_CASE("async_channel_stream: read until writer closes")
+{
+  sync_wait([&]() -> awaitable<void> {
+    auto stream = async_channel_stream(co_await net::this_coro::executor, 4);
+    auto writer = stream.get_writer();
+    CHECK(co_await writer.async_send("abc"));
+    CHECK(co_await writer.async_send(bytes(2, std::byte(0x40))));
+    writer.close();
+    CHECK(!(co_await writer.async_send("def")));
+
+    CHECK_EQ(co_await async_read_until_eof<std::string>(stream), "abc@@");
+  });
+}
+
+TEST_CASE("async_channel_stream: back-pressure")
+{
+  sync_wait([&]() -> awaitable<void> {
+    auto ex = co_await net::this_coro::executor;
+    auto stream = async_channel_stream(ex, 1);
+    std::size_t sent = 0;
+    net::co_spawn(
+        ex,
+        [](async_channel_stream::writer writer,
+           std::size_t& sent) -> awaitable<void> {
+          for (int i = 0; i < 8; ++i) {
+            CHECK(co_await writer.async_send("x"));
+            ++sent;
+          }
+        }(stream.get_writer(), sent),
+        net::detached);
+
+    auto timer = net::steady_timer(ex);
+    timer.expires_after(std::chrono::milliseconds(10));
+    CHECK(co_await timer.async_wait(use_awaitable));
+    // one chunk is buffered, the producer is suspended on the next one
+    CHECK_LE(sent, 2);
+
+    // the stream ends once the last writer is destroyed
+    CHECK_EQ(co_await async_read_until_eof<std::string>(stream),
+             std::string(8, 'x'));
+    CHECK_EQ(sent, 8);
+  });
+}
+
+TEST_CASE("async_channel_stream: send after reader is destroyed")
+{
+  sync_wait([&]() -> awaitable<void> {
+    auto ex = co_await net::this_coro::executor;
+    auto writer = [&]() {
+      auto stream = async_channel_stream(ex, 4);
+      return stream.get_writer();
+    }();
+    CHECK(!(co_await writer.async_send("abc")));
+  });
+}
+
+TEST_CASE("async_readable_mmap_stream: read file")
+{
+  const auto file_path = get_temp_file_path();
+  const auto data = get_random_string(1048576);
+  {
+    std::ofstream(file_path, std::ios::binary) << data;
+  }
+
+  auto file = mapped_file::open(file_path);
+  REQUIRE(file);
+  CHECK_EQ((*file)->size(), 1048576);
+
+  sync_wait([&]() -> awaitable<void> {
+    CHECK_EQ(co_await async_read_until_eof<std::string>(
+                 async_readable_mmap_stream(*file)),
+             data);
+    CHECK_EQ(co_await async_read_until_eof<std::string>(
+                 async_readable_mmap_stream(*file, 123456, 234567)),
+             std::string_view(data).substr(123456, 234567));
+
+    auto stream = async_readable_mmap_stream(*file, 1048000, 1000);
+    CHECK_EQ(get_size_hint(stream), 576);
+    CHECK_EQ(stream.remaining().size(), 576);
+    CHECK_EQ(stream.remaining().data(), (*file)->data().data() + 1048000);
+    co_await stream.async_read_some();
+    CHECK(stream.remaining().empty());
+    CHECK(!(co_await stream.async_read_some()));
+  });
+}
+
+TEST_CASE("async_readable_mmap_stream: share the mapping")
+{
+  const auto file_path = get_temp_file_path();
+  {
+    std::ofstream(file_path, std::ios::binary) << "old";
+  }
+
+  auto file = mapped_file::open(file_path);
+  REQUIRE(file);
+  auto shared = mapped_file::open(file_path);
+  REQUIRE(shared);
+  CHECK_EQ(file->get(), shared->get());
+
+  // a changed file is mapped again
+  std::filesystem::remove(file_path);
+  {
+    std::ofstream(file_path, std::ios::binary) << "new content";
+  }
+  std::filesystem::last_write_time(
+      file_path, (*file)->last_write_time() + std::chrono::seconds(1));
+  auto changed = mapped_file::open(file_path);
+  REQUIRE(changed);
+  CHECK_NE(file->get(), changed->get());
+  sync_wait([&]() -> awaitable<void> {
+    CHECK_EQ(co_await async_read_until_eof<std::string>(
+                 async_readable_mmap_stream(*file)),
+             "old");
+    CHECK_EQ(co_await async_read_until_eof<std::string>(
+                 async_readable_mmap_stream(*changed)),
+             "new content");
+  });
+
+  {
+    std::ofstream(file_path, std::ios::binary | std::ios::trunc);
+  }
+  auto empty = mapped_file::open(file_path);
+  REQUIRE(empty);
+  CHECK_EQ((*empty)->size(), 0);
+  CHECK(!mapped_file::open(get_temp_file_path()));
+}
+
 #if defined(BOOST_ASIO_HAS_FILE)
 
+TEST_CASE("async_readable_file_stream: size_hint")
+{
+  const auto file_path = get_temp_file_path();
+  const auto data = get_random_string(1048576);
+  {
+    std::ofstream(file_path, std::ios::binary) << data;
+  }
+
+  sync_wait([&]() -> awaitable<void> {
+    auto stream = async_readable_file_stream(
+        stream_file(co_await net::this_coro::executor,
+                    file_path,
+                    net::file_base::read_only),
+        123456,
+        nullopt);
+    CHECK_EQ(get_size_hint(stream), 1048576 - 123456);
+    auto chunk = co_await stream.async_read_some();
+    CHECK(chunk);
+    CHECK_EQ(get_size_hint(stream), 1048576 - 123456 - (*chunk)->size());
+  });
+}
+
 TEST_CASE("async_readable_file_stream: read complete file")
 {
   const auto file_path = get_temp_file_path();
@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <fitoria/test/test.hpp>
+
+#include <fitoria/test/async_readable_chunk_stream.hpp>
+#include <fitoria/test/http_server_utils.hpp>
+
+#include <fitoria/web/async_readable_vector_stream.hpp>
+#include <fitoria/web/async_write_chunks.hpp>
+
+using namespace fitoria;
+using namespace fitoria::web;
+using namespace fitoria::test;
+
+namespace {
+
+class async_readable_pieces_stream {
+public:
+  using is_async_readable_stream = void;
+
+  async_readable_pieces_stream(std::vector<std::string> pieces)
+      : pieces_(std::move(pieces))
+  {
+  }
+
+  auto
+  async_read_some() -> awaitable<optional<expected<bytes, std::error_code>>>
+  {
+    if (index_ >= pieces_.size()) {
+      co_return nullopt;
+    }
+
+    const auto& piece = pieces_[index_++];
+    co_return bytes(std::as_bytes(std::span(piece)).begin(),
+                    std::as_bytes(std::span(piece)).end());
+  }
+
+private:
+  std::vector<std::string> pieces_;
+  std::size_t index_ = 0;
+};
+
+template <async_readable_stream AsyncReadableStream>
+auto write_chunks(AsyncReadableStream&& stream,
+                  optional<chunk_coalescing> coalescing)
+    -> awaitable<std::string>
+{
+  auto ex = co_await net::this_coro::executor;
+  auto client = boost::beast::test::stream(ex);
+  auto server = boost::beast::test::stream(ex);
+  client.connect(server);
+
+  auto result = co_await async_write_chunks(
+      client, std::forward<AsyncReadableStream>(stream), coalescing);
+  CHECK(result);
+
+  co_return std::string(server.str());
+}
+
+}
+
+TEST_SUITE_BEGIN("[fitoria.web.async_write_chunks]");
+
+TEST_CASE("async_write_chunks: without coalescing")
+{
+  sync_wait([]() -> awaitable<void> {
+    CHECK_EQ(co_await write_chunks(
+                 async_readable_chunk_stream<10>("abcdefghijklmnopqrstuvwxyz"),
+                 nullopt),
+             "a\r\nabcdefghij\r\n"
+             "a\r\nklmnopqrst\r\n"
+             "6\r\nuvwxyz\r\n"
+             "0\r\n\r\n");
+    CHECK_EQ(co_await write_chunks(async_readable_vector_stream(), nullopt),
+             "0\r\n\r\n");
+  });
+}
+
+TEST_CASE("async_write_chunks: coalesce by threshold")
+{
+  sync_wait([]() -> awaitable<void> {
+    CHECK_EQ(co_await write_chunks(
+                 async_readable_chunk_stream<5>("abcdefghijklmnopqrstuvwxyz"),
+                 chunk_coalescing { .threshold = 12 }),
+             "f\r\nabcdefghijklmno\r\n"
+             "b\r\npqrstuvwxyz\r\n0\r\n\r\n");
+  });
+}
+
+TEST_CASE("async_write_chunks: large chunks are not coalesced")
+{
+  sync_wait([]() -> awaitable<void> {
+    CHECK_EQ(co_await write_chunks(
+                 async_readable_pieces_stream({ "ab", "cdefghij", "k" }),
+                 chunk_coalescing { .threshold = 4 }),
+             "a\r\nabcdefghij\r\n1\r\nk\r\n0\r\n\r\n");
+    CHECK_EQ(co_await write_chunks(
+                 async_readable_pieces_stream({ "abcdefgh", "ij" }),
+                 chunk_coalescing { .threshold = 4 }),
+             "8\r\nabcdefgh\r\n2\r\nij\r\n0\r\n\r\n");
+  });
+}
+
+TEST_CASE("async_write_chunks: explicit flush")
+{
+  sync_wait([]() -> awaitable<void> {
+    CHECK_EQ(co_await write_chunks(
+                 async_readable_pieces_stream({ "ab", "cd", "", "", "ef" }),
+                 chunk_coalescing { .threshold = 1024 }),
+             "4\r\nabcd\r\n2\r\nef\r\n0\r\n\r\n");
+    CHECK_EQ(co_await write_chunks(
+                 async_readable_pieces_stream({ "ab", "" }), nullopt),
+             "2\r\nab\r\n0\r\n\r\n");
+  });
+}
+
+TEST_SUITE_END();
@@ -7,6 +7,7 @@
 
 #include <fitoria/test/test.hpp>
 
+#include <fitoria/test/http_server_utils.hpp>
 #include <fitoria/test/utility.hpp>
 
 #include <fitoria/web.hpp>
@@ -595,4 +596,328 @@ TEST_CASE("json_of<T>")
   ioc.run();
 }
 
+namespace {
+struct profile_t {
+  std::string name;
+  int age;
+
+  friend bool operator==(const profile_t&, const profile_t&) = default;
+};
+}
+
+TEST_CASE("json_of<T>: aggregate without tag_invoke")
+{
+  auto ioc = net::io_context();
+  auto server
+      = http_server::builder(ioc)
+            .serve(route::post<"/">(
+                [](json_of<profile_t> profile) -> awaitable<response> {
+                  CHECK_EQ(profile.name, "Rina Hidaka");
+                  CHECK_EQ(profile.age, 30);
+                  co_return response::ok().set_json(
+                      static_cast<const profile_t&>(profile));
+                }))
+            .build();
+
+  const auto profile = profile_t { .name = "Rina Hidaka", .age = 30 };
+  server.serve_request("/",
+                       test_request::post().set_json(profile),
+                       [=](test_response res) -> awaitable<void> {
+                         CHECK_EQ(res.status(), http::status::ok);
+                         CHECK_EQ(res.headers().get(http::field::content_type),
+                                  mime::application_json());
+                         CHECK_EQ(co_await res.template as_json<profile_t>(),
+                                  profile);
+                       });
+  server.serve_request("/",
+                       test_request::post().set_json(
+                           boost::json::value { { "name", "Rina Hidaka" } }),
+                       [](test_response res) -> awaitable<void> {
+                         CHECK_EQ(res.status(), http::status::bad_request);
+                         co_return;
+                       });
+
+  ioc.run();
+}
+
+TEST_CASE("json_of<T, Limit>: body exceeds limit")
+{
+  auto ioc = net::io_context();
+  auto server = http_server::builder(ioc)
+                    .serve(route::post<"/">(
+                        [](json_of<user_t, 40> user) -> awaitable<response> {
+                          co_return response::ok().set_json(user);
+                        }))
+                    .build();
+
+  server.serve_request("/",
+                       test_request::post().set_json(user_t {
+                           .name = "Rina",
+                           .birth = "1994/06/15",
+                       }),
+                       [](test_response res) -> awaitable<void> {
+                         CHECK_EQ(res.status(), http::status::ok);
+                         co_return;
+                       });
+  server.serve_request("/",
+                       test_request::post().set_json(user_t {
+                           .name = "Rina Hidaka",
+                           .birth = "1994/06/15",
+                       }),
+                       [](test_response res) -> awaitable<void> {
+                         CHECK_EQ(res.status(),
+                                  http::status::payload_too_large);
+                         co_return;
+                       });
+
+  ioc.run();
+}
+
+TEST_CASE("multipart_of<PartLimit>")
+{
+  const auto body = std::string_view("preamble\r\n"
+                                     "--XyZ\r\n"
+                                     "Content-Disposition: form-data; "
+                                     "name=\"title\"\r\n"
+                                     "\r\n"
+                                     "hello\r\n"
+                                     "--XyZ\r\n"
+                                     "Content-Disposition: form-data; "
+                                     "name=\"file\"; filename=\"a.txt\"\r\n"
+                                     "Content-Type: text/plain\r\n"
+                                     "\r\n"
+                                     "line1\r\n--Xy\r\nline2\r\n"
+                                     "--XyZ--\r\n");
+
+  auto ioc = net::io_context();
+  auto server
+      = http_server::builder(ioc)
+            .serve(route::post<"/">(
+                [](multipart_of<> form) -> awaitable<response> {
+                  auto part = co_await form.async_next_part();
+                  REQUIRE(part);
+                  REQUIRE(*part);
+                  CHECK_EQ((*part)->name(), "title");
+                  CHECK_EQ((*part)->filename(), nullopt);
+                  CHECK_EQ(co_await async_read_until_eof<std::string>(**part),
+                           "hello");
+
+                  part = co_await form.async_next_part();
+                  REQUIRE(part);
+                  REQUIRE(*part);
+                  CHECK_EQ((*part)->name(), "file");
+                  CHECK_EQ((*part)->filename(), "a.txt");
+                  CHECK_EQ((*part)->headers().get(http::field::content_type),
+                           "text/plain");
+                  CHECK_EQ(co_await async_read_until_eof<std::string>(**part),
+                           "line1\r\n--Xy\r\nline2");
+
+                  CHECK(!(co_await form.async_next_part()));
+                  co_return response::ok().build();
+                }))
+            .build();
+
+  server.serve_request("/",
+                       test_request::post()
+                           .set_header(http::field::content_type,
+                                       "multipart/form-data; boundary=XyZ")
+                           .set_body(body),
+                       [](test_response res) -> awaitable<void> {
+                         CHECK_EQ(res.status(), http::status::ok);
+                         co_return;
+                       });
+  server.serve_request("/",
+                       test_request::post()
+                           .set_header(http::field::content_type,
+                                       "multipart/form-data; boundary=\"XyZ\"")
+                           .set_body(body),
+                       [](test_response res) -> awaitable<void> {
+                         CHECK_EQ(res.status(), http::status::ok);
+                         co_return;
+                       });
+  server.serve_request("/",
+                       test_request::post()
+                           .set_header(http::field::content_type,
+                                       mime::multipart_form_data())
+                           .set_body(body),
+                       [](test_response res) -> awaitable<void> {
+                         CHECK_EQ(res.status(), http::status::bad_request);
+                         co_return;
+                       });
+  server.serve_request("/",
+                       test_request::post().set_body(body),
+                       [](test_response res) -> awaitable<void> {
+                         CHECK_EQ(res.status(), http::status::bad_request);
+                         co_return;
+                       });
+
+  ioc.run();
+}
+
+TEST_CASE("multipart_of<PartLimit>: boundary")
+{
+  struct test_case_t {
+    std::string content_type;
+    std::string boundary;
+    http::status status;
+  };
+
+  const auto test_cases = std::vector<test_case_t> {
+    // browsers
+    { "multipart/form-data; boundary=----WebKitFormBoundary7MA4YWxkTrZu0gW",
+      "----WebKitFormBoundary7MA4YWxkTrZu0gW",
+      http::status::ok },
+    // curl
+    { "multipart/form-data; boundary=------------------------d74496d66958873e",
+      "------------------------d74496d66958873e",
+      http::status::ok },
+    { R"(Multipart/Form-Data; charset=utf-8; boundary="a'()+_,-./:=? b")",
+      "a'()+_,-./:=? b",
+      http::status::ok },
+    { "multipart/form-data; boundary=\"" + std::string(70, '-') + "\"",
+      std::string(70, '-'),
+      http::status::ok },
+    { "multipart/form-data; boundary=\"" + std::string(71, '-') + "\"",
+      std::string(71, '-'),
+      http::status::bad_request },
+    { R"(multipart/form-data; boundary="")", "", http::status::bad_request },
+    { R"(multipart/form-data; boundary="ab ")",
+      "ab ",
+      http::status::bad_request },
+    { "multipart/form-data; boundary=a@b", "a@b", http::status::bad_request },
+  };
+
+  auto ioc = net::io_context();
+  auto server
+      = http_server::builder(ioc)
+            .serve(route::post<"/">(
+                [](multipart_of<> form) -> awaitable<response> {
+                  auto part = co_await form.async_next_part();
+                  REQUIRE(part);
+                  REQUIRE(*part);
+                  CHECK_EQ((*part)->name(), "title");
+                  CHECK_EQ(co_await async_read_until_eof<std::string>(**part),
+                           "hello");
+
+                  CHECK(!(co_await form.async_next_part()));
+                  co_return response::ok().build();
+                }))
+            .build();
+
+  for (auto& test_case : test_cases) {
+    server.serve_request(
+        "/",
+        test_request::post()
+            .set_header(http::field::content_type, test_case.content_type)
+            .set_body(fmt::format("--{0}\r\n"
+                                  "Content-Disposition: form-data; "
+                                  "name=\"title\"\r\n"
+                                  "\r\n"
+                                  "hello\r\n"
+                                  "--{0}--\r\n",
+                                  test_case.boundary)),
+        [status = test_case.status](test_response res) -> awaitable<void> {
+          CHECK_EQ(res.status(), status);
+          co_return;
+        });
+  }
+
+  ioc.run();
+}
+
+TEST_CASE("multipart_of<PartLimit>: parse chunk by chunk")
+{
+  const auto body = std::string_view("--XyZ\r\n"
+                                     "Content-Disposition: form-data; "
+                                     "name=\"a\"\r\n"
+                                     "\r\n"
+                                     "abc\r\n--XyZdef\r\n"
+                                     "--XyZ  \r\n"
+                                     "\r\n"
+                                     "\r\n"
+                                     "--XyZ\r\n"
+                                     "Content-Disposition: form-data; "
+                                     "name=\"c\"\r\n"
+                                     "\r\n"
+                                     "skipped\r\n"
+                                     "--XyZ--");
+
+  for (std::size_t step : { 1, 2, 3, 5, 8, 13, 1024 }) {
+    sync_wait([&]() -> awaitable<void> {
+      auto stream = async_channel_stream(co_await net::this_coro::executor,
+                                         body.size());
+      {
+        auto writer = stream.get_writer();
+        for (std::size_t i = 0; i < body.size(); i += step) {
+          CHECK(co_await writer.async_send(body.substr(i, step)));
+        }
+      }
+
+      auto form = multipart_of<>(std::move(stream), "XyZ");
+      auto part = co_await form.async_next_part();
+      REQUIRE(part);
+      REQUIRE(*part);
+      CHECK_EQ((*part)->name(), "a");
+      CHECK_EQ(co_await async_read_until_eof<std::string>(**part),
+               "abc\r\n--XyZdef");
+
+      part = co_await form.async_next_part();
+      REQUIRE(part);
+      REQUIRE(*part);
+      CHECK((*part)->headers().empty());
+      CHECK_EQ(co_await async_read_until_eof<std::string>(**part), "");
+
+      part = co_await form.async_next_part();
+      REQUIRE(part);
+      REQUIRE(*part);
+      CHECK_EQ((*part)->name(), "c");
+
+      // the unread data of the previous part is skipped
+      CHECK(!(co_await form.async_next_part()));
+      CHECK(!(co_await (*part)->async_read_some()));
+    });
+  }
+}
+
+TEST_CASE("multipart_of<PartLimit>: part exceeds limit")
+{
+  sync_wait([]() -> awaitable<void> {
+    const auto body = std::string_view("--XyZ\r\n\r\nabcdefgh\r\n--XyZ--");
+    auto form
+        = multipart_of<4>(async_readable_vector_stream(std::span(body)), "XyZ");
+    auto part = co_await form.async_next_part();
+    REQUIRE(part);
+    REQUIRE(*part);
+    CHECK_EQ(co_await async_read_until_eof<std::string>(**part),
+             unexpected { make_error_code(std::errc::message_size) });
+  });
+}
+
+TEST_CASE("multipart_of<PartLimit>: malformed body")
+{
+  sync_wait([]() -> awaitable<void> {
+    {
+      const auto body = std::string_view("--XyZ\r\n\r\nabc");
+      auto form = multipart_of<>(
+          async_readable_vector_stream(std::span(body)), "XyZ");
+      auto part = co_await form.async_next_part();
+      REQUIRE(part);
+      REQUIRE(*part);
+      CHECK_EQ(co_await async_read_until_eof<std::string>(**part),
+               unexpected { make_error_code(std::errc::bad_message) });
+      auto next = co_await form.async_next_part();
+      REQUIRE(next);
+      CHECK_EQ(next->error(), make_error_code(std::errc::bad_message));
+    }
+    {
+      const auto body = std::string_view("--XyZ\r\nbad\r\n\r\n--XyZ--");
+      auto form = multipart_of<>(
+          async_readable_vector_stream(std::span(body)), "XyZ");
+      auto next = co_await form.async_next_part();
+      REQUIRE(next);
+      CHECK_EQ(next->error(), make_error_code(std::errc::bad_message));
+    }
+  });
+}
+
 TEST_SUITE_END();
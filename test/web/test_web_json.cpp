@@ -46,6 +46,15 @@ tag_invoke(const boost::json::try_value_to_tag<user_t>&,
   return make_error_code(boost::json::error::incomplete);
 }
 
+struct profile_t {
+  std::string name;
+  int age;
+  optional<double> height;
+  bool verified;
+
+  friend bool operator==(const profile_t&, const profile_t&) = default;
+};
+
 }
 
 TEST_CASE("as_json")
@@ -76,4 +85,72 @@ TEST_CASE("as_json")
   }
 }
 
+TEST_CASE("as_json: aggregate without tag_invoke")
+{
+  static_assert(json_direct_decodable<profile_t>);
+  static_assert(json_direct_encodable<profile_t>);
+  static_assert(!json_direct_decodable<user_t>);
+
+  CHECK_EQ(
+      as_json<profile_t>(
+          R"del({ "name": "Rina \"Hidaka\"", "age": 30, "extra": [1, { "a": 2 }], "height": 157.5, "verified": true })del"),
+      profile_t {
+          .name = R"(Rina "Hidaka")",
+          .age = 30,
+          .height = 157.5,
+          .verified = true,
+      });
+  CHECK_EQ(as_json<profile_t>(
+               R"del({ "name": "Rina Hidaka", "age": 30, "verified": false })del"),
+           profile_t {
+               .name = "Rina Hidaka",
+               .age = 30,
+               .height = nullopt,
+               .verified = false,
+           });
+  CHECK_EQ(as_json<profile_t>(R"del({ "name": "Rina Hidaka", "age": 30 })del")
+               .error(),
+           make_error_code(error::extractor_field_name_not_found));
+  CHECK_EQ(
+      as_json<profile_t>(
+          R"del({ "name": "Rina Hidaka", "age": "30", "verified": true })del")
+          .error(),
+      make_error_code(boost::json::error::not_integer));
+  CHECK_EQ(
+      as_json<profile_t>(
+          R"del({ "name": "Rina Hidaka", "age": 1e3, "verified": true })del")
+          .error(),
+      make_error_code(boost::json::error::not_integer));
+  CHECK_EQ(as_json<profile_t>("[]").error(),
+           make_error_code(boost::json::error::not_object));
+  CHECK_EQ(as_json<profile_t>("{").error(),
+           make_error_code(boost::json::error::incomplete));
+  CHECK_EQ(as_json<profile_t>("{} {}").error(),
+           make_error_code(boost::json::error::extra_data));
+}
+
+TEST_CASE("json_encode: aggregate without tag_invoke")
+{
+  const auto profile = profile_t {
+    .name = "Rina \"Hidaka\"\n",
+    .age = 30,
+    .height = nullopt,
+    .verified = true,
+  };
+
+  auto text = std::string();
+  json_encode(profile, text);
+  CHECK_EQ(
+      text,
+      R"({"name":"Rina \"Hidaka\"\n","age":30,"height":null,"verified":true})");
+  CHECK_EQ(boost::json::parse(text),
+           boost::json::value {
+               { "name", "Rina \"Hidaka\"\n" },
+               { "age", 30 },
+               { "height", nullptr },
+               { "verified", true },
+           });
+  CHECK_EQ(as_json<profile_t>(text), profile);
+}
+
 TEST_SUITE_END();
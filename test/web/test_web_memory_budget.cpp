@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <fitoria/test/test.hpp>
+
+#if defined(FITORIA_HAS_LIBURING)
+#define BOOST_ASIO_HAS_IO_URING
+#endif
+
+#include <fitoria/test/http_server_utils.hpp>
+#include <fitoria/test/utility.hpp>
+
+#include <fitoria/web.hpp>
+
+using namespace fitoria;
+using namespace fitoria::web;
+using namespace fitoria::test;
+
+TEST_SUITE_BEGIN("[fitoria.web.memory_budget]");
+
+TEST_CASE("account")
+{
+  auto budget = std::make_shared<memory_budget>(100);
+  CHECK_EQ(budget->limit(), 100);
+  CHECK_EQ(budget->usage(), 0);
+  {
+    auto a1 = memory_budget::account(budget);
+    auto a2 = memory_budget::account(budget);
+    a1.charge(60);
+    a2.charge(30);
+    CHECK_EQ(budget->usage(), 90);
+    CHECK(!budget->exceeded());
+
+    a2.update(50);
+    CHECK_EQ(a2.balance(), 50);
+    CHECK_EQ(budget->usage(), 110);
+    CHECK(budget->exceeded());
+
+    a1.credit(100);
+    CHECK_EQ(a1.balance(), 0);
+    CHECK_EQ(budget->usage(), 50);
+
+    a1.update(10);
+    CHECK_EQ(budget->usage(), 60);
+  }
+  CHECK_EQ(budget->usage(), 0);
+}
+
+TEST_CASE("async_wait_available")
+{
+  sync_wait([]() -> awaitable<void> {
+    auto budget = std::make_shared<memory_budget>(
+        100, std::chrono::milliseconds(50));
+    co_await budget->async_wait_available();
+
+    // the pause is bounded
+    budget->charge(200);
+    auto start = std::chrono::steady_clock::now();
+    co_await budget->async_wait_available();
+    CHECK_GE(std::chrono::steady_clock::now() - start,
+             std::chrono::milliseconds(50));
+
+    budget->credit(200);
+
+    // pauses until the usage drops, however long it takes
+    budget = std::make_shared<memory_budget>(100, nullopt);
+    budget->charge(200);
+    start = std::chrono::steady_clock::now();
+    net::co_spawn(
+        co_await net::this_coro::executor,
+        [](std::shared_ptr<memory_budget> budget) -> awaitable<void> {
+          auto timer = net::steady_timer(co_await net::this_coro::executor);
+          timer.expires_after(std::chrono::milliseconds(100));
+          co_await timer.async_wait(use_awaitable);
+          budget->credit(150);
+        }(budget),
+        net::detached);
+    co_await budget->async_wait_available();
+    CHECK(!budget->exceeded());
+    CHECK_GE(std::chrono::steady_clock::now() - start,
+             std::chrono::milliseconds(100));
+  });
+}
+
+TEST_CASE("http_server with memory_budget")
+{
+  const auto body = get_random_string(4096);
+  auto budget = std::make_shared<memory_budget>(1024 * 1024);
+
+  auto ioc = net::io_context();
+  auto server = http_server::builder(ioc)
+                    .set_memory_budget(budget)
+                    .serve(route::post<"/">(
+                        [&](std::string data) -> awaitable<response> {
+                          CHECK_EQ(data, body);
+                          // only the connection buffer is still charged
+                          CHECK_GT(budget->usage(), 0);
+                          co_return response::ok().set_body(data);
+                        }))
+                    .build();
+
+  server.serve_request("/",
+                       test_request::post().set_body(body),
+                       [&](test_response res) -> awaitable<void> {
+                         CHECK_EQ(res.status(), http::status::ok);
+                         CHECK_EQ(co_await res.as_string(), body);
+                       });
+
+  ioc.run();
+  CHECK_EQ(budget->usage(), 0);
+}
+
+#if defined(BOOST_ASIO_HAS_FILE)
+
+TEST_CASE("http_server with memory_budget: spilled request body")
+{
+  const auto body = get_random_string(1048576);
+  auto budget = std::make_shared<memory_budget>(256 * 1024, nullopt);
+
+  auto ioc = net::io_context();
+  auto server
+      = http_server::builder(ioc)
+            .set_memory_budget(budget)
+            .set_request_body_spill_threshold(4096)
+            .serve(route::post<"/">([&](request& req) -> awaitable<response> {
+              // the body is larger than the limit, but only a single buffer of
+              // it is held at a time before it is spilled to a file
+              REQUIRE(req.body().target<async_readable_file_stream>());
+              CHECK_LE(budget->usage(), budget->limit());
+              CHECK_EQ(co_await async_read_until_eof<std::string>(req.body()),
+                       body);
+              co_return response::ok().build();
+            }))
+            .build();
+
+  server.serve_request("/",
+                       test_request::post().set_body(body),
+                       [&](test_response res) -> awaitable<void> {
+                         CHECK_EQ(res.status(), http::status::ok);
+                         CHECK(!budget->exceeded());
+                         co_return;
+                       });
+
+  ioc.run();
+  CHECK_EQ(budget->usage(), 0);
+}
+
+#endif
+
+TEST_SUITE_END();
@@ -0,0 +1,272 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <fitoria/test/test.hpp>
+
+#if defined(FITORIA_HAS_LIBURING)
+#define BOOST_ASIO_HAS_IO_URING
+#endif
+
+#include <fitoria/test/http_server_utils.hpp>
+#include <fitoria/test/utility.hpp>
+
+#include <fitoria/web.hpp>
+
+#include <fstream>
+
+using namespace fitoria;
+using namespace fitoria::web;
+using namespace fitoria::test;
+
+TEST_SUITE_BEGIN("[fitoria.web.open_file_cache]");
+
+#if defined(BOOST_ASIO_HAS_FILE)
+
+namespace {
+
+auto make_server(net::io_context& ioc,
+                 std::shared_ptr<open_file_cache> cache,
+                 const std::string& file_path)
+{
+  return http_server::builder(ioc)
+      .serve(route::get<"/">(
+          [cache, file_path](const request& req) -> awaitable<response> {
+            if (auto res = cache->open(
+                    co_await net::this_coro::executor, file_path, req);
+                res) {
+              co_return std::move(*res);
+            }
+
+            co_return response::not_found().build();
+          }))
+      .build();
+}
+
+}
+
+TEST_CASE("requests share the open file")
+{
+  const auto file_path = get_temp_file_path();
+  const auto data = get_random_string(1048576);
+  {
+    std::ofstream(file_path, std::ios::binary) << data;
+  }
+  const auto lmd_str
+      = http::header::date(std::filesystem::last_write_time(file_path))
+            .to_string();
+
+  auto cache = open_file_cache::builder().build();
+  auto ioc = net::io_context();
+  auto server = make_server(ioc, cache, file_path);
+
+  server.serve_request(
+      "/",
+      test_request::get().build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::last_modified), lmd_str);
+        CHECK_EQ(res.headers().get(http::field::content_type),
+                 mime::application_octet_stream());
+        CHECK_EQ(res.headers().get(http::field::accept_ranges), "bytes");
+        CHECK_EQ(co_await res.as_string(), data);
+      });
+  ioc.run();
+  CHECK_EQ(cache->size(), 1);
+
+  // the responses are read at their own offsets at the same time
+  ioc.restart();
+  auto etag_str = std::string();
+  server.serve_request(
+      "/",
+      test_request::get().build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        etag_str = res.headers().get(http::field::etag).value_or("");
+        CHECK_EQ(co_await res.as_string(), data);
+      });
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::range, "bytes=100000-299999")
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::partial_content);
+        CHECK_EQ(res.headers().get(http::field::content_range),
+                 "bytes 100000-299999/1048576");
+        CHECK_EQ(co_await res.as_string(),
+                 std::string_view(data).substr(100000, 200000));
+      });
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::range, "bytes=0-9,100000-100009")
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK(!res.headers().get(http::field::content_range));
+        CHECK_EQ(co_await res.as_string(), data);
+      });
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::range, "bytes=900000-")
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::partial_content);
+        CHECK_EQ(co_await res.as_string(),
+                 std::string_view(data).substr(900000));
+      });
+  ioc.run();
+  CHECK_EQ(cache->size(), 1);
+
+  ioc.restart();
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::if_none_match, etag_str)
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::not_modified);
+        CHECK_EQ(res.headers().get(http::field::etag), etag_str);
+        co_return;
+      });
+  ioc.run();
+
+  cache->erase(file_path);
+  CHECK_EQ(cache->size(), 0);
+}
+
+TEST_CASE("responses read the file on their own executor")
+{
+  const auto file_path = get_temp_file_path();
+  const auto data = get_random_string(1048576);
+  {
+    std::ofstream(file_path, std::ios::binary) << data;
+  }
+
+  auto cache = open_file_cache::builder().build();
+  auto serve = [&]() {
+    auto ioc = net::io_context();
+    auto server = make_server(ioc, cache, file_path);
+    server.serve_request(
+        "/",
+        test_request::get().build(),
+        [&](test_response res) -> awaitable<void> {
+          CHECK_EQ(res.status(), http::status::ok);
+          CHECK_EQ(co_await res.as_string(), data);
+        });
+    ioc.run();
+  };
+
+  // the cached descriptor outlives the io_context which opened it
+  serve();
+  serve();
+  CHECK_EQ(cache->size(), 1);
+}
+
+TEST_CASE("changed file is reopened after the validity window")
+{
+  const auto file_path = get_temp_file_path();
+  {
+    std::ofstream(file_path, std::ios::binary) << "old";
+  }
+
+  auto cache
+      = open_file_cache::builder().set_valid(std::chrono::seconds(0)).build();
+  auto ioc = net::io_context();
+  auto server = make_server(ioc, cache, file_path);
+
+  server.serve_request(
+      "/",
+      test_request::get().build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(co_await res.as_string(), "old");
+      });
+  ioc.run();
+
+  // replace the file, the cached descriptor still refers to the old one
+  std::filesystem::remove(file_path);
+  {
+    std::ofstream(file_path, std::ios::binary) << "new content";
+  }
+  ioc.restart();
+  server.serve_request(
+      "/",
+      test_request::get().build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(co_await res.as_string(), "new content");
+      });
+  ioc.run();
+  CHECK_EQ(cache->size(), 1);
+}
+
+TEST_CASE("least recently used files are closed")
+{
+  auto cache = open_file_cache::builder().set_max_files(2).build();
+
+  auto serve = [&](const std::string& file_path) {
+    {
+      std::ofstream(file_path, std::ios::binary) << file_path;
+    }
+    auto ioc = net::io_context();
+    auto server = make_server(ioc, cache, file_path);
+    server.serve_request(
+        "/",
+        test_request::get().build(),
+        [&file_path](test_response res) -> awaitable<void> {
+          CHECK_EQ(co_await res.as_string(), file_path);
+        });
+    ioc.run();
+  };
+
+  serve(get_temp_file_path());
+  serve(get_temp_file_path());
+  serve(get_temp_file_path());
+  CHECK_EQ(cache->size(), 2);
+
+  cache->clear();
+  CHECK_EQ(cache->size(), 0);
+}
+
+TEST_CASE("static_file_cache serves large files with open_file_cache")
+{
+  const auto file_path = get_temp_file_path();
+  const auto data = get_random_string(4096);
+  {
+    std::ofstream(file_path, std::ios::binary) << data;
+  }
+
+  auto open_files = open_file_cache::builder().build();
+  auto cache = static_file_cache::builder()
+                   .set_max_file_size(1024)
+                   .set_open_file_cache(open_files)
+                   .build();
+  auto ioc = net::io_context();
+  auto server
+      = http_server::builder(ioc)
+            .serve(route::get<"/">(
+                [&](const request& req) -> awaitable<response> {
+                  co_return *(co_await cache->async_open(
+                      co_await net::this_coro::executor, file_path, req));
+                }))
+            .build();
+
+  server.serve_request(
+      "/",
+      test_request::get().build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(co_await res.as_string(), data);
+      });
+  ioc.run();
+  CHECK_EQ(cache->size(), 0);
+  CHECK_EQ(open_files->size(), 1);
+}
+
+#endif
+
+TEST_SUITE_END();
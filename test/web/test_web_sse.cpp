@@ -0,0 +1,211 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <fitoria/test/test.hpp>
+
+#include <fitoria/test/http_server_utils.hpp>
+
+#include <fitoria/web/sse.hpp>
+
+using namespace fitoria;
+using namespace fitoria::web;
+using namespace fitoria::test;
+
+TEST_SUITE_BEGIN("[fitoria.web.sse]");
+
+namespace {
+
+auto read_string(sse_stream& stream) -> awaitable<optional<std::string>>
+{
+  auto data = co_await stream.async_read_some();
+  if (!data || !*data) {
+    co_return nullopt;
+  }
+
+  co_return std::string(reinterpret_cast<const char*>((*data)->data()),
+                        (*data)->size());
+}
+
+}
+
+TEST_CASE("format_sse_event")
+{
+  auto format = [](const sse_event& ev) {
+    auto out = detail::format_sse_event(ev);
+    return std::string(reinterpret_cast<const char*>(out.data()), out.size());
+  };
+
+  CHECK_EQ(format(sse_event { .data = "hello" }), "data: hello\n\n");
+  CHECK_EQ(format(sse_event { .data = "" }), "data: \n\n");
+  CHECK_EQ(format(sse_event { .data = "a\nb\n" }),
+           "data: a\ndata: b\ndata: \n\n");
+  CHECK_EQ(format(sse_event { .data = "a\r\nb\rc\n\rd" }),
+           "data: a\ndata: b\ndata: c\ndata: \ndata: d\n\n");
+  CHECK_EQ(format(sse_event { .id = "1\r\ndata: x",
+                              .event = "e\nid: 2\r",
+                              .data = "y" }),
+           "id: 1data: x\nevent: eid: 2\ndata: y\n\n");
+  CHECK_EQ(format(sse_event { .id = "7",
+                              .event = "update",
+                              .data = "x",
+                              .retry = std::chrono::milliseconds(3000) }),
+           "id: 7\nevent: update\nretry: 3000\ndata: x\n\n");
+}
+
+TEST_CASE("sse_broadcaster: publish to subscribers")
+{
+  sync_wait([]() -> awaitable<void> {
+    auto ex = co_await net::this_coro::executor;
+    auto broadcaster = sse_broadcaster::builder().build();
+    auto s1 = broadcaster->subscribe(ex);
+    auto s2 = broadcaster->subscribe(ex);
+    CHECK_EQ(broadcaster->subscriber_count(), 2);
+
+    broadcaster->publish({ .data = "a" });
+    broadcaster->publish({ .event = "e", .data = "b" });
+
+    for (auto* s : { &s1, &s2 }) {
+      CHECK_EQ(co_await read_string(*s), "id: 1\ndata: a\n\n");
+      CHECK_EQ(co_await read_string(*s), "id: 2\nevent: e\ndata: b\n\n");
+      // a flush is requested before waiting for the next event
+      CHECK_EQ(co_await read_string(*s), "");
+    }
+
+    {
+      auto s3 = broadcaster->subscribe(ex);
+      CHECK_EQ(broadcaster->subscriber_count(), 3);
+    }
+    CHECK_EQ(broadcaster->subscriber_count(), 2);
+  });
+}
+
+TEST_CASE("sse_broadcaster: replay after Last-Event-ID")
+{
+  sync_wait([]() -> awaitable<void> {
+    auto ex = co_await net::this_coro::executor;
+    auto broadcaster = sse_broadcaster::builder().set_history_size(2).build();
+    broadcaster->publish({ .data = "a" });
+    broadcaster->publish({ .data = "b" });
+    broadcaster->publish({ .data = "c" });
+
+    auto s1 = broadcaster->subscribe(ex, "2");
+    CHECK_EQ(co_await read_string(s1), "id: 3\ndata: c\n\n");
+    CHECK_EQ(co_await read_string(s1), "");
+
+    // unknown id, nothing to replay
+    auto s2 = broadcaster->subscribe(ex, "1");
+    broadcaster->publish({ .data = "d" });
+    CHECK_EQ(co_await read_string(s2), "id: 4\ndata: d\n\n");
+  });
+}
+
+TEST_CASE("sse_broadcaster: overflow policy drop_oldest")
+{
+  sync_wait([]() -> awaitable<void> {
+    auto ex = co_await net::this_coro::executor;
+    auto broadcaster
+        = sse_broadcaster::builder()
+              .set_max_queue_size(2)
+              .set_overflow_policy(sse_overflow_policy::drop_oldest)
+              .build();
+    auto stream = broadcaster->subscribe(ex);
+    broadcaster->publish({ .data = "a" });
+    broadcaster->publish({ .data = "b" });
+    broadcaster->publish({ .data = "c" });
+
+    CHECK_EQ(co_await read_string(stream), "id: 2\ndata: b\n\n");
+    CHECK_EQ(co_await read_string(stream), "id: 3\ndata: c\n\n");
+    CHECK_EQ(broadcaster->subscriber_count(), 1);
+  });
+}
+
+TEST_CASE("sse_broadcaster: overflow policy disconnect")
+{
+  sync_wait([]() -> awaitable<void> {
+    auto ex = co_await net::this_coro::executor;
+    auto broadcaster
+        = sse_broadcaster::builder()
+              .set_max_queue_size(2)
+              .set_overflow_policy(sse_overflow_policy::disconnect)
+              .build();
+    auto stream = broadcaster->subscribe(ex);
+    broadcaster->publish({ .data = "a" });
+    broadcaster->publish({ .data = "b" });
+    broadcaster->publish({ .data = "c" });
+    CHECK_EQ(broadcaster->subscriber_count(), 0);
+
+    CHECK_EQ(co_await read_string(stream), "id: 1\ndata: a\n\n");
+    CHECK_EQ(co_await read_string(stream), "id: 2\ndata: b\n\n");
+    CHECK(!(co_await stream.async_read_some()));
+  });
+}
+
+TEST_CASE("sse_stream: keep-alive")
+{
+  sync_wait([]() -> awaitable<void> {
+    auto ex = co_await net::this_coro::executor;
+    auto broadcaster
+        = sse_broadcaster::builder()
+              .set_keep_alive_interval(std::chrono::milliseconds(10))
+              .build();
+    auto stream = broadcaster->subscribe(ex);
+    CHECK_EQ(co_await read_string(stream), ": keep-alive\n\n");
+    CHECK_EQ(co_await read_string(stream), "");
+  });
+}
+
+TEST_CASE("sse_stream: keep-alive does not drop events")
+{
+  sync_wait([]() -> awaitable<void> {
+    auto ex = co_await net::this_coro::executor;
+    auto broadcaster
+        = sse_broadcaster::builder()
+              .set_keep_alive_interval(std::chrono::milliseconds(1))
+              .build();
+    auto stream = broadcaster->subscribe(ex);
+
+    net::co_spawn(
+        ex,
+        [](std::shared_ptr<sse_broadcaster> broadcaster) -> awaitable<void> {
+          // publish around the keep-alive interval
+          auto timer = net::steady_timer(co_await net::this_coro::executor);
+          for (int i = 0; i < 50; ++i) {
+            timer.expires_after(std::chrono::microseconds(500 * (i % 4)));
+            CHECK(co_await timer.async_wait(use_awaitable));
+            broadcaster->publish({ .data = std::to_string(i) });
+          }
+        }(broadcaster),
+        net::detached);
+
+    for (int i = 0; i < 50;) {
+      auto data = co_await read_string(stream);
+      REQUIRE(data);
+      if (data->empty() || *data == ": keep-alive\n\n") {
+        continue;
+      }
+      CHECK_EQ(*data,
+               "id: " + std::to_string(i + 1) + "\ndata: " + std::to_string(i)
+                   + "\n\n");
+      ++i;
+    }
+  });
+}
+
+TEST_CASE("sse_stream: to_response")
+{
+  sync_wait([]() -> awaitable<void> {
+    auto broadcaster = sse_broadcaster::builder().build();
+    auto res = to_response(
+        broadcaster->subscribe(co_await net::this_coro::executor));
+    CHECK_EQ(res.status(), http::status::ok);
+    CHECK_EQ(res.headers().get(http::field::content_type),
+             mime::text_event_stream());
+    CHECK_EQ(res.headers().get(http::field::cache_control), "no-cache");
+  });
+}
+
+TEST_SUITE_END();
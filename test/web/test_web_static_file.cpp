@@ -233,6 +233,7 @@ TEST_CASE("open with request header: range")
           .set_header(http::field::range, "bytes=100000-299999, 300000-399999")
           .build(),
       [&](test_response res) -> awaitable<void> {
+        // adjacent ranges are coalesced into one
         CHECK_EQ(res.status(), http::status::partial_content);
         CHECK_EQ(res.headers().get(http::field::last_modified), lmd_str);
         CHECK_EQ(res.headers().get(http::field::etag), etag_str);
@@ -241,9 +242,9 @@ TEST_CASE("open with request header: range")
         CHECK_EQ(res.headers().get(http::field::content_disposition), cd_str);
         CHECK_EQ(res.headers().get(http::field::accept_ranges), "bytes");
         CHECK_EQ(res.headers().get(http::field::content_range),
-                 "bytes 100000-299999/200000");
+                 "bytes 100000-399999/1048576");
         CHECK_EQ(co_await res.as_string(),
-                 std::string_view(data).substr(100000, 200000));
+                 std::string_view(data).substr(100000, 300000));
         co_return;
       });
   server.serve_request(
@@ -260,7 +261,7 @@ TEST_CASE("open with request header: range")
         CHECK_EQ(res.headers().get(http::field::content_disposition), cd_str);
         CHECK_EQ(res.headers().get(http::field::accept_ranges), "bytes");
         CHECK_EQ(res.headers().get(http::field::content_range),
-                 "bytes 900000-1048575/148576");
+                 "bytes 900000-1048575/1048576");
         CHECK_EQ(co_await res.as_string(),
                  std::string_view(data).substr(900000, 148576));
         co_return;
@@ -297,6 +298,72 @@ TEST_CASE("open with request header: range")
   ioc.run();
 }
 
+TEST_CASE("open with request header: multiple ranges")
+{
+  const auto file_path = get_temp_file_path("txt");
+  const auto data = get_random_string(1000);
+  {
+    std::ofstream(file_path, std::ios::binary) << data;
+  }
+
+  auto ioc = net::io_context();
+  auto server
+      = http_server::builder(ioc)
+            .serve(route::get<"/">(
+                [&file_path](const request& req)
+                    -> awaitable<std::variant<static_file, response>> {
+                  if (auto file = static_file::open(
+                          co_await net::this_coro::executor, file_path, req);
+                      file) {
+                    co_return std::move(*file);
+                  }
+
+                  co_return response::not_found().build();
+                }))
+            .build();
+
+  server.serve_request(
+      "/",
+      test_request::get().set_header(http::field::range, "bytes=0-9").build(),
+      [&](test_response res) -> awaitable<void> {
+        // the complete length is the size of the file, the same as in the
+        // parts of a multipart body
+        CHECK_EQ(res.status(), http::status::partial_content);
+        CHECK_EQ(res.headers().get(http::field::content_range),
+                 "bytes 0-9/1000");
+        CHECK_EQ(co_await res.as_string(),
+                 std::string_view(data).substr(0, 10));
+      });
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::range, "bytes=500-599, 0-9, 5-19, 2000-")
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::partial_content);
+        CHECK(!res.headers().get(http::field::content_range));
+        auto ct = res.headers().get(http::field::content_type);
+        REQUIRE(ct);
+        const auto prefix = std::string_view("multipart/byteranges; boundary=");
+        REQUIRE(ct->starts_with(prefix));
+        const auto boundary = ct->substr(prefix.size());
+        const auto expected = fmt::format(
+            "--{0}\r\nContent-Type: text/plain\r\n"
+            "Content-Range: bytes 0-19/1000\r\n\r\n{1}"
+            "\r\n--{0}\r\nContent-Type: text/plain\r\n"
+            "Content-Range: bytes 500-599/1000\r\n\r\n{2}"
+            "\r\n--{0}--\r\n",
+            boundary,
+            std::string_view(data).substr(0, 20),
+            std::string_view(data).substr(500, 100));
+        CHECK_EQ(res.headers().get(http::field::content_length),
+                 std::to_string(expected.size()));
+        CHECK_EQ(co_await res.as_string(), expected);
+      });
+
+  ioc.run();
+}
+
 TEST_CASE("open with request header: if_none_match")
 {
   const auto file_path = get_temp_file_path();
@@ -397,6 +464,122 @@ TEST_CASE("open with request header: if_none_match")
   ioc.run();
 }
 
+TEST_CASE("open with request header: accept_encoding")
+{
+  const auto file_path = get_temp_file_path("js");
+  const auto data = get_random_string(1024);
+  const auto br_data = get_random_string(100);
+  const auto gz_data = get_random_string(200);
+  {
+    std::ofstream(file_path, std::ios::binary) << data;
+    std::ofstream(file_path + ".br", std::ios::binary) << br_data;
+    std::ofstream(file_path + ".gz", std::ios::binary) << gz_data;
+  }
+  const auto etag_str = get_etag(data.size(),
+                                 std::filesystem::last_write_time(file_path))
+                            .to_string();
+
+  auto ioc = net::io_context();
+  auto server
+      = http_server::builder(ioc)
+            .serve(route::get<"/">(
+                [&file_path](const request& req)
+                    -> awaitable<std::variant<static_file, response>> {
+                  if (auto file = static_file::open(
+                          co_await net::this_coro::executor, file_path, req);
+                      file) {
+                    co_return std::move(*file);
+                  }
+
+                  co_return response::not_found().build();
+                }))
+            .build();
+
+  server.serve_request(
+      "/",
+      test_request::get().build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::etag), etag_str);
+        CHECK(!res.headers().get(http::field::content_encoding));
+        CHECK(!res.headers().get(http::field::vary));
+        CHECK_EQ(co_await res.as_string(), data);
+      });
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "gzip, deflate, br")
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::content_type),
+                 mime::application_javascript());
+        CHECK_EQ(res.headers().get(http::field::content_encoding), "br");
+        CHECK_EQ(res.headers().get(http::field::vary), "Accept-Encoding");
+        CHECK(res.headers().get(http::field::etag)->ends_with(R"(-br")"));
+        CHECK_EQ(co_await res.as_string(), br_data);
+      });
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "br;q=0.5, gzip")
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::content_encoding), "gzip");
+        CHECK(res.headers().get(http::field::etag)->ends_with(R"(-gzip")"));
+        CHECK_EQ(co_await res.as_string(), gz_data);
+      });
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "zstd, br;q=0")
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::etag), etag_str);
+        CHECK(!res.headers().get(http::field::content_encoding));
+        CHECK_EQ(co_await res.as_string(), data);
+      });
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "br")
+          .set_header(http::field::range, "bytes=10-19")
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::partial_content);
+        CHECK_EQ(res.headers().get(http::field::content_encoding), "br");
+        CHECK_EQ(res.headers().get(http::field::vary), "Accept-Encoding");
+        CHECK_EQ(co_await res.as_string(),
+                 std::string_view(br_data).substr(10, 10));
+      });
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "br")
+          .set_header(http::field::range, "bytes=100-199")
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::range_not_satisfiable);
+        CHECK_EQ(res.headers().get(http::field::content_range), "bytes */100");
+        co_return;
+      });
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::accept_encoding, "br")
+          .set_header(http::field::if_none_match, etag_str)
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        // the ETag of the raw file does not match the brotli one
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(co_await res.as_string(), br_data);
+      });
+
+  ioc.run();
+}
+
 #if defined(FITORIA_HAS_STD_CHRONO_PARSE)
 
 TEST_CASE("open with request header: if_modified_since")
@@ -0,0 +1,255 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <fitoria/test/test.hpp>
+
+#if defined(FITORIA_HAS_LIBURING)
+#define BOOST_ASIO_HAS_IO_URING
+#endif
+
+#include <fitoria/test/http_server_utils.hpp>
+#include <fitoria/test/utility.hpp>
+
+#include <fitoria/web.hpp>
+
+#include <fstream>
+
+using namespace fitoria;
+using namespace fitoria::web;
+using namespace fitoria::test;
+
+TEST_SUITE_BEGIN("[fitoria.web.static_file_cache]");
+
+#if defined(BOOST_ASIO_HAS_FILE)
+
+namespace {
+
+auto make_server(net::io_context& ioc,
+                 std::shared_ptr<static_file_cache> cache,
+                 const std::string& file_path)
+{
+  return http_server::builder(ioc)
+      .serve(route::get<"/">(
+          [cache, file_path](const request& req) -> awaitable<response> {
+            if (auto res = co_await cache->async_open(
+                    co_await net::this_coro::executor, file_path, req);
+                res) {
+              co_return std::move(*res);
+            }
+
+            co_return response::not_found().build();
+          }))
+      .build();
+}
+
+}
+
+TEST_CASE("hit is served from memory")
+{
+  const auto file_path = get_temp_file_path("txt");
+  const auto data = get_random_string(1024);
+  {
+    std::ofstream(file_path, std::ios::binary) << data;
+  }
+  const auto lmd_str
+      = http::header::date(std::filesystem::last_write_time(file_path))
+            .to_string();
+
+  auto cache = static_file_cache::builder()
+                   .set_check_interval(std::chrono::hours(1))
+                   .build();
+  auto ioc = net::io_context();
+  auto server = make_server(ioc, cache, file_path);
+
+  auto etag_str = std::string();
+  server.serve_request(
+      "/",
+      test_request::get().build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::last_modified), lmd_str);
+        CHECK_EQ(res.headers().get(http::field::content_type),
+                 mime::text_plain());
+        CHECK_EQ(res.headers().get(http::field::content_disposition),
+                 "inline");
+        CHECK_EQ(res.headers().get(http::field::accept_ranges), "bytes");
+        etag_str = res.headers().get(http::field::etag).value_or("");
+        CHECK_EQ(co_await res.as_string(), data);
+      });
+  ioc.run();
+  CHECK_EQ(cache->size(), 1);
+  CHECK_EQ(cache->total_size(), data.size());
+
+  // the file is not looked at again within the check interval
+  {
+    std::ofstream(file_path, std::ios::binary) << "changed";
+  }
+  ioc.restart();
+  server.serve_request(
+      "/",
+      test_request::get().build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::etag), etag_str);
+        CHECK_EQ(co_await res.as_string(), data);
+      });
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::range, "bytes=100-199")
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::partial_content);
+        CHECK_EQ(res.headers().get(http::field::content_range),
+                 "bytes 100-199/1024");
+        CHECK_EQ(res.headers().get(http::field::content_length), "100");
+        CHECK_EQ(co_await res.as_string(),
+                 std::string_view(data).substr(100, 100));
+      });
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::range, "bytes=100-149,150-199")
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::partial_content);
+        CHECK_EQ(res.headers().get(http::field::content_range),
+                 "bytes 100-199/1024");
+        CHECK_EQ(co_await res.as_string(),
+                 std::string_view(data).substr(100, 100));
+      });
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::range, "bytes=0-9,100-199")
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK(!res.headers().get(http::field::content_range));
+        CHECK_EQ(co_await res.as_string(), data);
+      });
+  server.serve_request(
+      "/",
+      test_request::get().set_header(http::field::range, "bytes=2000-").build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::range_not_satisfiable);
+        CHECK_EQ(res.headers().get(http::field::content_range),
+                 "bytes */1024");
+        co_return;
+      });
+  server.serve_request(
+      "/",
+      test_request::get()
+          .set_header(http::field::if_none_match, etag_str)
+          .build(),
+      [&](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::not_modified);
+        CHECK_EQ(res.headers().get(http::field::etag), etag_str);
+        co_return;
+      });
+  ioc.run();
+
+  cache->erase(file_path);
+  CHECK_EQ(cache->size(), 0);
+  CHECK_EQ(cache->total_size(), 0);
+}
+
+TEST_CASE("changed file is reloaded after the check interval")
+{
+  const auto file_path = get_temp_file_path("txt");
+  {
+    std::ofstream(file_path, std::ios::binary) << "old";
+  }
+
+  auto cache = static_file_cache::builder()
+                   .set_check_interval(std::chrono::seconds(0))
+                   .build();
+  auto ioc = net::io_context();
+  auto server = make_server(ioc, cache, file_path);
+
+  server.serve_request(
+      "/",
+      test_request::get().build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(co_await res.as_string(), "old");
+      });
+  ioc.run();
+
+  {
+    std::ofstream(file_path, std::ios::binary) << "new content";
+  }
+  ioc.restart();
+  server.serve_request(
+      "/",
+      test_request::get().build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(co_await res.as_string(), "new content");
+      });
+  ioc.run();
+  CHECK_EQ(cache->size(), 1);
+  CHECK_EQ(cache->total_size(), 11);
+
+  std::filesystem::remove(file_path);
+  ioc.restart();
+  server.serve_request(
+      "/",
+      test_request::get().build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::not_found);
+        co_return;
+      });
+  ioc.run();
+  CHECK_EQ(cache->size(), 0);
+}
+
+TEST_CASE("least recently used files are evicted")
+{
+  auto cache = static_file_cache::builder()
+                   .set_max_size(2048)
+                   .set_max_file_size(1024)
+                   .build();
+
+  auto serve = [&](const std::string& file_path, std::size_t size) {
+    {
+      std::ofstream(file_path, std::ios::binary) << get_random_string(size);
+    }
+    auto ioc = net::io_context();
+    auto server = make_server(ioc, cache, file_path);
+    server.serve_request(
+        "/",
+        test_request::get().build(),
+        [size](test_response res) -> awaitable<void> {
+          CHECK_EQ(res.status(), http::status::ok);
+          CHECK_EQ((co_await res.as_string())->size(), size);
+        });
+    ioc.run();
+  };
+
+  const auto p1 = get_temp_file_path();
+  const auto p2 = get_temp_file_path();
+  const auto p3 = get_temp_file_path();
+  serve(p1, 1000);
+  serve(p2, 1000);
+  CHECK_EQ(cache->size(), 2);
+  CHECK_EQ(cache->total_size(), 2000);
+
+  serve(p3, 1000);
+  CHECK_EQ(cache->size(), 2);
+  CHECK_EQ(cache->total_size(), 2000);
+
+  // too large to be cached, served by static_file instead
+  serve(get_temp_file_path(), 4096);
+  CHECK_EQ(cache->size(), 2);
+
+  cache->clear();
+  CHECK_EQ(cache->size(), 0);
+  CHECK_EQ(cache->total_size(), 0);
+}
+
+#endif
+
+TEST_SUITE_END();
@@ -0,0 +1,173 @@
+//
+// Copyright (c) 2024 Ramirisu (labyrinth.ramirisu@gmail.com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include <fitoria/test/test.hpp>
+
+#if defined(FITORIA_HAS_LIBURING)
+#define BOOST_ASIO_HAS_IO_URING
+#endif
+
+#include <fitoria/test/http_server_utils.hpp>
+#include <fitoria/test/utility.hpp>
+
+#include <fitoria/web.hpp>
+
+#include <fstream>
+
+using namespace fitoria;
+using namespace fitoria::web;
+using namespace fitoria::test;
+
+TEST_SUITE_BEGIN("[fitoria.web.static_files]");
+
+#if defined(BOOST_ASIO_HAS_FILE)
+
+namespace {
+
+auto make_root() -> std::filesystem::path
+{
+  auto root = std::filesystem::path(get_temp_file_path("dir"));
+  std::filesystem::create_directories(root / "sub");
+  std::ofstream(root / "index.html", std::ios::binary) << "root index";
+  std::ofstream(root / "a.txt", std::ios::binary) << "a";
+  std::ofstream(root / "sub" / "index.html", std::ios::binary) << "sub index";
+  std::ofstream(root / "sub" / "b.css", std::ios::binary) << "b";
+  return root;
+}
+
+auto make_server(net::io_context& ioc, static_files files)
+{
+  return http_server::builder(ioc)
+      .serve(scope<"/assets">().serve(route::get<"/#path">(std::move(files))))
+      .build();
+}
+
+}
+
+TEST_CASE("serve files beneath the root")
+{
+  const auto root = make_root();
+  auto files = static_files::builder(root.string()).build();
+  REQUIRE(files);
+
+  auto ioc = net::io_context();
+  auto server = make_server(ioc, *files);
+
+  auto expect = [&](std::string path, std::string body, mime::mime_view ct) {
+    server.serve_request(
+        std::move(path),
+        test_request::get().build(),
+        [body, ct](test_response res) -> awaitable<void> {
+          CHECK_EQ(res.status(), http::status::ok);
+          CHECK_EQ(res.headers().get(http::field::content_type), ct);
+          CHECK_EQ(co_await res.as_string(), body);
+        });
+  };
+  expect("/assets/a.txt", "a", mime::text_plain());
+  expect("/assets/sub/b.css", "b", mime::text_css());
+  expect("/assets/", "root index", mime::text_html());
+  expect("/assets/sub", "sub index", mime::text_html());
+  expect("/assets/sub/", "sub index", mime::text_html());
+  ioc.run();
+
+  CHECK(!static_files::builder((root / "a.txt").string()).build());
+  CHECK(!static_files::builder((root / "none").string()).build());
+}
+
+TEST_CASE("paths escaping the root are not found")
+{
+  const auto root = make_root();
+  const auto secret = root.parent_path() / (root.filename().string() + ".txt");
+  std::ofstream(secret, std::ios::binary) << "secret";
+#if !defined(BOOST_ASIO_WINDOWS)
+  std::filesystem::create_symlink(secret, root / "link");
+#endif
+
+  auto files = static_files::builder(root.string()).build();
+  REQUIRE(files);
+
+  auto ioc = net::io_context();
+  auto server = make_server(ioc, *files);
+
+  auto expect_not_found = [&](std::string path) {
+    server.serve_request(
+        std::move(path),
+        test_request::get().build(),
+        [](test_response res) -> awaitable<void> {
+          CHECK_EQ(res.status(), http::status::not_found);
+          CHECK_NE(co_await res.as_string(), "secret");
+        });
+  };
+  expect_not_found(
+      fmt::format("/assets/%2E%2E/{}", secret.filename().string()));
+  expect_not_found(fmt::format("/assets/sub/%2E%2E/%2E%2E/{}",
+                               secret.filename().string()));
+  expect_not_found("/assets/a.txt%00.html");
+#if defined(__linux__)
+  expect_not_found("/assets/link");
+#endif
+  ioc.run();
+}
+
+TEST_CASE("paths which are not found are remembered")
+{
+  const auto root = make_root();
+  auto files = static_files::builder(root.string())
+                   .set_negative_cache_ttl(std::chrono::hours(1))
+                   .build();
+  REQUIRE(files);
+
+  auto uncached = static_files::builder(root.string())
+                      .set_negative_cache_ttl(std::chrono::seconds(0))
+                      .build();
+  REQUIRE(uncached);
+
+  auto expect = [](static_files& files, http::status status) {
+    auto ioc = net::io_context();
+    auto server = make_server(ioc, files);
+    server.serve_request("/assets/late.txt",
+                         test_request::get().build(),
+                         [status](test_response res) -> awaitable<void> {
+                           CHECK_EQ(res.status(), status);
+                           co_return;
+                         });
+    ioc.run();
+  };
+
+  expect(*files, http::status::not_found);
+  expect(*uncached, http::status::not_found);
+  CHECK_EQ(files->negative_cache_size(), 1);
+  CHECK_EQ(uncached->negative_cache_size(), 0);
+
+  // the file is created within the ttl
+  std::ofstream(root / "late.txt", std::ios::binary) << "late";
+  expect(*files, http::status::not_found);
+  expect(*uncached, http::status::ok);
+}
+
+TEST_CASE("index file")
+{
+  const auto root = make_root();
+  auto files
+      = static_files::builder(root.string()).set_index_file("").build();
+  REQUIRE(files);
+
+  auto ioc = net::io_context();
+  auto server = make_server(ioc, *files);
+
+  server.serve_request("/assets/sub/",
+                       test_request::get().build(),
+                       [](test_response res) -> awaitable<void> {
+                         CHECK_EQ(res.status(), http::status::not_found);
+                         co_return;
+                       });
+  ioc.run();
+}
+
+#endif
+
+TEST_SUITE_END();
@@ -76,14 +76,16 @@ TEST_CASE("bytes")
                     }))
                     .build();
 
-  server.serve_request("/",
-                       test_request::get().build(),
-                       [](test_response res) -> awaitable<void> {
-                         CHECK_EQ(res.status(), http::status::ok);
-                         CHECK_EQ(res.headers().get(http::field::content_type),
-                                  mime::application_octet_stream());
-                         CHECK_EQ(co_await res.as_string(), "OK");
-                       });
+  server.serve_request(
+      "/",
+      test_request::get().build(),
+      [](test_response res) -> awaitable<void> {
+        CHECK_EQ(res.status(), http::status::ok);
+        CHECK_EQ(res.headers().get(http::field::content_type),
+                 mime::application_octet_stream());
+        CHECK_EQ(res.headers().get(http::field::content_length), "2");
+        CHECK_EQ(co_await res.as_string(), "OK");
+      });
 
   ioc.run();
 }